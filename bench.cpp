@@ -0,0 +1,852 @@
+// bench.cpp — checks and microbenchmarks for the portable pieces of the overlay.
+//   pixels   TintWhiteToPremultiplied: every available ISA is checked byte for byte against the
+//            original per-pixel loop (all 2^24 BGR inputs for a few tints, odd lengths and
+//            unaligned starts), then timed on a synthetic text frame.
+//   text     Overlay text from the glyph atlas with the built-in font: checks that a warm frame
+//            rasterizes nothing, repeats pixel for pixel and stays inside its clip, then times a
+//            cold frame, warm composition and composition + tint. --dump prints the frame.
+//   metrics  Pipeline histograms: quantiles checked against the exact sorted samples, counts
+//            against several threads recording at once, then the cost of one StageTimer sample.
+//   inflate  gzip/deflate bodies made from (or saved as) recorded responses: ratio, every body
+//            checked whole and in pieces, then inflate, CRC-32 and Deflate() throughput.
+//   frames   FramePacer on a simulated catch-up: frames drawn and peak rate per max_fps against
+//            painting on every change, and how long changes wait to be seen.
+//   core     The ingest path on synthetic Census pages (10 to 100k events, 10 to 50k attackers) and,
+//            given a folder, recorded ones: parse, streamed parse, apply, dedupe, ranking reads and
+//            the old sort-every-frame ranking, each a median per event or per call; then the heap
+//            allocations per page of a KillfeedPoll catch-up, fresh and warmed up.
+//   all      Every mode above with its defaults (inflate and core's recorded case need <dir>).
+//
+// --json FILE writes every timed number as JSON lines ({"name","value","unit"}, after a header
+// line) for "compare", which prints each result of NEW against OLD and exits 1 when one is worse
+// by more than the threshold (default 10%). Timings move a few percent between runs on an idle
+// machine; run both sides on the same one.
+//
+// Build (Linux):
+//   g++ -std=gnu++17 -O2 -Wall -Wextra -pthread pixel_kernels.cpp text_render.cpp metrics.cpp file_util.cpp inflate.cpp killfeed_core.cpp bench.cpp -o killfeed_bench
+// Usage:
+//   killfeed_bench pixels [--w N] [--h N] [--iters N]
+//   killfeed_bench text [--w N] [--h N] [--iters N] [--size N] [--rows N] [--dump]
+//   killfeed_bench metrics [--iters N]
+//   killfeed_bench inflate <dir> [--iters N]
+//   killfeed_bench frames [--pages N]
+//   killfeed_bench core [dir] [--max-events N]
+//   killfeed_bench all [dir]
+//   (each of the above also takes --json FILE)
+//   killfeed_bench compare OLD.jsonl NEW.jsonl [--threshold PCT]
+
+#include "pixel_kernels.h"
+#include "text_render.h"
+#include "metrics.h"
+#include "inflate.h"
+#include "json_scan.h"
+#include "killfeed_core.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <filesystem>
+#include <fstream>
+#include <map>
+#include <new>
+#include <string>
+#include <thread>
+#include <vector>
+
+using Clock = std::chrono::steady_clock;
+
+static double MsSince(Clock::time_point t0, Clock::time_point t1){
+    return std::chrono::duration<double, std::milli>(t1 - t0).count();
+}
+
+static uint32_t Lcg(uint32_t& s){ s = s * 1664525u + 1013904223u; return s >> 8; }
+
+// Every operator new in the process, for the allocations-per-page numbers.
+static std::atomic<uint64_t> g_allocs{0};
+[[gnu::noinline]] void* operator new(size_t n){
+    g_allocs.fetch_add(1, std::memory_order_relaxed);
+    if (void* p = std::malloc(n ? n : 1)) return p;
+    throw std::bad_alloc();
+}
+[[gnu::noinline]] void operator delete(void* p) noexcept { std::free(p); }
+[[gnu::noinline]] void operator delete(void* p, size_t) noexcept { std::free(p); }
+
+// ========================== Results ==========================
+// Every timed number is also kept here under a stable name ("core.n100000.a50000.apply"); --json FILE
+// writes them as JSON lines after the run, and "compare" lines two such files up. Units ending in
+// "/s" or "x" are better higher, the rest (times per unit of work) better lower.
+struct BenchResult { std::string name; double value; std::string unit; };
+static std::vector<BenchResult> g_results;
+
+static void Report(const std::string& name, double value, const char* unit){
+    g_results.push_back(BenchResult{name, value, unit});
+}
+
+static bool HigherIsBetter(const std::string& unit){
+    return unit == "x" || (unit.size() > 2 && unit.compare(unit.size() - 2, 2, "/s") == 0);
+}
+
+static std::string JsonEscape(const std::string& s){
+    std::string out;
+    for (char c : s){ if (c == '"' || c == '\\') out += '\\'; out += c; }
+    return out;
+}
+
+static bool WriteResults(const std::string& path, const std::string& what){
+    FILE* f = std::fopen(path.c_str(), "w");
+    if (!f){ std::fprintf(stderr, "cannot write %s\n", path.c_str()); return false; }
+    std::fprintf(f, "{\"run\":\"%s\",\"unix\":%lld,\"compiler\":\"%s\"}\n", JsonEscape(what).c_str(),
+                 (long long)std::time(nullptr), JsonEscape(__VERSION__).c_str());
+    for (const BenchResult& r : g_results)
+        std::fprintf(f, "{\"name\":\"%s\",\"value\":%.6g,\"unit\":\"%s\"}\n", JsonEscape(r.name).c_str(), r.value,
+                     JsonEscape(r.unit).c_str());
+    return std::fclose(f) == 0;
+}
+
+static bool ReadResults(const std::string& path, std::map<std::string, BenchResult>& out){
+    std::ifstream in(path);
+    if (!in) return false;
+    for (std::string line; std::getline(in, line); ){
+        BenchResult r;
+        bool hasValue = false;
+        JsonScanner sc(line);
+        for (JsonTok t = sc.Next(); t != JsonTok::End && t != JsonTok::Error; t = sc.Next()){
+            if (t != JsonTok::Key) continue;
+            const std::string key(sc.Text());
+            const JsonTok vt = sc.Next();
+            if (key == "name" && vt == JsonTok::String) r.name = std::string(sc.Text());
+            else if (key == "unit" && vt == JsonTok::String) r.unit = std::string(sc.Text());
+            else if (key == "value" && vt == JsonTok::Number){ r.value = std::atof(std::string(sc.Text()).c_str()); hasValue = true; }
+        }
+        if (!r.name.empty() && hasValue) out[r.name] = r;
+    }
+    return true;
+}
+
+// Side by side, with the change in percent (positive = better); anything worse than threshold
+// percent is marked and makes the exit code 1.
+static int RunCompare(const std::string& oldPath, const std::string& newPath, double threshold){
+    std::map<std::string, BenchResult> a, b;
+    if (!ReadResults(oldPath, a) || !ReadResults(newPath, b)){ std::fprintf(stderr, "cannot read %s or %s\n", oldPath.c_str(), newPath.c_str()); return 2; }
+    int worse = 0;
+    for (const auto& kv : b){
+        auto it = a.find(kv.first);
+        if (it == a.end() || it->second.unit != kv.second.unit || it->second.value <= 0 || kv.second.value <= 0){
+            std::printf("%-44s %12s %12.4g %-10s new\n", kv.first.c_str(), "-", kv.second.value, kv.second.unit.c_str());
+            continue;
+        }
+        const double ratio = HigherIsBetter(kv.second.unit) ? kv.second.value / it->second.value : it->second.value / kv.second.value;
+        const double change = (ratio - 1) * 100;
+        const bool bad = change < -threshold;
+        worse += bad;
+        std::printf("%-44s %12.4g %12.4g %-10s %+7.1f%%%s\n", kv.first.c_str(), it->second.value, kv.second.value,
+                    kv.second.unit.c_str(), change, bad ? "  WORSE" : "");
+    }
+    for (const auto& kv : a)
+        if (!b.count(kv.first)) std::printf("%-44s %12.4g %12s %-10s gone\n", kv.first.c_str(), kv.second.value, "-", kv.second.unit.c_str());
+    std::printf("%d of %zu worse by more than %.0f%%\n", worse, b.size(), threshold);
+    return worse ? 1 : 0;
+}
+
+// ========================== pixels ==========================
+// The loop RepaintLayered used to run, kept verbatim as the reference.
+static void TintReference(uint32_t* px, size_t n, unsigned cR, unsigned cG, unsigned cB){
+    unsigned char* p = (unsigned char*)px;
+    for (size_t i=0;i<n;++i){
+        unsigned char B = p[0], G = p[1], R = p[2];
+        unsigned char A = (R>G?R:G); if (B>A) A = B; // A = max(R,G,B)
+        p[2] = (unsigned char)((cR * A + 127) / 255); // R premultiplied
+        p[1] = (unsigned char)((cG * A + 127) / 255); // G
+        p[0] = (unsigned char)((cB * A + 127) / 255); // B
+        p[3] = A;                                     // A
+        p += 4;
+    }
+}
+
+// White-on-black "text": a few lines of glyph-sized cells with solid stems and antialiased edges,
+// the rest of the window cleared to zero, like the overlay's backbuffer after DrawTextW.
+static std::vector<uint32_t> TextFrame(int W, int H){
+    std::vector<uint32_t> f((size_t)W * H, 0);
+    uint32_t s = 12345;
+    const int lineH = 19, glyphW = 7;
+    for (int line = 0; line < 5; ++line){
+        int top = 6 + line * (lineH + 2), chars = 20 + (int)(Lcg(s) % 30);
+        for (int c = 0; c < chars; ++c){
+            int x0 = 8 + c * glyphW;
+            if (x0 + glyphW > W || top + lineH > H) break;
+            if (Lcg(s) % 6 == 0) continue;                       // space
+            for (int y = top + 3; y < top + lineH - 4; ++y)
+                for (int x = x0; x < x0 + glyphW - 1; ++x){
+                    uint32_t k = Lcg(s) % 10;
+                    if (k < 6) continue;
+                    uint32_t a = (k < 8) ? 255 : Lcg(s) % 256;        // stems and edges
+                    f[(size_t)y * W + x] = a | a << 8 | a << 16;      // GDI leaves the alpha byte 0
+                }
+        }
+    }
+    return f;
+}
+
+static bool VerifyIsa(PixelIsa isa){
+    const uint8_t tints[][3] = {{0,0,0}, {255,255,255}, {255,128,7}, {13,200,99}};
+    uint32_t s = 777;
+    // Every BGR combination; alpha byte scrambled since the kernel must ignore it.
+    std::vector<uint32_t> in(1u << 24), want, got;
+    for (uint32_t v = 0; v < in.size(); ++v) in[v] = v | (v ? (Lcg(s) & 0xFFu) << 24 : 0);
+    for (const auto& t : tints){
+        want = in; TintReference(want.data(), want.size(), t[0], t[1], t[2]);
+        got  = in; TintWhiteToPremultipliedWith(isa, got.data(), got.size(), t[0], t[1], t[2]);
+        if (want != got){ std::printf("pixels   %-6s MISMATCH (exhaustive, tint %u,%u,%u)\n", PixelIsaName(isa), t[0], t[1], t[2]); return false; }
+    }
+    // Short and unaligned runs through the tails.
+    std::vector<uint32_t> frame = TextFrame(64, 64);
+    for (size_t off = 0; off < 4; ++off)
+        for (size_t n = 0; n < 70; ++n){
+            std::vector<uint32_t> a(frame.begin() + 600 + off, frame.begin() + 600 + off + n);
+            std::vector<uint32_t> b(n + 1);
+            std::copy(a.begin(), a.end(), b.begin() + 1);
+            TintReference(a.data(), n, 255, 128, 7);
+            TintWhiteToPremultipliedWith(isa, b.data() + 1, n, 255, 128, 7);
+            if (!std::equal(a.begin(), a.end(), b.begin() + 1)){
+                std::printf("pixels   %-6s MISMATCH (n=%zu off=%zu)\n", PixelIsaName(isa), n, off); return false;
+            }
+        }
+    std::printf("pixels   %-6s bit-exact OK\n", PixelIsaName(isa));
+    return true;
+}
+
+static int RunPixels(int W, int H, int iters){
+    const PixelIsa all[] = {PixelIsa::Scalar, PixelIsa::SSE2, PixelIsa::AVX2};
+    bool ok = true;
+    for (PixelIsa isa : all){
+        if (!PixelIsaSupported(isa)){ std::printf("pixels   %-6s not supported here\n", PixelIsaName(isa)); continue; }
+        ok = VerifyIsa(isa) && ok;
+    }
+
+    const std::vector<uint32_t> frame = TextFrame(W, H);
+    size_t lit = (size_t)std::count_if(frame.begin(), frame.end(), [](uint32_t v){ return v != 0; });
+    std::printf("frame    %dx%d, %.1f%% text pixels, %d iterations, runtime pick: %s\n",
+                W, H, 100.0 * lit / frame.size(), iters, PixelIsaName(BestPixelIsa()));
+
+    std::vector<uint32_t> work(frame.size());
+    auto timeIt = [&](auto&& kernel){
+        double ms = 0;
+        for (int i = 0; i < iters; ++i){
+            std::memcpy(work.data(), frame.data(), frame.size() * 4);
+            auto t0 = Clock::now();
+            kernel();
+            ms += MsSince(t0, Clock::now());
+        }
+        return ms / iters;
+    };
+    double ref = timeIt([&]{ TintReference(work.data(), work.size(), 255, 128, 7); });
+    std::printf("%-14s %9.1f us/frame  %8.1f Mpix/s\n", "reference", ref * 1e3, frame.size() / (ref * 1e3));
+    Report("pixels.reference", ref * 1e3, "us/frame");
+    for (PixelIsa isa : all){
+        if (!PixelIsaSupported(isa)) continue;
+        double ms = timeIt([&]{ TintWhiteToPremultipliedWith(isa, work.data(), work.size(), 255, 128, 7); });
+        std::printf("%-14s %9.1f us/frame  %8.1f Mpix/s  x%.1f\n", PixelIsaName(isa), ms * 1e3,
+                    frame.size() / (ms * 1e3), ref / ms);
+        Report(std::string("pixels.") + PixelIsaName(isa), ms * 1e3, "us/frame");
+    }
+    return ok ? 0 : 1;
+}
+
+// ========================== text ==========================
+static DisplaySnapshot SampleSnapshot(int rows){
+    DisplaySnapshot s;
+    s.status = L"Tracking Sealobster (5428713425545165425)";
+    s.line   = L"Killed by: xXNightmareReaperXx [HS]  (4/9)";
+    const wchar_t* names[] = {L"xXNightmareReaperXx", L"TRbattleBus", L"VSmaxCrash", L"Wrel", L"NCgalaxyPilot",
+                              L"SunderDriver", L"LibAnnihilator", L"Flashrider", L"BastionGunner", L"HeavyHeavy"};
+    for (int i = 0; i < rows; ++i)
+        s.rows.push_back(DisplayRow{names[i % 10], Counters{rows - i, 3 * (rows - i) + 1}});
+    return s;
+}
+
+static int RunText(int W, int H, int iters, int size, int rows, bool dump){
+    const int left = 8, top = 6, right = W - 8;
+    const DisplaySnapshot snap = SampleSnapshot(rows);
+    BuiltinGlyphSource font(TextPixelHeight(size));
+    GlyphAtlas atlas;
+    std::vector<uint32_t> frame((size_t)W * H), again((size_t)W * H);
+    bool ok = true;
+
+    auto compose = [&](std::vector<uint32_t>& f){
+        std::memset(f.data(), 0, f.size() * 4);
+        ComposeOverlayText(atlas, snap, f.data(), W, H, left, top, right, atlas.Height() + 6);
+    };
+
+    auto t0 = Clock::now();
+    atlas.Reset(&font);
+    compose(frame);
+    double coldMs = MsSince(t0, Clock::now());
+    const uint64_t coldGlyphs = atlas.rasterized;
+
+    compose(again);
+    if (atlas.rasterized != coldGlyphs){ std::printf("text     MISMATCH: warm frame rasterized %llu glyphs\n",
+                                                     (unsigned long long)(atlas.rasterized - coldGlyphs)); ok = false; }
+    if (frame != again){ std::printf("text     MISMATCH: warm frame differs from the cold one\n"); ok = false; }
+    size_t lit = 0, outside = 0;
+    for (int y = 0; y < H; ++y)
+        for (int x = 0; x < W; ++x){
+            if (!frame[(size_t)y * W + x]) continue;
+            ++lit;
+            if (x < left || x >= right || y < top) ++outside;
+        }
+    if (!lit){ std::printf("text     MISMATCH: nothing drawn\n"); ok = false; }
+    if (outside){ std::printf("text     MISMATCH: %zu pixels outside the text rectangle\n", outside); ok = false; }
+    if (ok) std::printf("text     steady state OK (%zu glyphs, %zu byte atlas, %zu lit pixels)\n",
+                        atlas.Glyphs(), atlas.AtlasBytes(), lit);
+
+    if (dump)
+        for (int y = 0; y < H; ++y){
+            std::string row;
+            for (int x = 0; x < W; ++x) row += frame[(size_t)y * W + x] ? '#' : '.';
+            while (!row.empty() && row.back() == '.') row.pop_back();
+            std::printf("%s\n", row.c_str());
+        }
+
+    std::printf("frame    %dx%d, window_size %d (%d px cell), %d rows, %d iterations\n",
+                W, H, size, atlas.Height(), rows, iters);
+    double composeMs = 0, fullMs = 0;
+    for (int i = 0; i < iters; ++i){
+        auto a = Clock::now();
+        compose(again);
+        auto b = Clock::now();
+        TintWhiteToPremultiplied(again.data(), again.size(), 255, 128, 7);
+        auto c = Clock::now();
+        composeMs += MsSince(a, b);
+        fullMs    += MsSince(a, c);
+    }
+    std::printf("%-14s %9.1f us/frame\n", "cold", coldMs * 1e3);
+    std::printf("%-14s %9.1f us/frame\n", "compose", composeMs * 1e3 / iters);
+    std::printf("%-14s %9.1f us/frame\n", "compose+tint", fullMs * 1e3 / iters);
+    Report("text.cold", coldMs * 1e3, "us/frame");
+    Report("text.compose", composeMs * 1e3 / iters, "us/frame");
+    Report("text.compose_tint", fullMs * 1e3 / iters, "us/frame");
+    return ok ? 0 : 1;
+}
+
+// ========================== metrics ==========================
+static int RunMetrics(int iters){
+    bool ok = true;
+
+    // Latencies spread over 1 us .. ~5 s, log-uniform, like fetches and parses mixed together.
+    std::vector<uint64_t> samples(200000);
+    uint32_t s = 777;
+    for (uint64_t& v : samples) v = (uint64_t)std::exp((Lcg(s) % 1000000) / 1e6 * 15.4);
+    Metrics m;
+    for (size_t i = 0; i < samples.size() / 2; ++i) m.Record(Stage::Fetch, samples[i]);
+    MetricsSnapshot half; m.Take(half);
+    for (size_t i = samples.size() / 2; i < samples.size(); ++i) m.Record(Stage::Fetch, samples[i]);
+    MetricsSnapshot all; m.Take(all);
+
+    auto check = [&](const HistogramCounts& h, std::vector<uint64_t> exact, const char* what){
+        std::sort(exact.begin(), exact.end());
+        if (h.count != exact.size()){ std::printf("metrics  MISMATCH: %s count %llu, want %zu\n", what,
+                                                  (unsigned long long)h.count, exact.size()); ok = false; }
+        for (double q : {0.5, 0.9, 0.99, 0.999}){
+            const double want = (double)exact[(size_t)std::ceil(q * exact.size()) - 1];
+            const double got  = (double)h.Quantile(q);
+            const double err  = std::fabs(got - want) / want;
+            std::printf("%-8s p%-5g exact %10.0f us  histogram %10.0f us  error %5.2f%%\n", what, q * 100, want, got, err * 100);
+            if (err > 0.0625 && std::fabs(got - want) > 1){ std::printf("metrics  MISMATCH: error over 6.25%%\n"); ok = false; }
+        }
+    };
+    check(all[Stage::Fetch], samples, "all");
+    check(all.Since(half)[Stage::Fetch], std::vector<uint64_t>(samples.begin() + samples.size() / 2, samples.end()), "2nd half");
+
+    // Concurrent writers lose nothing.
+    Metrics shared;
+    const int threads = 4, each = 250000;
+    std::vector<std::thread> pool;
+    for (int t = 0; t < threads; ++t) pool.emplace_back([&, t]{
+        for (int i = 0; i < each; ++i){ shared.Record(Stage::Parse, (uint64_t)(i % 5000 + t)); shared.Add(Counter::Events); }
+    });
+    for (std::thread& t : pool) t.join();
+    MetricsSnapshot c; shared.Take(c);
+    uint64_t inBuckets = 0;
+    for (uint64_t n : c[Stage::Parse].n) inBuckets += n;
+    if (c[Stage::Parse].count != (uint64_t)threads * each || inBuckets != c[Stage::Parse].count ||
+        c[Counter::Events] != (uint64_t)threads * each){
+        std::printf("metrics  MISMATCH: %d threads x %d samples, got %llu (%llu in buckets)\n", threads, each,
+                    (unsigned long long)c[Stage::Parse].count, (unsigned long long)inBuckets);
+        ok = false;
+    } else std::printf("threads  %d x %d samples, none lost\n", threads, each);
+
+    // What a hook costs: one StageTimer (two clock reads + Record), one counter add.
+    const int n = iters * 5000;
+    auto t0 = Clock::now();
+    for (int i = 0; i < n; ++i){ StageTimer t(Stage::Apply); }
+    auto t1 = Clock::now();
+    for (int i = 0; i < n; ++i) PipelineMetrics().Add(Counter::Events);
+    auto t2 = Clock::now();
+    std::printf("%-14s %9.1f ns/sample\n", "StageTimer", MsSince(t0, t1) * 1e6 / n);
+    std::printf("%-14s %9.1f ns/add\n", "Add", MsSince(t1, t2) * 1e6 / n);
+    Report("metrics.stage_timer", MsSince(t0, t1) * 1e6 / n, "ns/sample");
+    Report("metrics.add", MsSince(t1, t2) * 1e6 / n, "ns/add");
+    return ok ? 0 : 1;
+}
+
+// ========================== inflate ==========================
+// Recorded responses from dir: files saved compressed (gzip/zlib, as sent) are used as they are,
+// plain ones are compressed with Deflate(). Every body must inflate back exactly, whole and fed in
+// random pieces (the first one also a byte at a time); a cut or damaged body must not pass.
+static bool ReadFile(const std::string& path, std::string& out){
+    FILE* f = std::fopen(path.c_str(), "rb");
+    if (!f) return false;
+    char buf[65536];
+    size_t n;
+    out.clear();
+    while ((n = std::fread(buf, 1, sizeof(buf), f)) > 0) out.append(buf, n);
+    std::fclose(f);
+    return true;
+}
+
+static ContentCoding CodingOf(const std::string& b){
+    return b.size() >= 2 && (uint8_t)b[0] == 0x1f && (uint8_t)b[1] == 0x8b ? ContentCoding::Gzip : ContentCoding::Deflate;
+}
+
+static int RunInflate(const std::string& dir, int iters){
+    std::vector<std::string> files;
+    std::error_code ec;
+    for (const auto& de : std::filesystem::directory_iterator(dir, ec))
+        if (de.is_regular_file()) files.push_back(de.path().string());
+    if (ec || files.empty()){ std::fprintf(stderr, "no files in %s\n", dir.c_str()); return 1; }
+    std::sort(files.begin(), files.end());
+
+    std::vector<std::string> plain, packed;
+    size_t plainBytes = 0, packedBytes = 0, asSent = 0;
+    for (const std::string& f : files){
+        std::string b, p;
+        if (!ReadFile(f, b)){ std::fprintf(stderr, "cannot read %s\n", f.c_str()); return 1; }
+        if (InflateAll(b, p)){ ++asSent; plain.push_back(std::move(p)); packed.push_back(std::move(b)); }
+        else { packed.push_back(Deflate(b)); plain.push_back(std::move(b)); }
+        plainBytes += plain.back().size(); packedBytes += packed.back().size();
+    }
+    std::printf("bodies   %zu (%zu saved compressed), %zu bytes -> %zu on the wire (%.1fx)\n", plain.size(), asSent,
+                plainBytes, packedBytes, packedBytes ? (double)plainBytes / packedBytes : 0.0);
+
+    bool ok = true;
+    uint32_t s = 1919;
+    for (size_t i = 0; i < plain.size(); ++i){
+        std::string out;
+        bool good = InflateAll(packed[i], out) && out == plain[i];
+        for (int r = 0; r < (i ? 2 : 3); ++r){
+            Inflater inf(CodingOf(packed[i]));
+            std::string streamed;
+            for (size_t at = 0; at < packed[i].size(); ){
+                const size_t n = std::min(packed[i].size() - at, r == 2 ? (size_t)1 : (size_t)(Lcg(s) % 16384) + 1);
+                inf.Feed(packed[i].data() + at, n, [&](const char* p, size_t k){ streamed.append(p, k); });
+                at += n;
+            }
+            good = good && inf.Done() && streamed == plain[i];
+        }
+        std::string cut;
+        good = good && !InflateAll(std::string_view(packed[i]).substr(0, packed[i].size() - 1), cut);
+        std::string bad = packed[i];
+        bad[bad.size() / 2] ^= 0x20;
+        good = good && (!InflateAll(bad, cut) || cut != plain[i]);
+        if (!good){ std::printf("inflate  MISMATCH: %s\n", files[i].c_str()); ok = false; }
+    }
+    if (ok) std::printf("checked  whole, random pieces, byte at a time; cut and damaged bodies refused\n");
+
+    const int passes = std::max(1, iters / 40);
+    size_t out = 0;
+    auto t0 = Clock::now();
+    for (int r = 0; r < passes; ++r)
+        for (const std::string& b : packed){
+            Inflater inf(CodingOf(b));
+            for (size_t at = 0; at < b.size(); at += 16384)
+                inf.Feed(b.data() + at, std::min<size_t>(16384, b.size() - at), [&](const char*, size_t k){ out += k; });
+        }
+    auto t1 = Clock::now();
+    uint32_t crc = 0;
+    for (int r = 0; r < passes; ++r) for (const std::string& b : plain) crc = Crc32(b.data(), b.size(), crc);
+    auto t2 = Clock::now();
+    size_t deflated = 0;
+    for (int r = 0; r < passes; ++r) for (const std::string& b : plain) deflated += Deflate(b).size();
+    auto t3 = Clock::now();
+    const double mb = plainBytes / 1e6 * passes;
+    std::printf("%-14s %8.1f MB/s out (%.1f MB/s in, 16 KB reads)\n", "inflate", mb / (MsSince(t0, t1) / 1e3),
+                packedBytes / 1e6 * passes / (MsSince(t0, t1) / 1e3));
+    std::printf("%-14s %8.1f MB/s  (crc %08x; part of inflating gzip)\n", "crc32", mb / (MsSince(t1, t2) / 1e3), crc);
+    std::printf("%-14s %8.1f MB/s  (stand-in side, %zu bytes)\n", "deflate", mb / (MsSince(t2, t3) / 1e3), deflated / passes);
+    Report("inflate.inflate", mb / (MsSince(t0, t1) / 1e3), "MB/s");
+    Report("inflate.crc32", mb / (MsSince(t1, t2) / 1e3), "MB/s");
+    Report("inflate.deflate", mb / (MsSince(t2, t3) / 1e3), "MB/s");
+    if (out != plainBytes * (size_t)passes){ std::printf("inflate  MISMATCH: %zu bytes out\n", out); ok = false; }
+    return ok ? 0 : 1;
+}
+
+// ========================== frames ==========================
+// The UI thread's side of a catch-up, in virtual time: the ingest thread publishes a snapshot per
+// page plus a status change before and names after (1-4 ms apart), the HUD ticks once a second,
+// then a quiet minute of one-change polls; three such bursts. Every change is a repaint request.
+// The message loop takes what is queued, draws at most one frame (2 ms) and sleeps until the next
+// message or the frame timer. Run for several max_fps against painting on every change, as the
+// overlay used to: frames, peak frames per second, and how long a change waited to be seen.
+static int RunFrames(int pages){
+    std::vector<uint64_t> msgs;     // us
+    uint32_t s = 2323;
+    uint64_t t = 0;
+    for (int burst = 0; burst < 3; ++burst){
+        for (int p = 0; p < pages * 3; ++p){ t += 1000 + Lcg(s) % 3000; msgs.push_back(t); }
+        for (int q = 0; q < 60; ++q){ t += 1000000; msgs.push_back(t); }
+    }
+    for (uint64_t hud = 1000000; hud < t; hud += 1000000) msgs.push_back(hud);
+    std::sort(msgs.begin(), msgs.end());
+
+    const uint64_t paintUs = 2000;
+    auto peakPerSecond = [](const std::vector<uint64_t>& at){
+        size_t peak = 0;
+        for (size_t i = 0, j = 0; i < at.size(); ++i){
+            while (at[i] - at[j] >= 1000000) ++j;
+            peak = std::max(peak, i - j + 1);
+        }
+        return peak;
+    };
+    std::printf("%-12s %6zu changes over %.0f s, %d-page bursts, %llu us per frame\n", "timeline", msgs.size(), t / 1e6,
+                pages, (unsigned long long)paintUs);
+
+    // Painting on every change: each one is a frame, and a change waits for the paints queued before it.
+    {
+        std::vector<uint64_t> drawn;
+        uint64_t now = 0, waitMax = 0, waitSum = 0;
+        for (uint64_t m : msgs){
+            now = std::max(now, m) + paintUs;
+            drawn.push_back(now);
+            waitMax = std::max(waitMax, now - m); waitSum += now - m;
+        }
+        std::printf("%-12s frames %6zu  peak %4zu/s  wait mean %6.1f ms  max %6.1f ms\n", "every change",
+                    drawn.size(), peakPerSecond(drawn), waitSum / 1e3 / msgs.size(), waitMax / 1e3);
+    }
+
+    bool ok = true;
+    for (int fps : {0, 60, 30, 10}){
+        FramePacer pacer(fps);
+        std::vector<uint64_t> drawn;
+        uint64_t now = 0, timerAt = UINT64_MAX, waitMax = 0, waitSum = 0;
+        size_t next = 0, shown = 0;
+        while (next < msgs.size() || pacer.Dirty()){
+            const uint64_t wake = std::min(next < msgs.size() ? msgs[next] : UINT64_MAX, timerAt);
+            now = std::max(now, wake);
+            timerAt = UINT64_MAX;
+            while (next < msgs.size() && msgs[next] <= now){ pacer.Request(); ++next; }
+            uint64_t waitUs = 0;
+            if (pacer.Due(now, &waitUs)){
+                now += paintUs;
+                pacer.Drawn(now);
+                drawn.push_back(now);
+                for (; shown < next; ++shown){ waitMax = std::max(waitMax, now - msgs[shown]); waitSum += now - msgs[shown]; }
+            } else if (pacer.Dirty()) timerAt = now + std::max<uint64_t>(waitUs, 10000);   // USER_TIMER_MINIMUM
+        }
+        const size_t peak = peakPerSecond(drawn);
+        char label[32];
+        std::snprintf(label, sizeof(label), fps ? "max_fps %d" : "no cap", fps);
+        std::printf("%-12s frames %6zu  peak %4zu/s  wait mean %6.1f ms  max %6.1f ms  (coalesced %llu, held %llu)\n", label,
+                    drawn.size(), peak, waitSum / 1e3 / msgs.size(), waitMax / 1e3,
+                    (unsigned long long)pacer.Coalesced(), (unsigned long long)pacer.Held());
+        Report("frames.fps" + std::to_string(fps), (double)drawn.size(), "frames");
+        if ((fps && peak > (size_t)fps + 1) || shown != msgs.size() || pacer.Frames() + pacer.Coalesced() < msgs.size()){
+            std::printf("frames   MISMATCH: %s\n", label);
+            ok = false;
+        }
+    }
+    return ok ? 0 : 1;
+}
+
+// ========================== core ==========================
+// The ingest path on Census death pages, per case: ParseDeathBatch, the streaming DeathBatchParser
+// (16 KB pieces), ApplyDeathEvent into a fresh state (and with the two rolling windows on), the
+// same pages applied again (every event a duplicate: the dedupe path, by event_id and by synthetic
+// key), then reading the top rows: RankNemeses, BuildSnapshot, a window's Top, and what the paint
+// code did per frame before the ranking was kept up to date (every attacker copied out, sorted).
+// Synthetic cases have n events over about a attackers, half of the deaths going to a tenth of
+// them (regulars), in pages of 1000 like the API's; with a folder the recorded pages are one more case.
+struct CoreCase {
+    std::string label;
+    size_t bytes = 0, events = 0;
+    std::vector<std::string> bodies;
+};
+
+static CoreCase SyntheticCase(size_t n, size_t a, uint32_t seed, unsigned long long ts = 1700000000,
+                              unsigned long long eventId = 900000000){
+    CoreCase c;
+    c.label = "n" + std::to_string(n) + ".a" + std::to_string(a);
+    uint32_t s = seed;
+    char buf[640];
+    for (size_t done = 0; done < n; ){
+        const size_t k = std::min<size_t>(1000, n - done);
+        std::string b = "{\"characters_event_list\": [";
+        for (size_t i = 0; i < k; ++i){
+            const size_t regulars = std::max<size_t>(1, a / 10);
+            const size_t who = (Lcg(s) & 1) ? Lcg(s) % regulars : Lcg(s) % a;
+            ts += Lcg(s) % 13;
+            const int len = std::snprintf(buf, sizeof(buf),
+                "%s{\"character_id\": \"5428010618015189713\", \"attacker_character_id\": \"%llu\", \"attacker_fire_mode_id\": \"7\", "
+                "\"attacker_loadout_id\": \"17\", \"attacker_vehicle_id\": \"0\", \"attacker_weapon_id\": \"80\", \"character_loadout_id\": \"3\", "
+                "\"is_headshot\": \"%d\", \"timestamp\": \"%llu\", \"world_id\": \"17\", \"zone_id\": \"2\", \"table_type\": \"deaths\", "
+                "\"event_id\": \"%llu\", \"attacker\": {\"name\": {\"first\": \"Enemy%zu\", \"first_lower\": \"enemy%zu\"}}}",
+                i ? ", " : "", 5428000000000000000ull + who * 7919, (int)(Lcg(s) % 10 < 3), ts, ++eventId, who, who);
+            b.append(buf, (size_t)len);
+        }
+        b += "], \"returned\": " + std::to_string(k) + "}";
+        c.bytes += b.size();
+        c.bodies.push_back(std::move(b));
+        done += k;
+    }
+    c.events = n;
+    return c;
+}
+
+// Median over samples of the time for one run of work (ns), work run often enough per sample
+// to take a measurable while; setup (untimed) gets how many runs are coming.
+template<typename Setup, typename Work>
+static double MedianNs(size_t unitsPerRun, Setup&& setup, Work&& work){
+    const size_t inner = std::max<size_t>(1, 20000 / std::max<size_t>(1, unitsPerRun));
+    const int samples = unitsPerRun >= 50000 ? 5 : 11;
+    std::vector<double> ns;
+    for (int r = 0; r < samples; ++r){
+        setup(inner);
+        auto t0 = Clock::now();
+        for (size_t i = 0; i < inner; ++i) work(i);
+        ns.push_back(MsSince(t0, Clock::now()) * 1e6 / inner);
+    }
+    std::sort(ns.begin(), ns.end());
+    return ns[ns.size() / 2];
+}
+
+// The per-frame ranking the overlay started with: every attacker copied out, sorted on deaths,
+// headshots and display name, top rows taken.
+static size_t TopBySortReference(const KillfeedState& st, size_t rows){
+    struct Row { uint64_t id; Counters cnt; };
+    std::vector<Row> entries; entries.reserve(st.counts.size());
+    st.counts.ForEach([&](uint64_t id, const AttackerSlot& a){
+        if (id == 0 && st.skipEnvironment) return;
+        if (a.cnt.tot > 0) entries.push_back(Row{id, a.cnt});
+    });
+    std::sort(entries.begin(), entries.end(), [&](const Row& A, const Row& B){
+        if (A.cnt.tot != B.cnt.tot) return A.cnt.tot > B.cnt.tot;
+        if (A.cnt.hs  != B.cnt.hs)  return A.cnt.hs  > B.cnt.hs;
+        return GetNameFor(st, A.id) < GetNameFor(st, B.id);
+    });
+    return std::min(rows, entries.size());
+}
+
+// Allocations of KillfeedPoll catching up on pages served from memory (streamed in 16 KB pieces,
+// every name cached, so no lookups), per page: on a fresh state, whose tables grow with every new
+// attacker, then on the next batch of deaths by the same attackers (a warmed-up session).
+struct PollAllocs { double fresh = 0, warm = 0; size_t pages = 0; };
+static PollAllocs CountPollAllocs(size_t n, size_t a, uint32_t seed){
+    const CoreCase first = SyntheticCase(n, a, seed, 1700000000, 900000000);
+    const CoreCase next  = SyntheticCase(n, a, seed, 1700000000 + 13 * n, 900000000 + n);
+    NameCache names(a + 1);
+    for (size_t who = 0; who < a; ++who) names.Put(5428000000000000000ull + who * 7919, "Enemy" + std::to_string(who));
+    KillfeedState st;
+    st.serviceId = L"s:example";
+    st.characterId = L"5428010618015189713";
+    st.nameCache = &names;
+    st.lastDeathTs = 1699999999;   // not the first poll: no peek
+    const CoreCase* serving = &first;
+    const ChunkFetchFn pages = [&](const std::wstring& path, const ChunkSink& sink){
+        const size_t at = path.find(L"c:start=");
+        const size_t k = at == std::wstring::npos ? 0 : std::wcstoul(path.c_str() + at + 8, nullptr, 10) / 1000;
+        if (k >= serving->bodies.size()) return false;
+        const std::string& b = serving->bodies[k];
+        for (size_t off = 0; off < b.size(); off += 16384) sink(b.data() + off, std::min<size_t>(16384, b.size() - off));
+        return true;
+    };
+    const FetchFn noFetch = [](const std::wstring&){ return std::string(); };
+    PollAllocs r;
+    r.pages = first.bodies.size();
+    uint64_t before = g_allocs.load();
+    KillfeedPoll(st, noFetch, nullptr, nullptr, pages);
+    r.fresh = (double)(g_allocs.load() - before) / r.pages;
+    serving = &next;
+    before = g_allocs.load();
+    KillfeedPoll(st, noFetch, nullptr, nullptr, pages);
+    r.warm = (double)(g_allocs.load() - before) / r.pages;
+    return r;
+}
+
+static bool RunCoreCase(const CoreCase& c){
+    std::vector<std::vector<DeathEvent>> pages;
+    for (const std::string& b : c.bodies) pages.push_back(ParseDeathBatch(b));
+    size_t events = 0;
+    for (const auto& p : pages) events += p.size();
+    if (!events){ std::printf("core     %s: no events\n", c.label.c_str()); return false; }
+    const double perEvent = 1.0 / (double)events;
+
+    const double parse = MedianNs(events, [](size_t){}, [&](size_t){
+        size_t n = 0;
+        for (const std::string& b : c.bodies) n += ParseDeathBatch(b).size();
+        if (n != events) std::abort();
+    }) * perEvent;
+    const double stream = MedianNs(events, [](size_t){}, [&](size_t){
+        for (const std::string& b : c.bodies){
+            DeathBatchParser p;
+            for (size_t at = 0; at < b.size(); at += 16384) p.Feed(b.data() + at, std::min<size_t>(16384, b.size() - at));
+        }
+    }) * perEvent;
+
+    auto applyAll = [&](KillfeedState& st){
+        for (const auto& p : pages){
+            for (const DeathEvent& e : p) ApplyDeathEvent(st, e);
+            SettleDedupe(st);
+        }
+    };
+    std::vector<KillfeedState> fresh;
+    auto freshStates = [&](bool windows){
+        return [&, windows](size_t inner){
+            fresh.clear();
+            fresh.resize(inner);
+            if (windows) for (KillfeedState& st : fresh){ st.windows.emplace_back(600); st.windows.emplace_back(1800); }
+        };
+    };
+    const double apply   = MedianNs(events, freshStates(false), [&](size_t i){ applyAll(fresh[i]); }) * perEvent;
+    const double applyW  = MedianNs(events, freshStates(true),  [&](size_t i){ applyAll(fresh[i]); }) * perEvent;
+    fresh.clear();
+
+    KillfeedState st;
+    st.windows.emplace_back(1800);
+    applyAll(st);
+    KillfeedState synth;
+    synth.keyBySynth = true;
+    applyAll(synth);
+    size_t again = 0;
+    const double dedupe      = MedianNs(events, [](size_t){}, [&](size_t){ for (const auto& p : pages) for (const DeathEvent& e : p) again += ApplyDeathEvent(st, e); }) * perEvent;
+    const double dedupeSynth = MedianNs(events, [](size_t){}, [&](size_t){ for (const auto& p : pages) for (const DeathEvent& e : p) again += ApplyDeathEvent(synth, e); }) * perEvent;
+
+    const size_t rows = 10;
+    size_t sink = 0;
+    const double rank   = MedianNs(1, [](size_t){}, [&](size_t){ sink += RankNemeses(st, rows).size(); });
+    const double snap   = MedianNs(1, [](size_t){}, [&](size_t){ sink += BuildSnapshot(st, rows)->rows.size(); });
+    const double window = MedianNs(1, [](size_t){}, [&](size_t){ sink += RankView(st, 0, rows).size(); });
+    const double sortRef = MedianNs(st.counts.size(), [](size_t){}, [&](size_t){ sink += TopBySortReference(st, rows); });
+
+    std::printf("%-16s %7zu %6zu %9.1f %8.1f %8.1f %8.1f %8.1f %8.1f %9.0f %9.0f %9.0f %11.0f\n", c.label.c_str(),
+                events, st.counts.size(), c.bytes / (double)events, parse, stream, apply, applyW, dedupe, rank, snap, window, sortRef);
+    const std::string k = "core." + c.label + ".";
+    Report(k + "parse", parse, "ns/event");
+    Report(k + "parse_stream", stream, "ns/event");
+    Report(k + "apply", apply, "ns/event");
+    Report(k + "apply_windows", applyW, "ns/event");
+    Report(k + "dedupe", dedupe, "ns/event");
+    Report(k + "dedupe_synth", dedupeSynth, "ns/event");
+    Report(k + "rank10", rank, "ns/call");
+    Report(k + "snapshot10", snap, "ns/call");
+    Report(k + "window_top10", window, "ns/call");
+    Report(k + "sort_reference_top10", sortRef, "ns/call");
+    // Applying everything a second time must not count anything.
+    if (again){ std::printf("core     MISMATCH: %s: %zu duplicates counted\n", c.label.c_str(), again); return false; }
+    return sink > 0;
+}
+
+static int RunCore(const std::string& dir, size_t maxEvents){
+    std::printf("%-16s %7s %6s %9s %8s %8s %8s %8s %8s %9s %9s %9s %11s\n", "case", "events", "attk", "B/event",
+                "parse", "stream", "apply", "+windows", "dedupe", "rank10", "snapshot", "window", "sort-ref");
+    std::printf("%-16s %7s %6s %9s %8s %8s %8s %8s %8s %9s %9s %9s %11s\n", "", "", "", "",
+                "ns/ev", "ns/ev", "ns/ev", "ns/ev", "ns/ev", "ns", "ns", "ns", "ns");
+    const size_t cases[][2] = {
+        {10, 10}, {100, 10}, {100, 100}, {1000, 10}, {1000, 1000}, {10000, 10}, {10000, 1000}, {10000, 10000},
+        {100000, 10}, {100000, 1000}, {100000, 50000},
+    };
+    bool ok = true;
+    uint32_t seed = 4711;
+    for (const auto& nc : cases){
+        if (nc[0] > maxEvents) continue;
+        ok = RunCoreCase(SyntheticCase(nc[0], nc[1], seed++)) && ok;
+    }
+    if (!dir.empty()){
+        CoreCase rec;
+        rec.label = "recorded";
+        std::vector<std::string> files;
+        std::error_code ec;
+        for (const auto& de : std::filesystem::directory_iterator(dir, ec))
+            if (de.is_regular_file()) files.push_back(de.path().string());
+        std::sort(files.begin(), files.end());
+        for (const std::string& f : files){
+            std::string b, plain;
+            if (!ReadFile(f, b)){ std::fprintf(stderr, "cannot read %s\n", f.c_str()); return 1; }
+            if (InflateAll(b, plain)) b.swap(plain);   // saved as sent, compressed
+            rec.bytes += b.size();
+            rec.bodies.push_back(std::move(b));
+        }
+        if (rec.bodies.empty()){ std::fprintf(stderr, "no files in %s\n", dir.c_str()); return 1; }
+        ok = RunCoreCase(rec) && ok;
+    }
+    std::printf("\n%-16s %7s %13s %13s\n", "poll", "pages", "allocs/page", "warmed up");
+    for (const auto& nc : cases){
+        if (nc[0] < 1000 || nc[0] > maxEvents) continue;
+        const PollAllocs pa = CountPollAllocs(nc[0], nc[1], 99);
+        const std::string label = "n" + std::to_string(nc[0]) + ".a" + std::to_string(nc[1]);
+        std::printf("%-16s %7zu %13.1f %13.1f\n", label.c_str(), pa.pages, pa.fresh, pa.warm);
+        Report("core." + label + ".poll_allocs", pa.fresh, "allocs/page");
+        Report("core." + label + ".poll_allocs_warm", pa.warm, "allocs/page");
+    }
+    return ok ? 0 : 1;
+}
+
+static void Usage(){
+    std::fprintf(stderr, "usage: killfeed_bench pixels [--w N] [--h N] [--iters N]\n"
+                         "       killfeed_bench text [--w N] [--h N] [--iters N] [--size N] [--rows N] [--dump]\n"
+                         "       killfeed_bench metrics [--iters N]\n"
+                         "       killfeed_bench inflate <dir> [--iters N]\n"
+                         "       killfeed_bench frames [--pages N]\n"
+                         "       killfeed_bench core [dir] [--max-events N]\n"
+                         "       killfeed_bench all [dir]\n"
+                         "       (each also takes --json FILE)\n"
+                         "       killfeed_bench compare OLD.jsonl NEW.jsonl [--threshold PCT]\n");
+}
+
+int main(int argc, char** argv){
+    if (argc < 2){ Usage(); return 2; }
+    std::string what = argv[1], dir, other, json;
+    int w = 520, h = 220, iters = 200, size = 5, rows = 8, pages = 100;
+    size_t maxEvents = 100000;
+    double threshold = 10;
+    bool dump = false;
+    for (int i = 2; i < argc; ++i){
+        if      (!std::strcmp(argv[i], "--w") && i+1 < argc)     w = std::max(17, std::atoi(argv[++i]));
+        else if (!std::strcmp(argv[i], "--h") && i+1 < argc)     h = std::max(1, std::atoi(argv[++i]));
+        else if (!std::strcmp(argv[i], "--iters") && i+1 < argc) iters = std::max(1, std::atoi(argv[++i]));
+        else if (!std::strcmp(argv[i], "--size") && i+1 < argc)  size = std::max(1, std::atoi(argv[++i]));
+        else if (!std::strcmp(argv[i], "--rows") && i+1 < argc)  rows = std::max(0, std::atoi(argv[++i]));
+        else if (!std::strcmp(argv[i], "--pages") && i+1 < argc) pages = std::max(1, std::atoi(argv[++i]));
+        else if (!std::strcmp(argv[i], "--dump"))                dump = true;
+        else if (!std::strcmp(argv[i], "--json") && i+1 < argc)  json = argv[++i];
+        else if (!std::strcmp(argv[i], "--threshold") && i+1 < argc) threshold = std::max(0.0, std::atof(argv[++i]));
+        else if (!std::strcmp(argv[i], "--max-events") && i+1 < argc) maxEvents = (size_t)std::max(1, std::atoi(argv[++i]));
+        else if (argv[i][0] != '-' && dir.empty())               dir = argv[i];
+        else if (argv[i][0] != '-' && other.empty())             other = argv[i];
+        else { Usage(); return 2; }
+    }
+    if (what == "compare"){
+        if (dir.empty() || other.empty()){ Usage(); return 2; }
+        return RunCompare(dir, other, threshold);
+    }
+    int rc = -1;
+    if      (what == "pixels")  rc = RunPixels(w, h, iters);
+    else if (what == "text")    rc = RunText(w, h, iters, size, rows, dump);
+    else if (what == "metrics") rc = RunMetrics(iters);
+    else if (what == "inflate" && !dir.empty()) rc = RunInflate(dir, iters);
+    else if (what == "frames")  rc = RunFrames(pages);
+    else if (what == "core")    rc = RunCore(dir, maxEvents);
+    else if (what == "all"){
+        std::printf("== pixels\n");  rc = RunPixels(w, h, iters);
+        std::printf("== text\n");    rc |= RunText(w, h, iters, size, rows, false);
+        std::printf("== metrics\n"); rc |= RunMetrics(iters);
+        if (!dir.empty()){ std::printf("== inflate\n"); rc |= RunInflate(dir, iters); }
+        std::printf("== frames\n");  rc |= RunFrames(pages);
+        std::printf("== core\n");    rc |= RunCore(dir, maxEvents);
+    }
+    if (rc < 0 || !other.empty()){ Usage(); return 2; }
+    if (!json.empty() && !WriteResults(json, what)) return 1;
+    return rc;
+}
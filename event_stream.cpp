@@ -0,0 +1,113 @@
+// event_stream.cpp — Census event-stream subscription, Death parsing and the push ingest loop.
+
+#include "event_stream.h"
+#include "json_scan.h"
+#include "metrics.h"
+#include <algorithm>
+#include <chrono>
+
+std::wstring BuildStreamingPath(const std::wstring& serviceId){
+    return L"/streaming?environment=ps2&service-id=" + serviceId;
+}
+
+std::string BuildDeathSubscribe(const std::wstring& charId){
+    return "{\"service\":\"event\",\"action\":\"subscribe\",\"characters\":[\"" + WideToUtf8(charId) +
+           "\"],\"eventNames\":[\"Death\"]}";
+}
+
+// {"payload":{"attacker_character_id":"..","character_id":"..","event_name":"Death",
+//             "is_headshot":"1","timestamp":"..",...},"service":"event","type":"serviceMessage"}
+bool ParseStreamDeath(const std::string& msg, uint64_t charId, DeathEvent& out){
+    JsonScanner sc(msg);
+    if (sc.Next() != JsonTok::ObjBegin) return false;
+    bool inPayload = false, isDeath = false, victimOk = false, hasAttacker = false;
+    DeathEvent e{};
+    for(;;){
+        JsonTok t = sc.Next();
+        if (t == JsonTok::End || t == JsonTok::Error || sc.Depth() <= 0) break;
+        if (t == JsonTok::ObjEnd && inPayload && sc.Depth() == 1){ inPayload = false; continue; }
+        if (t != JsonTok::Key) continue;
+        const int depth = sc.Depth();
+        std::string_view k = sc.Text();
+        JsonTok v = sc.Next();
+        if (depth == 1 && k == "payload" && v == JsonTok::ObjBegin){ inPayload = true; continue; }
+        if (!inPayload || depth != 2 || v != JsonTok::String){ sc.SkipValue(v); continue; }
+        if      (k == "event_name")            isDeath  = (sc.Text() == "Death");
+        else if (k == "character_id")          victimOk = (ParseULL(sc.Text()) == charId);
+        else if (k == "attacker_character_id"){ hasAttacker = true; e.attackerId = ParseULL(sc.Text()); }
+        else if (k == "is_headshot")           e.isHS = (sc.Text() == "1");
+        else if (k == "timestamp")             e.ts = ParseULL(sc.Text());
+    }
+    if (!isDeath || !victimOk || !hasAttacker || e.ts == 0) return false;
+    out = std::move(e);
+    return true;
+}
+
+void KillfeedStream(KillfeedState& st, StreamTransport& ws, const FetchFn& fetch,
+                    const std::function<void()>& onChange,
+                    const std::function<bool(int ms)>& waitOrStop,
+                    PageFetcher* catchUp, const ChunkFetchFn& pages)
+{
+    using Clock = std::chrono::steady_clock;
+    const auto stallLimit = std::chrono::seconds(90);   // Census heartbeats well inside this
+    int backoffMs = 1000;
+    st.keyBySynth = true;
+
+    auto notify = [&]{ if (onChange) onChange(); };
+    auto backoff = [&]{
+        bool stop = waitOrStop(backoffMs);
+        backoffMs = std::min(backoffMs * 2, 30000);
+        return stop;
+    };
+
+    while (!waitOrStop(0)){
+        if (!KillfeedResolveCharacter(st, fetch)){ notify(); if (backoff()) return; continue; }
+
+        std::wstring err;
+        if (!ws.Connect(BuildStreamingPath(st.serviceId), err) || !ws.Send(BuildDeathSubscribe(st.characterId))){
+            ws.Close();
+            st.status = L"Stream connect failed" + (err.empty() ? L"" : L": " + err);
+            notify();
+            if (backoff()) return;
+            continue;
+        }
+
+        // Gap-fill: subscribed first, so anything newer than this arrives on the stream and
+        // overlaps are caught by dedupe.
+        KillfeedPoll(st, fetch, onChange, catchUp, pages);
+        st.status = L"Stream connected";
+        notify();
+        backoffMs = 1000;
+
+        const uint64_t charId = ParseULL(st.characterId);
+        auto lastMsg = Clock::now();
+        std::string msg;
+        while (!waitOrStop(0)){
+            int r = ws.Receive(msg, 1000);
+            if (r < 0) break;
+            if (r == 0){
+                if (Clock::now() - lastMsg > stallLimit) break;
+                continue;
+            }
+            lastMsg = Clock::now();
+            DeathEvent e;
+            if (!ParseStreamDeath(msg, charId, e)) continue;
+            StageTimer apply(Stage::Apply);
+            bool applied = ApplyDeathEvent(st, e);
+            SettleDedupe(st);
+            apply.Stop();
+            if (applied) PipelineMetrics().Add(Counter::Events);
+            KillfeedResolveNames(st, fetch);    // stream payloads never carry names
+            if (applied){
+                st.line   = KilledByLine(st, L"  (+1)");
+                st.status = L"Stream: death";
+                notify();
+            }
+        }
+        ws.Close();
+        if (waitOrStop(0)) return;
+        st.status = L"Stream lost; reconnecting";
+        notify();
+        if (backoff()) return;
+    }
+}
@@ -0,0 +1,43 @@
+// event_stream.h — push ingest from the Census real-time event stream (Death events).
+// Deaths are applied the moment they arrive; the REST peek+batch path only runs right after
+// each (re)connect to fill whatever happened while we were not subscribed.
+#pragma once
+
+#include "killfeed_core.h"
+#include <string>
+#include <functional>
+
+// A message-oriented connection to the streaming endpoint (WebSocket text frames).
+class StreamTransport {
+public:
+    virtual ~StreamTransport() = default;
+    virtual bool Connect(const std::wstring& path, std::wstring& err) = 0;
+    virtual bool Send(const std::string& text) = 0;
+    // 1: msg holds one message; 0: nothing within timeoutMs; -1: connection is gone.
+    virtual int  Receive(std::string& msg, int timeoutMs) = 0;
+    // Safe from another thread: makes a blocked Receive return -1 so the owner can shut down.
+    virtual void Abort() = 0;
+    virtual void Close() = 0;
+};
+
+std::wstring BuildStreamingPath(const std::wstring& serviceId);
+std::string  BuildDeathSubscribe(const std::wstring& charId);
+
+// Parses a serviceMessage payload for a Death where charId is the victim.
+bool ParseStreamDeath(const std::string& msg, uint64_t charId, DeathEvent& out);
+
+// Runs until waitOrStop returns true. waitOrStop(ms) sleeps up to ms (0 = just check) and
+// reports whether the caller wants the stream stopped. Reconnects with capped backoff; the
+// REST gap-fill after each (re)connect goes through catchUp and pages when given (see KillfeedPoll).
+void KillfeedStream(KillfeedState& st, StreamTransport& ws, const FetchFn& fetch,
+                    const std::function<void()>& onChange,
+                    const std::function<bool(int ms)>& waitOrStop,
+                    PageFetcher* catchUp = nullptr, const ChunkFetchFn& pages = nullptr);
+
+#ifdef _WIN32
+// wss:// via WinHTTP (ws_winhttp.cpp).
+std::unique_ptr<StreamTransport> MakeWinHttpStream(const std::wstring& host, unsigned short port);
+#else
+// Plain-socket ws:// client (no TLS), for the Linux tools and the local stand-in.
+std::unique_ptr<StreamTransport> MakeSocketStream(const std::string& host, unsigned short port);
+#endif
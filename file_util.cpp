@@ -0,0 +1,61 @@
+// file_util.cpp — UTF-8 path file helpers (see file_util.h).
+
+#include "file_util.h"
+#include "killfeed_core.h"
+#include <cerrno>
+
+#ifdef _WIN32
+#include <windows.h>
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+FILE* OpenFileUtf8(const std::string& path, const char* mode){
+#ifdef _WIN32
+    return _wfopen(Utf8ToWide(path).c_str(), Utf8ToWide(mode).c_str());
+#else
+    return std::fopen(path.c_str(), mode);
+#endif
+}
+
+bool FlushToDisk(FILE* f){
+    if (std::fflush(f) != 0) return false;
+#ifdef _WIN32
+    return _commit(_fileno(f)) == 0;
+#else
+    return fsync(fileno(f)) == 0;
+#endif
+}
+
+bool RenameOver(const std::string& from, const std::string& to){
+#ifdef _WIN32
+    return MoveFileExW(Utf8ToWide(from).c_str(), Utf8ToWide(to).c_str(),
+                       MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH) != 0;
+#else
+    return std::rename(from.c_str(), to.c_str()) == 0;
+#endif
+}
+
+bool RemoveFileUtf8(const std::string& path){
+#ifdef _WIN32
+    return DeleteFileW(Utf8ToWide(path).c_str()) != 0 || GetLastError() == ERROR_FILE_NOT_FOUND;
+#else
+    return std::remove(path.c_str()) == 0 || errno == ENOENT;
+#endif
+}
+
+bool ReadAllAligned(const std::string& path, std::vector<uint64_t>& buf, size_t& bytes){
+    FILE* f = OpenFileUtf8(path, "rb");
+    if (!f) return false;
+    bytes = 0;
+    buf.clear();
+    for (;;){
+        buf.resize((bytes + 65536 + 7) / 8);
+        size_t n = std::fread((char*)buf.data() + bytes, 1, buf.size() * 8 - bytes, f);
+        bytes += n;
+        if (n == 0) break;
+    }
+    std::fclose(f);
+    return true;
+}
@@ -0,0 +1,16 @@
+// file_util.h — file helpers over UTF-8 paths, for the session and history stores and the
+// metrics log. On Windows every path is widened and goes through the W calls, so a folder with
+// non-ASCII characters works the same as any other.
+#pragma once
+
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+FILE* OpenFileUtf8(const std::string& path, const char* mode);
+bool  FlushToDisk(FILE* f);                                        // fflush + fsync/_commit
+bool  RenameOver(const std::string& from, const std::string& to);  // replaces to
+bool  RemoveFileUtf8(const std::string& path);                      // true once it is gone
+// Whole file into 8-byte aligned storage, so the records can be read in place.
+bool  ReadAllAligned(const std::string& path, std::vector<uint64_t>& buf, size_t& bytes);
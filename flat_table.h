@@ -0,0 +1,129 @@
+// flat_table.h — open-addressing hash table (linear probing, backward-shift erase) for the
+// integer keys of the core: attacker ids, event ids and packed synthetic dedupe keys.
+// Keys and values sit side by side in one array, so a lookup touches one or two cache lines.
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// splitmix64 finalizer: Census ids share long prefixes, so the low bits alone hash badly.
+inline uint64_t MixU64(uint64_t x){
+    x ^= x >> 30; x *= 0xBF58476D1CE4E5B9ull;
+    x ^= x >> 27; x *= 0x94D049BB133111EBull;
+    x ^= x >> 31;
+    return x;
+}
+
+struct FlatHashU64 { uint64_t operator()(uint64_t k) const { return MixU64(k); } };
+struct FlatEmpty {};
+
+template<typename K, typename V, typename Hash = FlatHashU64>
+class FlatTable {
+public:
+    size_t size() const { return size_; }
+    bool   empty() const { return size_ == 0; }
+
+    void clear(){ slots_.clear(); size_ = 0; }
+    void reserve(size_t n){ if (n * 10 > slots_.size() * 7) Rehash(Capacity(n)); }
+
+    V* Find(const K& k){
+        if (slots_.empty()) return nullptr;
+        for (size_t i = Home(k);; i = (i + 1) & Mask()){
+            Slot& s = slots_[i];
+            if (!s.used) return nullptr;
+            if (s.key == k) return &s.val;
+        }
+    }
+    const V* Find(const K& k) const { return const_cast<FlatTable*>(this)->Find(k); }
+    bool Contains(const K& k) const { return Find(k) != nullptr; }
+
+    // Returns the value for k, default-constructing it if absent; inserted says which.
+    V& Upsert(const K& k, bool* inserted = nullptr){
+        if ((size_ + 1) * 10 > slots_.size() * 7) Rehash(slots_.empty() ? 16 : slots_.size() * 2);
+        size_t i = Home(k);
+        for (;; i = (i + 1) & Mask()){
+            Slot& s = slots_[i];
+            if (!s.used) break;
+            if (s.key == k){ if (inserted) *inserted = false; return s.val; }
+        }
+        Slot& s = slots_[i];
+        s.used = true; s.key = k; s.val = V{};
+        ++size_;
+        if (inserted) *inserted = true;
+        return s.val;
+    }
+    V& operator[](const K& k){ return Upsert(k); }
+    bool Insert(const K& k){ bool ins; Upsert(k, &ins); return ins; }
+
+    bool Erase(const K& k){
+        if (slots_.empty()) return false;
+        size_t i = Home(k);
+        for (;; i = (i + 1) & Mask()){
+            if (!slots_[i].used) return false;
+            if (slots_[i].key == k) break;
+        }
+        EraseAt(i);
+        return true;
+    }
+
+    // Keeps only the entries keep(key, val) accepts; if any were dropped, shrinks to fit the rest.
+    // Erases in place and keeps the capacity (a dedupe table fills and drains every poll), unless
+    // what is left would fit a sixteenth of a large table. keep may see an entry more than once.
+    template<typename F> void RetainIf(F&& keep){
+        for (size_t i = 0; i < slots_.size(); ){
+            Slot& s = slots_[i];
+            if (s.used && !keep(static_cast<const K&>(s.key), static_cast<const V&>(s.val))) EraseAt(i);   // i again: refilled
+            else ++i;
+        }
+        if (slots_.size() > 4096 && Capacity(size_) * 16 <= slots_.size()) Rehash(Capacity(size_));
+    }
+
+    // f(const K&, V&) for every entry, in table order.
+    template<typename F> void ForEach(F&& f){
+        for (Slot& s : slots_) if (s.used) f(static_cast<const K&>(s.key), s.val);
+    }
+    template<typename F> void ForEach(F&& f) const {
+        for (const Slot& s : slots_) if (s.used) f(s.key, s.val);
+    }
+
+private:
+    struct Slot { K key{}; V val{}; bool used = false; };
+
+    size_t Mask() const { return slots_.size() - 1; }
+    size_t Home(const K& k) const { return (size_t)Hash{}(k) & Mask(); }
+    static size_t Capacity(size_t n){ size_t c = 16; while (c * 7 < n * 10) c <<= 1; return c; }
+
+    // Backward shift: pull later members of the probe run into the hole (no tombstones).
+    void EraseAt(size_t i){
+        for (size_t j = i;;){
+            slots_[i].used = false;
+            for (;;){
+                j = (j + 1) & Mask();
+                if (!slots_[j].used){ --size_; return; }
+                size_t h = Home(slots_[j].key);
+                bool stays = (i <= j) ? (i < h && h <= j) : (i < h || h <= j);
+                if (!stays) break;
+            }
+            slots_[i] = slots_[j];
+            i = j;
+        }
+    }
+
+    void Rehash(size_t cap){
+        std::vector<Slot> old; old.swap(slots_);
+        slots_.resize(cap);
+        for (Slot& s : old){
+            if (!s.used) continue;
+            size_t i = Home(s.key);
+            while (slots_[i].used) i = (i + 1) & Mask();
+            slots_[i] = std::move(s);
+        }
+    }
+
+    std::vector<Slot> slots_;
+    size_t size_ = 0;
+};
+
+template<typename K, typename Hash = FlatHashU64>
+using FlatSet = FlatTable<K, FlatEmpty, Hash>;
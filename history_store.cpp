@@ -0,0 +1,407 @@
+// history_store.cpp — lifetime death history on disk (see history_store.h).
+
+#include "history_store.h"
+#include "session_store.h"
+#include "file_util.h"
+#include "inflate.h"
+#include "metrics.h"
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+
+static size_t Pad8(size_t n){ return (n + 7) & ~(size_t)7; }
+
+// ========================== On-disk layout ==========================
+static const char     kColMagic[8]   = {'K','F','H','I','S','T','\0','\0'};
+static const char     kIndexMagic[8] = {'K','F','H','I','D','X','\0','\0'};
+static const uint32_t kVersion       = 1;
+
+struct ColHeader { char magic[8]; uint32_t version, headerBytes; uint64_t characterId, pad; };
+
+// Block: crc32 of everything after the crc field, total size (multiple of 8), then
+// u32 ts[rows] and u32 slot[rows] (each padded to 8), u64 hsBits[(rows + 63) / 64], u64 newIds[newIds].
+// Slots are numbered in order of first appearance in the file; newIds are the ones this block adds.
+struct BlockHead { uint32_t crc, bytes, rows, newIds; };
+
+struct IndexHeader {
+    char     magic[8];
+    uint32_t version, headerBytes;
+    uint64_t characterId, coveredBytes, rows;
+    uint32_t lastTs, attackerCount;
+    uint32_t crc, pad;                    // crc32 of the whole file with this field zero
+};
+// In ranking order; postings: rows u64 (ts << 1 | hs), each attacker's deaths as one run, oldest first.
+struct AttackerRec { uint64_t id; uint32_t tot, hs, firstTs, lastTs, slot, postOff; };
+
+static_assert(sizeof(ColHeader) == 32 && sizeof(BlockHead) == 16 && sizeof(IndexHeader) == 56 &&
+              sizeof(AttackerRec) == 32, "on-disk layout");
+
+static bool RankBefore(const StoredAttacker& a, const StoredAttacker& b){
+    if (a.tot != b.tot) return a.tot > b.tot;
+    if (a.hs  != b.hs)  return a.hs  > b.hs;
+    return a.id < b.id;
+}
+
+// ========================== HistoryStore ==========================
+HistoryStore::HistoryStore(std::string basePath)
+    : colPath_(basePath + ".kfh"), indexPath_(basePath + ".kfx") {}
+
+HistoryStore::~HistoryStore(){ if (file_) std::fclose(file_); }
+
+void HistoryStore::Reset(){
+    if (file_){ std::fclose(file_); file_ = nullptr; }
+    charId_ = 0; rows_ = 0; fileBytes_ = 0; indexedBytes_ = 0; lastTs_ = 0;
+    attackers_.clear(); byId_.clear(); ranked_.clear(); postings_.clear(); tail_.clear(); edge_.clear();
+}
+
+uint32_t HistoryStore::SlotOf(uint64_t id){
+    bool inserted = false;
+    uint32_t& slot = byId_.Upsert(id, &inserted);
+    if (inserted){
+        slot = (uint32_t)attackers_.size();
+        attackers_.emplace_back();
+        attackers_.back().s.id = id;
+    }
+    return slot;
+}
+
+void HistoryStore::Fold(uint32_t slot, uint32_t ts, bool hs){
+    StoredAttacker& a = attackers_[slot].s;
+    if (!a.tot || ts < a.firstTs) a.firstTs = ts;
+    if (ts > a.lastTs) a.lastTs = ts;
+    ++a.tot;
+    if (hs) ++a.hs;
+    if (ts > lastTs_){ lastTs_ = ts; edge_.clear(); }
+    if (ts == lastTs_) ++edge_[SynthKey{((uint64_t)ts << 1) | (hs ? 1u : 0u), a.id}];
+    tail_.push_back(TailRow{slot, ((uint64_t)ts << 1) | (hs ? 1u : 0u)});
+    ++rows_;
+}
+
+template<typename F> void HistoryStore::ForEachDeath(F&& f) const {
+    for (uint32_t slot = 0; slot < attackers_.size(); ++slot){
+        const Attacker& a = attackers_[slot];
+        for (uint32_t i = 0; i < a.postLen; ++i) f(slot, postings_[a.postOff + i]);
+    }
+    for (const TailRow& r : tail_) f(r.slot, r.tsHs);
+}
+
+bool HistoryStore::Open(uint64_t characterId, HistoryOpenInfo* info){
+    HistoryOpenInfo local;
+    HistoryOpenInfo& out = info ? *info : local;
+    out = HistoryOpenInfo{};
+    Reset();
+    charId_ = characterId;
+
+    std::vector<uint64_t> buf;
+    size_t bytes = 0;
+    if (!ReadAllAligned(colPath_, buf, bytes)){ out.why = "no history yet"; return false; }
+    const char* base = (const char*)buf.data();
+    ColHeader ch;
+    if (bytes < sizeof(ch)){ out.why = "history too short"; return false; }
+    std::memcpy(&ch, base, sizeof(ch));
+    if (std::memcmp(ch.magic, kColMagic, 8) || ch.version != kVersion || ch.headerBytes != sizeof(ch)){
+        out.why = "history has an unknown format"; return false;
+    }
+    if (ch.characterId != characterId){ out.why = "history is for another character"; return false; }
+
+    // The index, if it is for this file: everything up to coveredBytes without reading a block.
+    size_t pos = sizeof(ch);
+    std::vector<uint64_t> ibuf;
+    size_t ibytes = 0;
+    IndexHeader ih;
+    if (ReadAllAligned(indexPath_, ibuf, ibytes) && ibytes >= sizeof(ih)){
+        const char* ib = (const char*)ibuf.data();
+        std::memcpy(&ih, ib, sizeof(ih));
+        IndexHeader zeroed = ih; zeroed.crc = 0;
+        const uint64_t recBytes = (uint64_t)ih.attackerCount * sizeof(AttackerRec);
+        const bool ok = !std::memcmp(ih.magic, kIndexMagic, 8) && ih.version == kVersion && ih.headerBytes == sizeof(ih) &&
+                        ih.characterId == characterId && ih.coveredBytes >= sizeof(ch) && ih.coveredBytes <= bytes &&
+                        ibytes == sizeof(ih) + recBytes + ih.rows * 8 &&
+                        Crc32(ib + sizeof(ih), ibytes - sizeof(ih), Crc32(&zeroed, sizeof(zeroed))) == ih.crc;
+        if (ok){
+            const AttackerRec* ar = (const AttackerRec*)(ib + sizeof(ih));
+            attackers_.resize(ih.attackerCount);
+            ranked_.reserve(ih.attackerCount);
+            byId_.reserve(ih.attackerCount);
+            std::vector<bool> filled(ih.attackerCount, false);
+            bool sane = true;
+            for (uint32_t i = 0; i < ih.attackerCount && sane; ++i){
+                const AttackerRec& r = ar[i];
+                sane = r.slot < ih.attackerCount && !filled[r.slot] && (uint64_t)r.postOff + r.tot <= ih.rows &&
+                       byId_.Insert(r.id);
+                if (!sane) break;
+                filled[r.slot] = true;
+                byId_[r.id] = r.slot;
+                Attacker& a = attackers_[r.slot];
+                a.s = StoredAttacker{r.id, r.tot, r.hs, r.firstTs, r.lastTs};
+                a.postOff = r.postOff; a.postLen = r.tot;
+                ranked_.push_back(r.slot);
+            }
+            if (sane){
+                postings_.assign((const uint64_t*)(ib + sizeof(ih) + recBytes), (const uint64_t*)(ib + sizeof(ih) + recBytes) + ih.rows);
+                rows_ = ih.rows;
+                lastTs_ = ih.lastTs;
+                pos = indexedBytes_ = ih.coveredBytes;
+                out.indexed = true;
+            } else {
+                attackers_.clear(); byId_.clear(); ranked_.clear();
+            }
+        }
+    }
+    if (out.indexed)
+        for (uint32_t slot = 0; slot < attackers_.size(); ++slot){
+            const Attacker& a = attackers_[slot];
+            for (uint32_t i = 0; i < a.postLen; ++i)
+                if ((postings_[a.postOff + i] >> 1) == lastTs_) ++edge_[SynthKey{postings_[a.postOff + i], a.s.id}];
+        }
+
+    // Blocks past the index, until the first one that does not check out.
+    while (pos < bytes){
+        BlockHead bh;
+        if (bytes - pos < sizeof(bh)){ out.torn = true; break; }
+        std::memcpy(&bh, base + pos, sizeof(bh));
+        const uint64_t need = sizeof(bh) + 2 * Pad8((uint64_t)bh.rows * 4) + (bh.rows + 63) / 64 * 8 + (uint64_t)bh.newIds * 8;
+        if (bh.bytes != need || bh.bytes > bytes - pos || Crc32(base + pos + 4, bh.bytes - 4u) != bh.crc ||
+            attackers_.size() + bh.newIds > UINT32_MAX){ out.torn = true; break; }
+        const char* p = base + pos + sizeof(bh);
+        const uint32_t* ts   = (const uint32_t*)p;
+        const uint32_t* slot = (const uint32_t*)(p + Pad8(bh.rows * 4));
+        const uint64_t* hs   = (const uint64_t*)(p + 2 * Pad8(bh.rows * 4));
+        const uint64_t* ids  = hs + (bh.rows + 63) / 64;
+        for (uint32_t i = 0; i < bh.newIds; ++i) SlotOf(ids[i]);
+        bool sane = true;
+        for (uint32_t i = 0; i < bh.rows && sane; ++i) sane = slot[i] < attackers_.size();
+        if (!sane){ out.torn = true; break; }
+        for (uint32_t i = 0; i < bh.rows; ++i) Fold(slot[i], ts[i], (hs[i / 64] >> (i % 64)) & 1);
+        ++out.tailBlocks;
+        pos += bh.bytes;
+    }
+    fileBytes_ = pos;
+    if (out.torn){
+        // Appends go after the last good block.
+        std::error_code ec;
+        std::filesystem::resize_file(std::filesystem::u8path(colPath_), pos, ec);
+    }
+    return true;
+}
+
+bool HistoryStore::OpenForAppend(){
+    if (file_) return true;
+    if (fileBytes_ == 0){
+        // A new file: an index left from an older one must not be taken for this one's.
+        if (!RemoveFileUtf8(indexPath_)) return false;
+        file_ = OpenFileUtf8(colPath_, "wb");
+        if (!file_) return false;
+        ColHeader ch{};
+        std::memcpy(ch.magic, kColMagic, 8);
+        ch.version = kVersion;
+        ch.headerBytes = sizeof(ch);
+        ch.characterId = charId_;
+        if (std::fwrite(&ch, sizeof(ch), 1, file_) != 1 || !FlushToDisk(file_)){
+            std::fclose(file_); file_ = nullptr; return false;
+        }
+        fileBytes_ = sizeof(ch);
+        return true;
+    }
+    // Appends go right after the last good block: cut off whatever part of a failed one landed.
+    std::error_code ec;
+    const std::filesystem::path col = std::filesystem::u8path(colPath_);
+    const uintmax_t onDisk = std::filesystem::file_size(col, ec);
+    if (ec || onDisk < fileBytes_) return false;
+    if (onDisk > fileBytes_){
+        std::filesystem::resize_file(col, fileBytes_, ec);
+        if (ec) return false;
+    }
+    file_ = OpenFileUtf8(colPath_, "ab");
+    return file_ != nullptr;
+}
+
+size_t HistoryStore::Append(const std::vector<DeathEvent>& events, bool repeatsEdge){
+    if (!charId_) return 0;
+    // Rows that go in: the page's deaths from lastTs_ on, minus (repeatsEdge) the ones at lastTs_
+    // already stored.
+    std::vector<const DeathEvent*> rows;
+    rows.reserve(events.size());
+    FlatTable<SynthKey, uint32_t, SynthKeyHash> repeat = edge_;
+    for (const DeathEvent& e : events){
+        if (e.ts > UINT32_MAX || e.ts < lastTs_) continue;
+        if (repeatsEdge && e.ts == lastTs_){
+            uint32_t* n = repeat.Find(SynthKey{(e.ts << 1) | (e.isHS ? 1u : 0u), e.attackerId});
+            if (n && *n){ --*n; continue; }
+        }
+        rows.push_back(&e);
+    }
+    if (rows.empty() || !OpenForAppend()) return 0;
+
+    const size_t firstNew = attackers_.size();
+    std::vector<uint32_t> ts(rows.size()), slot(rows.size());
+    std::vector<uint64_t> hs((rows.size() + 63) / 64, 0);
+    for (size_t i = 0; i < rows.size(); ++i){
+        ts[i] = (uint32_t)rows[i]->ts;
+        slot[i] = SlotOf(rows[i]->attackerId);
+        if (rows[i]->isHS) hs[i / 64] |= 1ull << (i % 64);
+    }
+    const size_t added = attackers_.size() - firstNew;
+    const size_t colBytes = Pad8(rows.size() * 4);
+    std::string block(sizeof(BlockHead) + 2 * colBytes + hs.size() * 8 + added * 8, '\0');
+    BlockHead bh{0, (uint32_t)block.size(), (uint32_t)rows.size(), (uint32_t)added};
+    char* p = &block[sizeof(bh)];
+    std::memcpy(p, ts.data(), ts.size() * 4);
+    std::memcpy(p + colBytes, slot.data(), slot.size() * 4);
+    std::memcpy(p + 2 * colBytes, hs.data(), hs.size() * 8);
+    for (size_t i = 0; i < added; ++i)
+        std::memcpy(p + 2 * colBytes + hs.size() * 8 + i * 8, &attackers_[firstNew + i].s.id, 8);
+    std::memcpy(&block[0], &bh, sizeof(bh));
+    bh.crc = Crc32(block.data() + 4, block.size() - 4);
+    std::memcpy(&block[0], &bh, sizeof(bh));
+
+    if (std::fwrite(block.data(), block.size(), 1, file_) != 1 || !FlushToDisk(file_)){
+        // Not on disk: forget the attackers this block would have introduced, and start the
+        // next append from a fresh handle (OpenForAppend cuts off whatever part of it did land).
+        for (size_t i = firstNew; i < attackers_.size(); ++i) byId_.Erase(attackers_[i].s.id);
+        attackers_.resize(firstNew);
+        std::fclose(file_); file_ = nullptr;
+        return 0;
+    }
+    fileBytes_ += block.size();
+    for (size_t i = 0; i < rows.size(); ++i) Fold(slot[i], ts[i], rows[i]->isHS);
+    return rows.size();
+}
+
+bool HistoryStore::WriteIndex(){
+    if (!charId_ || fileBytes_ == 0) return false;
+
+    // Ranking order, and every attacker's deaths (indexed run, then the newer tail rows) as one run.
+    std::vector<uint32_t> order(attackers_.size());
+    for (uint32_t i = 0; i < order.size(); ++i) order[i] = i;
+    std::sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b){ return RankBefore(attackers_[a].s, attackers_[b].s); });
+    std::vector<uint32_t> off(attackers_.size()), fill(attackers_.size());
+    uint32_t at = 0;
+    for (uint32_t slot : order){ off[slot] = at; at += attackers_[slot].s.tot; }
+    std::vector<uint64_t> postings(rows_);
+    ForEachDeath([&](uint32_t slot, uint64_t tsHs){ postings[off[slot] + fill[slot]++] = tsHs; });
+
+    IndexHeader h{};
+    std::memcpy(h.magic, kIndexMagic, 8);
+    h.version = kVersion;
+    h.headerBytes = sizeof(h);
+    h.characterId = charId_;
+    h.coveredBytes = fileBytes_;
+    h.rows = rows_;
+    h.lastTs = lastTs_;
+    h.attackerCount = (uint32_t)attackers_.size();
+    std::vector<AttackerRec> recs;
+    recs.reserve(order.size());
+    for (uint32_t slot : order){
+        const StoredAttacker& s = attackers_[slot].s;
+        recs.push_back(AttackerRec{s.id, s.tot, s.hs, s.firstTs, s.lastTs, slot, off[slot]});
+    }
+    uint32_t crc = Crc32(&h, sizeof(h));
+    crc = Crc32(recs.data(), recs.size() * sizeof(AttackerRec), crc);
+    h.crc = Crc32(postings.data(), postings.size() * 8, crc);
+
+    const std::string tmp = indexPath_ + ".tmp";
+    FILE* f = OpenFileUtf8(tmp, "wb");
+    if (!f) return false;
+    bool ok = std::fwrite(&h, sizeof(h), 1, f) == 1;
+    ok = ok && (recs.empty() || std::fwrite(recs.data(), recs.size() * sizeof(AttackerRec), 1, f) == 1);
+    ok = ok && (postings.empty() || std::fwrite(postings.data(), postings.size() * 8, 1, f) == 1);
+    ok = FlushToDisk(f) && ok;
+    ok = (std::fclose(f) == 0) && ok;
+    if (!ok || !RenameOver(tmp, indexPath_)){ RemoveFileUtf8(tmp); return false; }
+
+    for (uint32_t slot = 0; slot < attackers_.size(); ++slot){
+        attackers_[slot].postOff = off[slot];
+        attackers_[slot].postLen = attackers_[slot].s.tot;
+    }
+    postings_ = std::move(postings);
+    ranked_ = std::move(order);
+    tail_.clear();
+    indexedBytes_ = fileBytes_;
+    return true;
+}
+
+std::vector<StoredAttacker> HistoryStore::Top(size_t k, uint32_t minDeaths, bool skipEnvironment) const {
+    std::vector<StoredAttacker> out;
+    auto wanted = [&](const StoredAttacker& s){ return s.tot >= minDeaths && !(skipEnvironment && s.id == 0); };
+    if (tail_.empty() && ranked_.size() == attackers_.size()){
+        // Straight from the index order.
+        for (uint32_t slot : ranked_){
+            if (out.size() >= k) break;
+            if (wanted(attackers_[slot].s)) out.push_back(attackers_[slot].s);
+        }
+        return out;
+    }
+    for (const Attacker& a : attackers_) if (wanted(a.s)) out.push_back(a.s);
+    const size_t n = std::min(k, out.size());
+    std::partial_sort(out.begin(), out.begin() + n, out.end(), RankBefore);
+    out.resize(n);
+    return out;
+}
+
+std::vector<uint64_t> HistoryStore::DeathsBy(uint64_t attackerId) const {
+    std::vector<uint64_t> out;
+    const uint32_t* slot = byId_.Find(attackerId);
+    if (!slot) return out;
+    const Attacker& a = attackers_[*slot];
+    out.reserve(a.s.tot);
+    out.assign(postings_.begin() + a.postOff, postings_.begin() + a.postOff + a.postLen);
+    for (const TailRow& r : tail_) if (r.slot == *slot) out.push_back(r.tsHs);
+    return out;
+}
+
+void HistoryStore::Seed(KillfeedState& st) const {
+    KillfeedState r;
+    r.serviceId       = st.serviceId;
+    r.characterName   = st.characterName;
+    r.skipEnvironment = st.skipEnvironment;
+    r.nameCache       = st.nameCache;
+    r.dedupeWindow    = st.dedupeWindow;
+    r.characterId     = to_wstring_compat(charId_);
+    r.lastDeathTs     = lastTs_;
+    r.dedupeFloor     = lastTs_ ? (unsigned long long)lastTs_ + 1 : 0;
+    for (const WindowCounts& w : st.windows) r.windows.emplace_back(w.Seconds());
+
+    for (const StoredAttacker& a : Top(attackers_.size(), 1, r.skipEnvironment))
+        RestoreAttacker(r, a.id, Counters{(int)a.hs, (int)a.tot}, a.lastTs, std::string_view());
+    uint64_t newest = 0;
+    ForEachDeath([&](uint32_t slot, uint64_t tsHs){
+        const uint64_t id = attackers_[slot].s.id;
+        if (r.skipEnvironment && id == 0) return;
+        const uint32_t ts = (uint32_t)(tsHs >> 1);
+        if (ts >= newest){ newest = ts; r.lastAttackerId = id; }
+        // The windows only want the last few minutes before the newest death.
+        for (WindowCounts& w : r.windows)
+            if ((uint64_t)ts + w.Seconds() + w.Seconds() / WindowCounts::kBuckets > lastTs_) w.Add(id, ts, tsHs & 1);
+    });
+    if (r.counts.size()){
+        r.lastAttackerName = GetNameFor(r, r.lastAttackerId);
+        r.line = KilledByLine(r, L"");
+    }
+    r.status = L"Lifetime: " + to_wstring_compat(rows_) + L" deaths on record";
+    st = std::move(r);
+}
+
+// ========================== Backfill ==========================
+BackfillRun HistoryBackfill(const KillfeedState& st, HistoryStore& history, PageFetcher& pages,
+                            const std::function<void(size_t rows)>& onPage){
+    BackfillRun run;
+    if (st.characterId.empty()){ run.failed = true; return run; }
+    // c:start offsets are relative to sinceTs, so it stays fixed for the whole run (see PollStates).
+    const int PAGE = 1000;
+    const unsigned long long sinceTs = history.LastTs();
+    // BuildDeathsSincePath starts a second early, so the first page repeats the stored deaths of sinceTs.
+    bool first = sinceTs != 0;
+    PageRun r = pages.Run([&](int k){ return BuildDeathsSincePath(st.serviceId, st.characterId, sinceTs, k * PAGE, PAGE); },
+                          0, PAGE, [&](const std::vector<DeathEvent>& events){
+        PipelineMetrics().Add(Counter::Pages);
+        run.added += history.Append(events, first);
+        first = false;
+        if (onPage) onPage((size_t)history.Rows());
+    });
+    run.requests = r.requests;
+    run.pages = r.pages;
+    run.failed = r.failed;
+    if (run.added) history.WriteIndex();
+    return run;
+}
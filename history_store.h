@@ -0,0 +1,104 @@
+// history_store.h — every death of one character, all time, for the lifetime nemesis view.
+// <base>.kfh  columns: append-only blocks of deaths, oldest first. A block holds a timestamp column
+//             (u32 seconds), an attacker column (u32 slot into the file's attacker dictionary), a
+//             headshot bitmap, and the attacker ids it adds to that dictionary; 8 bytes and a bit per
+//             death, CRC per block. A block torn by a crash is cut off the next time the file opens.
+// <base>.kfx  per-attacker index over the first coveredBytes of the .kfh: one record per attacker
+//             (deaths, headshots, first/last death) in ranking order, then each attacker's deaths
+//             as one run of (ts << 1 | hs). Rewritten (temp file + rename) by WriteIndex; blocks
+//             appended after it are folded in when the store opens.
+// Filled by HistoryBackfill from BuildDeathsSincePath pages; after the first (full) backfill only
+// the deaths since LastTs() are fetched. Portable.
+#pragma once
+
+#include <cstdint>
+#include <cstdio>
+#include <functional>
+#include <string>
+#include <vector>
+#include "killfeed_core.h"
+
+struct StoredAttacker {
+    uint64_t id = 0;
+    uint32_t tot = 0, hs = 0;
+    uint32_t firstTs = 0, lastTs = 0;
+};
+
+struct HistoryOpenInfo {
+    bool        indexed = false;       // the .kfx was usable
+    size_t      tailBlocks = 0;        // blocks past the index, folded in
+    bool        torn = false;          // a partial block at the end was cut off
+    std::string why;                   // reason when nothing was loaded
+};
+
+class HistoryStore {
+public:
+    explicit HistoryStore(std::string basePath);   // UTF-8, without extension
+    ~HistoryStore();
+    HistoryStore(const HistoryStore&) = delete;
+    HistoryStore& operator=(const HistoryStore&) = delete;
+
+    // Loads what is on disk for characterId. False when there is none (or it is for another
+    // character, or unreadable); the store is then empty and the next Append starts a new file.
+    bool Open(uint64_t characterId, HistoryOpenInfo* info = nullptr);
+
+    // events oldest first, as they come off ascending pages; deaths before LastTs() are skipped.
+    // repeatsEdge: the first page of a fetch from LastTs(), which repeats the deaths of that
+    // second that are already stored; those are skipped too. The rest become one block, flushed
+    // to disk. Returns how many were stored.
+    size_t Append(const std::vector<DeathEvent>& events, bool repeatsEdge = false);
+
+    // Index over everything appended so far; Open then reads no blocks.
+    bool WriteIndex();
+
+    uint64_t CharacterId() const { return charId_; }
+    uint64_t Rows() const { return rows_; }
+    uint32_t LastTs() const { return lastTs_; }
+    size_t   Attackers() const { return attackers_.size(); }
+    size_t   UnindexedRows() const { return tail_.size(); }
+
+    // The first k attackers with at least minDeaths deaths: deaths desc, headshots desc, id asc.
+    std::vector<StoredAttacker> Top(size_t k, uint32_t minDeaths = 1, bool skipEnvironment = true) const;
+    // Deaths by one attacker, oldest first, as (ts << 1 | hs).
+    std::vector<uint64_t> DeathsBy(uint64_t attackerId) const;
+
+    // Replaces st's counters, ranking and dedupe state with the stored history (settings and the
+    // name cache are kept); names come from the cache or st's next name lookup. Polling then goes
+    // on after LastTs(): the dedupe floor is put just past it, so deaths of that second are not
+    // counted twice. st's windows are kept too and filled with the stored deaths they cover.
+    void Seed(KillfeedState& st) const;
+
+private:
+    struct Attacker { StoredAttacker s; uint32_t postOff = 0, postLen = 0; };   // postings_ run
+    void Reset();
+    bool OpenForAppend();
+    uint32_t SlotOf(uint64_t id);      // adds a new attacker to the dictionary
+    void Fold(uint32_t slot, uint32_t ts, bool hs);
+    template<typename F> void ForEachDeath(F&& f) const;   // f(slot, ts << 1 | hs), oldest first per attacker
+
+    std::string colPath_, indexPath_;
+    FILE*    file_ = nullptr;
+    uint64_t charId_ = 0;
+    uint64_t rows_ = 0;
+    uint64_t fileBytes_ = 0;           // valid bytes of the .kfh
+    uint64_t indexedBytes_ = 0;        // how many of them the index covers
+    uint32_t lastTs_ = 0;
+
+    std::vector<Attacker>  attackers_; // by dictionary slot
+    FlatTable<uint64_t, uint32_t> byId_;   // attacker id -> slot
+    std::vector<uint32_t>  ranked_;    // slots in ranking order, as of the index (Top uses it while tail_ is empty)
+    std::vector<uint64_t>  postings_;  // from the index, (ts << 1 | hs) per attacker run
+    struct TailRow { uint32_t slot; uint64_t tsHs; };
+    std::vector<TailRow>   tail_;      // deaths past the index
+    // The deaths at lastTs_, counted per (ts, hs, attacker). Counted, not a set: two deaths to
+    // one attacker in the same second are both real.
+    FlatTable<SynthKey, uint32_t, SynthKeyHash> edge_;
+};
+
+// Fetches the deaths after history.LastTs() (the whole history on a new store) page by page through
+// pages, in ascending order, and appends each page as it comes in; an interrupted backfill resumes
+// where it stopped. onPage (optional) gets the rows stored so far. Writes the index at the end if
+// anything was added. Needs st.characterId.
+struct BackfillRun { int requests = 0; int pages = 0; size_t added = 0; bool failed = false; };
+BackfillRun HistoryBackfill(const KillfeedState& st, HistoryStore& history, PageFetcher& pages,
+                            const std::function<void(size_t rows)>& onPage = nullptr);
@@ -0,0 +1,207 @@
+// http_socket.cpp — POSIX HTTP/1.1 keep-alive client behind HttpTransport (Linux tools only).
+// Handles Content-Length and chunked bodies, handed to the caller as they come off the socket; a
+// request that fails on a reused connection before any body was handed out is retried once on a
+// fresh one, since the server may have closed it while idle. Asks for gzip/deflate and inflates
+// on the way through (Inflater); a server that answers in identity is passed straight on.
+
+#ifndef _WIN32
+
+#include "http_transport.h"
+#include "inflate.h"
+#include "killfeed_core.h"
+#include "metrics.h"
+#include <algorithm>
+#include <cctype>
+#include <cerrno>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <unistd.h>
+
+namespace {
+
+class SocketTransport : public HttpTransport {
+public:
+    SocketTransport(std::string host, unsigned short port, bool keepAlive, bool compressed)
+        : host_(std::move(host)), port_(port), keepAlive_(keepAlive), compressed_(compressed) {}
+    ~SocketTransport() override { Reset(); }
+
+    bool GetChunks(const std::wstring& path, const std::function<void(const char*, size_t)>& sink,
+                   std::wstring& err) override {
+        StageTimer timer(Stage::Fetch);
+        Metrics& m = PipelineMetrics();
+        ++stats_.requests;
+        m.Add(Counter::Requests);
+        const std::string p = WideToUtf8(path);
+        size_t delivered = 0, decoded = 0;
+        for (int attempt = 0; attempt < 2; ++attempt){
+            bool reused = (fd_ >= 0);
+            if (fd_ < 0){
+                StageTimer connect(Stage::Connect);
+                if (!Connect(err)) break;
+            }
+            bool closeAfter = false;
+            if (Exchange(p, sink, delivered, decoded, closeAfter, err)){
+                if (closeAfter || !keepAlive_) Reset();
+                m.Add(Counter::Bytes, delivered);
+                m.Add(Counter::Decoded, decoded);
+                return true;
+            }
+            Reset();
+            if (!reused || delivered) break;   // fresh connection failed too, or sink has part of it
+        }
+        ++stats_.failures;
+        m.Add(Counter::Failures);
+        return false;
+    }
+
+    void Reset() override {
+        if (fd_ >= 0){ ::close(fd_); fd_ = -1; }
+        buf_.clear();
+    }
+
+private:
+    bool Connect(std::wstring& err){
+        addrinfo hints{}; hints.ai_family = AF_UNSPEC; hints.ai_socktype = SOCK_STREAM;
+        addrinfo* res = nullptr;
+        std::string port = std::to_string(port_);
+        if (getaddrinfo(host_.c_str(), port.c_str(), &hints, &res) != 0 || !res){
+            err = L"resolve failed"; return false;
+        }
+        for (addrinfo* a = res; a; a = a->ai_next){
+            int fd = ::socket(a->ai_family, a->ai_socktype, a->ai_protocol);
+            if (fd < 0) continue;
+            if (::connect(fd, a->ai_addr, a->ai_addrlen) == 0){ fd_ = fd; break; }
+            ::close(fd);
+        }
+        freeaddrinfo(res);
+        if (fd_ < 0){ err = L"connect failed"; return false; }
+        int one = 1; setsockopt(fd_, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+        timeval tv{10, 0};
+        setsockopt(fd_, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+        setsockopt(fd_, SOL_SOCKET, SO_SNDTIMEO, &tv, sizeof(tv));
+        ++stats_.connects;
+        return true;
+    }
+
+    bool SendAll(const std::string& s){
+        size_t off = 0;
+        while (off < s.size()){
+            ssize_t n = ::send(fd_, s.data()+off, s.size()-off, MSG_NOSIGNAL);
+            if (n <= 0){ if (n < 0 && errno == EINTR) continue; return false; }
+            off += (size_t)n;
+        }
+        return true;
+    }
+
+    // Reads more bytes into buf_; false on EOF/error.
+    bool Fill(){
+        char tmp[16384];
+        for(;;){
+            ssize_t n = ::recv(fd_, tmp, sizeof(tmp), 0);
+            if (n > 0){ buf_.append(tmp, (size_t)n); return true; }
+            if (n < 0 && errno == EINTR) continue;
+            return false;
+        }
+    }
+
+    bool ReadLine(std::string& line){
+        size_t e;
+        while ((e = buf_.find("\r\n")) == std::string::npos) if (!Fill()) return false;
+        line.assign(buf_, 0, e); buf_.erase(0, e+2);
+        return true;
+    }
+
+    // Hands the next n bytes to sink as they arrive (n = SIZE_MAX: until the peer closes).
+    bool Pass(size_t n, const std::function<void(const char*, size_t)>& sink, size_t& delivered){
+        while (n){
+            if (buf_.empty() && !Fill()) return n == SIZE_MAX;
+            const size_t k = std::min(n, buf_.size());
+            sink(buf_.data(), k);
+            delivered += k;
+            buf_.erase(0, k);
+            if (n != SIZE_MAX) n -= k;
+        }
+        return true;
+    }
+
+    bool Exchange(const std::string& path, const std::function<void(const char*, size_t)>& sink, size_t& delivered,
+                  size_t& decoded, bool& closeAfter, std::wstring& err){
+        std::string req = "GET " + path + " HTTP/1.1\r\nHost: " + host_ + "\r\nAccept: */*\r\n" +
+                          (compressed_ ? std::string("Accept-Encoding: ") + AcceptedCodings() + "\r\n" : std::string()) +
+                          "Connection: " + (keepAlive_ ? "keep-alive" : "close") + "\r\n\r\n";
+        StageTimer ttfb(Stage::Ttfb);
+        if (!SendAll(req)){ err = L"HttpSendRequest failed"; return false; }
+
+        std::string line;
+        if (!ReadLine(line) || line.compare(0, 5, "HTTP/") != 0){ err = L"bad response"; return false; }
+        ttfb.Stop();
+        long long contentLength = -1; bool chunked = false;
+        ContentCoding coding = ContentCoding::Identity;
+        closeAfter = (line.compare(0, 8, "HTTP/1.0") == 0);
+        for(;;){
+            if (!ReadLine(line)){ err = L"bad response"; return false; }
+            if (line.empty()) break;
+            size_t c = line.find(':'); if (c == std::string::npos) continue;
+            std::string k = line.substr(0, c), v = line.substr(c+1);
+            while (!v.empty() && v[0] == ' ') v.erase(0, 1);
+            for (auto& ch : k) ch = (char)tolower((unsigned char)ch);
+            for (auto& ch : v) ch = (char)tolower((unsigned char)ch);
+            if (k == "content-length") contentLength = std::atoll(v.c_str());
+            else if (k == "transfer-encoding" && v.find("chunked") != std::string::npos) chunked = true;
+            else if (k == "connection") closeAfter = (v.find("close") != std::string::npos);
+            else if (k == "content-encoding") coding = ParseContentCoding(v);
+        }
+        if (coding == ContentCoding::Unsupported){ err = L"unsupported Content-Encoding"; return false; }
+
+        // Compressed bodies go through the inflater; sink sees the decoded bytes either way.
+        std::unique_ptr<Inflater> inflater;
+        std::function<void(const char*, size_t)> decodedSink = [&](const char* s, size_t n){ decoded += n; sink(s, n); };
+        std::function<void(const char*, size_t)> body = decodedSink;
+        if (coding != ContentCoding::Identity){
+            inflater = std::make_unique<Inflater>(coding);
+            body = [&](const char* s, size_t n){ inflater->Feed(s, n, decodedSink); };
+        }
+
+        if (chunked){
+            for(;;){
+                if (!ReadLine(line)){ err = L"truncated body"; return false; }
+                size_t n = std::strtoul(line.c_str(), nullptr, 16);
+                if (n == 0){ while (ReadLine(line) && !line.empty()){} break; }
+                if (!Pass(n, body, delivered) || !ReadLine(line)){ err = L"truncated body"; return false; }
+            }
+        } else if (contentLength >= 0){
+            if (!Pass((size_t)contentLength, body, delivered)){ err = L"truncated body"; return false; }
+        } else {
+            Pass(SIZE_MAX, body, delivered);
+            closeAfter = true;
+        }
+        if (inflater && !inflater->Done()){
+            const char* why = inflater->Failed() ? inflater->Error() : "compressed body cut short";
+            err = std::wstring(why, why + std::strlen(why));
+            return false;
+        }
+        return true;
+    }
+
+    std::string    host_;
+    unsigned short port_;
+    bool           keepAlive_;
+    bool           compressed_;
+    int            fd_ = -1;
+    std::string    buf_;
+};
+
+} // namespace
+
+std::unique_ptr<HttpTransport> MakeSocketTransport(const std::string& host, unsigned short port, bool keepAlive,
+                                                   bool compressed){
+    return std::make_unique<SocketTransport>(host, port, keepAlive, compressed);
+}
+
+#endif
@@ -0,0 +1,46 @@
+// http_transport.h — long-lived HTTP GET client interface used by the ingest side.
+// Implementations keep their session/connection open across requests and reconnect only
+// after a failure. The overlay uses the WinINet one (main.cpp); Linux tools use the socket one.
+#pragma once
+
+#include <string>
+#include <memory>
+#include <functional>
+#include <cstddef>
+#include <cstdint>
+
+struct HttpStats {
+    uint64_t requests = 0;   // GETs attempted
+    uint64_t connects = 0;   // connections (TCP/TLS handshakes) opened
+    uint64_t failures = 0;   // GETs that returned false
+};
+
+class HttpTransport {
+public:
+    virtual ~HttpTransport() = default;
+    // GET path (e.g. "/s:example/get/ps2:v2/...") on the transport's host; the body goes to sink
+    // piece by piece as it is received. Returns false and fills err on transport failure (sink may
+    // have had part of the body by then). Retries on a fresh connection only before any of it.
+    virtual bool GetChunks(const std::wstring& path, const std::function<void(const char*, size_t)>& sink,
+                           std::wstring& err) = 0;
+    // Same, the whole body into body ("" on failure).
+    bool Get(const std::wstring& path, std::string& body, std::wstring& err){
+        body.clear();
+        if (GetChunks(path, [&](const char* p, size_t n){ body.append(p, n); }, err)) return true;
+        body.clear();
+        return false;
+    }
+    // Drops the connection; the next Get reconnects.
+    virtual void Reset() = 0;
+    const HttpStats& Stats() const { return stats_; }
+protected:
+    HttpStats stats_;
+};
+
+#ifndef _WIN32
+// Plain-socket HTTP/1.1 client (no TLS). keepAlive=false reconnects for every request,
+// which is what the overlay used to do and is kept for comparison runs; compressed=false stops
+// asking for gzip/deflate bodies, likewise.
+std::unique_ptr<HttpTransport> MakeSocketTransport(const std::string& host, unsigned short port,
+                                                   bool keepAlive = true, bool compressed = true);
+#endif
@@ -0,0 +1,451 @@
+// inflate.cpp — streaming gzip/zlib/raw deflate decoder and a small compressor (see inflate.h).
+
+#include "inflate.h"
+#include <algorithm>
+#include <cctype>
+#include <cstring>
+
+// ========================== Checksums ==========================
+// Slicing by 8: eight bytes per step through eight tables, several times the byte-at-a-time loop.
+uint32_t Crc32(const void* data, size_t n, uint32_t crc){
+    struct Tables {
+        uint32_t t[8][256];
+        Tables(){
+            for (uint32_t i = 0; i < 256; ++i){
+                uint32_t c = i;
+                for (int k = 0; k < 8; ++k) c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+                t[0][i] = c;
+            }
+            for (int k = 1; k < 8; ++k)
+                for (int i = 0; i < 256; ++i) t[k][i] = (t[k-1][i] >> 8) ^ t[0][t[k-1][i] & 0xFF];
+        }
+    };
+    static const Tables tables;
+    const auto& t = tables.t;
+    const uint8_t* p = (const uint8_t*)data;
+    crc = ~crc;
+    for (; n >= 8; p += 8, n -= 8){
+        uint32_t a, b;
+        std::memcpy(&a, p, 4); std::memcpy(&b, p + 4, 4);
+        a ^= crc;
+        crc = t[7][a & 0xFF] ^ t[6][(a >> 8) & 0xFF] ^ t[5][(a >> 16) & 0xFF] ^ t[4][a >> 24] ^
+              t[3][b & 0xFF] ^ t[2][(b >> 8) & 0xFF] ^ t[1][(b >> 16) & 0xFF] ^ t[0][b >> 24];
+    }
+    for (; n; ++p, --n) crc = t[0][(crc ^ *p) & 0xFF] ^ (crc >> 8);
+    return ~crc;
+}
+
+static void Adler32(const uint8_t* p, size_t n, uint32_t& a, uint32_t& b){
+    while (n){
+        const size_t k = std::min<size_t>(n, 5552);   // largest run before b can overflow
+        for (size_t i = 0; i < k; ++i){ a += p[i]; b += a; }
+        a %= 65521; b %= 65521;
+        p += k; n -= k;
+    }
+}
+
+ContentCoding ParseContentCoding(std::string_view v){
+    while (!v.empty() && (v.front() == ' ' || v.front() == '\t')) v.remove_prefix(1);
+    while (!v.empty() && (v.back() == ' ' || v.back() == '\t')) v.remove_suffix(1);
+    std::string s(v);
+    for (auto& c : s) c = (char)tolower((unsigned char)c);
+    if (s.empty() || s == "identity") return ContentCoding::Identity;
+    if (s == "gzip" || s == "x-gzip")  return ContentCoding::Gzip;
+    if (s == "deflate")                return ContentCoding::Deflate;
+    return ContentCoding::Unsupported;
+}
+
+// ========================== Inflater ==========================
+static const uint16_t kLenBase[29]  = { 3,4,5,6,7,8,9,10,11,13,15,17,19,23,27,31,35,43,51,59,67,83,99,115,131,163,195,227,258 };
+static const uint8_t  kLenExtra[29] = { 0,0,0,0,0,0,0,0,1,1,1,1,2,2,2,2,3,3,3,3,4,4,4,4,5,5,5,5,0 };
+static const uint16_t kDistBase[30] = { 1,2,3,4,5,7,9,13,17,25,33,49,65,97,129,193,257,385,513,769,
+                                        1025,1537,2049,3073,4097,6145,8193,12289,16385,24577 };
+static const uint8_t  kDistExtra[30] = { 0,0,0,0,1,1,2,2,3,3,4,4,5,5,6,6,7,7,8,8,9,9,10,10,11,11,12,12,13,13 };
+static const uint8_t  kCodeLengthOrder[19] = { 16,17,18,0,8,7,9,6,10,5,11,4,12,3,13,2,14,1,15 };
+
+static const size_t kWindow  = 32768;
+static const size_t kFlushAt = kWindow + 65536;   // out_ holds the window plus up to 64 KB of new output
+
+Inflater::Inflater(ContentCoding coding) : coding_(coding) {
+    out_.resize(kFlushAt + 258 + 8);   // a match may start just below kFlushAt; copies overshoot by up to 7
+    if (coding != ContentCoding::Gzip && coding != ContentCoding::Deflate) Fail("unsupported Content-Encoding");
+}
+
+// Tops bits_ up to at least 56 bits, or with whatever input is left.
+void Inflater::Refill(){
+    if (pos_ + 8 <= in_.size()){
+        uint64_t v;
+        std::memcpy(&v, in_.data() + pos_, 8);
+        const int k = (63 - nbits_) >> 3;
+        if (k > 0){
+            bits_ |= (v & (~0ull >> (64 - 8 * k))) << nbits_;
+            pos_ += k; nbits_ += 8 * k;
+        }
+        return;
+    }
+    while (nbits_ <= 56 && pos_ < in_.size()){
+        bits_ |= (uint64_t)(uint8_t)in_[pos_++] << nbits_;
+        nbits_ += 8;
+    }
+}
+
+bool Inflater::Take(int n, uint32_t& v){
+    if (nbits_ < n) Refill();
+    if (nbits_ < n) return false;
+    v = (uint32_t)(bits_ & ((1ull << n) - 1));
+    bits_ >>= n; nbits_ -= n;
+    return true;
+}
+
+bool Inflater::Build(Huffman& h, const uint8_t* lengths, int n){
+    std::memset(h.count, 0, sizeof(h.count));
+    for (int i = 0; i < n; ++i) h.count[lengths[i]]++;
+    h.count[0] = 0;
+    int left = 1;
+    for (int len = 1; len < 16; ++len){
+        left = (left << 1) - h.count[len];
+        if (left < 0) return false;    // more codes than the lengths allow
+    }
+    uint16_t offs[16] = {};
+    for (int len = 1; len < 15; ++len) offs[len + 1] = offs[len] + h.count[len];
+    for (int i = 0; i < n; ++i) if (lengths[i]) h.symbol[offs[lengths[i]]++] = (uint16_t)i;
+
+    // Codes are sent most significant bit first, so the table is indexed by the reversed code.
+    std::memset(h.fast, 0, sizeof(h.fast));
+    int code = 0, index = 0;
+    for (int len = 1; len <= 10; ++len, code <<= 1)
+        for (int k = 0; k < h.count[len]; ++k, ++code, ++index){
+            int r = 0;
+            for (int b = 0; b < len; ++b) r |= ((code >> b) & 1) << (len - 1 - b);
+            for (int j = r; j < 1024; j += 1 << len) h.fast[j] = (uint16_t)((h.symbol[index] << 4) | len);
+        }
+    return true;
+}
+
+Inflater::Step Inflater::Decode(const Huffman& h, int& sym){
+    if (nbits_ < 15) Refill();
+    if (const uint16_t e = h.fast[bits_ & 1023]){
+        const int len = e & 15;
+        if (len > nbits_) return More;
+        sym = e >> 4;
+        bits_ >>= len; nbits_ -= len;
+        return Ok;
+    }
+    // Longer than 10 bits: walk the canonical code one bit at a time.
+    int code = 0, first = 0, index = 0;
+    for (int len = 1; len < 16; ++len){
+        if (len > nbits_) return More;
+        code |= (int)((bits_ >> (len - 1)) & 1);
+        const int count = h.count[len];
+        if (code - first < count){
+            sym = h.symbol[index + code - first];
+            bits_ >>= len; nbits_ -= len;
+            return Ok;
+        }
+        index += count; first = (first + count) << 1; code <<= 1;
+    }
+    return Fail("bad Huffman code");
+}
+
+Inflater::Step Inflater::Wrapper(){
+    const Mark m = Save();
+    uint32_t b[10];
+    if (coding_ == ContentCoding::Gzip){
+        for (uint32_t& x : b) if (!Take(8, x)){ Restore(m); return More; }
+        if (b[0] != 0x1f || b[1] != 0x8b || b[2] != 8) return Fail("not a gzip body");
+        const uint32_t flags = b[3];
+        uint32_t x, y;
+        if (flags & 4){                                   // FEXTRA
+            if (!Take(16, x)){ Restore(m); return More; }
+            while (x--) if (!Take(8, y)){ Restore(m); return More; }
+        }
+        for (uint32_t f : { 8u, 16u })                    // FNAME, FCOMMENT: zero-terminated
+            if (flags & f) do { if (!Take(8, y)){ Restore(m); return More; } } while (y);
+        if ((flags & 2) && !Take(16, x)){ Restore(m); return More; }   // FHCRC
+    } else {
+        if (!Take(8, b[0]) || !Take(8, b[1])){ Restore(m); return More; }
+        zlib_ = (b[0] & 0x0F) == 8 && (b[0] >> 4) <= 7 && ((b[0] << 8) | b[1]) % 31 == 0;
+        if (!zlib_) Restore(m);                           // raw deflate
+        else if (b[1] & 0x20) return Fail("zlib preset dictionary");
+    }
+    state_ = State::Block;
+    return Ok;
+}
+
+Inflater::Step Inflater::BlockHeader(){
+    const Mark m = Save();
+    uint32_t final, type;
+    if (!Take(1, final) || !Take(2, type)){ Restore(m); return More; }
+    last_ = final != 0;
+    if (type == 0){
+        bits_ >>= nbits_ & 7; nbits_ -= nbits_ & 7;
+        uint32_t len, nlen;
+        if (!Take(16, len) || !Take(16, nlen)){ Restore(m); return More; }
+        if ((len ^ 0xFFFF) != nlen) return Fail("bad stored block length");
+        storedLeft_ = len;
+        state_ = State::Stored;
+        return Ok;
+    }
+    if (type == 1){
+        uint8_t lens[288];
+        std::fill(lens, lens + 144, 8); std::fill(lens + 144, lens + 256, 9);
+        std::fill(lens + 256, lens + 280, 7); std::fill(lens + 280, lens + 288, 8);
+        Build(lit_, lens, 288);
+        std::fill(lens, lens + 30, 5);
+        Build(dist_, lens, 30);
+        state_ = State::Codes;
+        return Ok;
+    }
+    if (type == 2){
+        const Step s = DynamicTables();
+        if (s == More) Restore(m);
+        if (s != Ok) return s;
+        state_ = State::Codes;
+        return Ok;
+    }
+    return Fail("bad block type");
+}
+
+Inflater::Step Inflater::DynamicTables(){
+    uint32_t hlit, hdist, hclen, v;
+    if (!Take(5, hlit) || !Take(5, hdist) || !Take(4, hclen)) return More;
+    hlit += 257; hdist += 1; hclen += 4;
+    if (hlit > 286 || hdist > 30) return Fail("bad table sizes");
+
+    uint8_t cl[19] = {};
+    for (uint32_t i = 0; i < hclen; ++i){
+        if (!Take(3, v)) return More;
+        cl[kCodeLengthOrder[i]] = (uint8_t)v;
+    }
+    Huffman lengths;
+    if (!Build(lengths, cl, 19)) return Fail("bad code length code");
+
+    uint8_t lens[286 + 30];
+    for (uint32_t i = 0; i < hlit + hdist; ){
+        int sym;
+        const Step s = Decode(lengths, sym);
+        if (s != Ok) return s;
+        if (sym < 16){ lens[i++] = (uint8_t)sym; continue; }
+        uint8_t fill = 0;
+        uint32_t rep;
+        if (sym == 16){
+            if (i == 0) return Fail("repeat with nothing before it");
+            fill = lens[i - 1];
+            if (!Take(2, rep)) return More;
+            rep += 3;
+        } else if (sym == 17){
+            if (!Take(3, rep)) return More;
+            rep += 3;
+        } else {
+            if (!Take(7, rep)) return More;
+            rep += 11;
+        }
+        if (i + rep > hlit + hdist) return Fail("code lengths overrun");
+        while (rep--) lens[i++] = fill;
+    }
+    if (!lens[256]) return Fail("no end-of-block code");
+    if (!Build(lit_, lens, (int)hlit) || !Build(dist_, lens + hlit, (int)hdist)) return Fail("bad code lengths");
+    return Ok;
+}
+
+Inflater::Step Inflater::Stored(){
+    while (storedLeft_){
+        if (w_ >= kFlushAt) return Ok;
+        uint32_t v;
+        if (nbits_ >= 8){ Take(8, v); out_[w_++] = (uint8_t)v; --storedLeft_; continue; }
+        if (pos_ == in_.size()) return More;
+        const size_t k = std::min({ (size_t)storedLeft_, in_.size() - pos_, kFlushAt - w_ });
+        std::memcpy(&out_[w_], in_.data() + pos_, k);
+        pos_ += k; w_ += k; storedLeft_ -= (uint32_t)k;
+    }
+    state_ = last_ ? State::Trailer : State::Block;
+    return Ok;
+}
+
+// Returns Ok at the end of the block, or with kFlushAt bytes waiting to be passed on.
+Inflater::Step Inflater::Codes(){
+    uint8_t* o = out_.data();
+    size_t w = w_;
+    Step s = Ok;
+    for (;;){
+        if (w >= kFlushAt) break;
+        const Mark m = Save();
+        int sym;
+        if ((s = Decode(lit_, sym)) != Ok) break;
+        if (sym < 256){ o[w++] = (uint8_t)sym; continue; }
+        if (sym == 256){ state_ = last_ ? State::Trailer : State::Block; break; }
+        if ((sym -= 257) >= 29){ s = Fail("bad length code"); break; }
+        uint32_t extra;
+        if (!Take(kLenExtra[sym], extra)){ Restore(m); s = More; break; }
+        const size_t len = kLenBase[sym] + extra;
+        int dsym;
+        if ((s = Decode(dist_, dsym)) != Ok){ if (s == More) Restore(m); break; }
+        if (dsym >= 30){ s = Fail("bad distance code"); break; }
+        if (!Take(kDistExtra[dsym], extra)){ Restore(m); s = More; break; }
+        const size_t dist = kDistBase[dsym] + extra;
+        if (dist > w){ s = Fail("distance before the start"); break; }
+
+        const uint8_t* src = o + w - dist;
+        uint8_t* dst = o + w;
+        if (dist >= 8) for (size_t k = 0; k < len; k += 8) std::memcpy(dst + k, src + k, 8);
+        else if (dist == 1) std::memset(dst, *src, len);
+        else for (size_t k = 0; k < len; ++k) dst[k] = src[k];
+        w += len;
+    }
+    w_ = w;
+    return s;
+}
+
+// The trailer starts on a byte boundary: gzip has CRC-32 and size (little endian), zlib Adler-32 (big).
+Inflater::Step Inflater::Trailer(){
+    bits_ >>= nbits_ & 7; nbits_ -= nbits_ & 7;
+    const Mark m = Save();
+    if (coding_ == ContentCoding::Gzip){
+        if (!Take(32, check_) || !Take(32, isize_)){ Restore(m); return More; }
+    } else if (zlib_){
+        uint32_t b[4];
+        for (uint32_t& x : b) if (!Take(8, x)){ Restore(m); return More; }
+        check_ = (b[0] << 24) | (b[1] << 16) | (b[2] << 8) | b[3];
+    }
+    state_ = State::Done;
+    return Ok;
+}
+
+void Inflater::Flush(const Sink& out, bool slide){
+    if (w_ > sent_){
+        const uint8_t* p = out_.data() + sent_;
+        const size_t n = w_ - sent_;
+        if (coding_ == ContentCoding::Gzip) crc_ = Crc32(p, n, crc_);
+        else if (zlib_) Adler32(p, n, adlerA_, adlerB_);
+        outTotal_ += n;
+        out((const char*)p, n);
+        sent_ = w_;
+    }
+    if (slide && w_ > kWindow){
+        std::memmove(out_.data(), out_.data() + w_ - kWindow, kWindow);
+        w_ = sent_ = kWindow;
+    }
+}
+
+bool Inflater::Feed(const char* p, size_t n, const Sink& out){
+    if (state_ == State::Bad) return false;
+    if (state_ == State::Done) return true;    // anything after the trailer is ignored
+    inTotal_ += n;
+    in_.erase(0, pos_);
+    pos_ = 0;
+    in_.append(p, n);
+    for (;;){
+        Step s = More;
+        switch (state_){
+            case State::Wrapper: s = Wrapper(); break;
+            case State::Block:   s = BlockHeader(); break;
+            case State::Stored:  s = Stored(); break;
+            case State::Codes:   s = Codes(); break;
+            case State::Trailer: s = Trailer(); break;
+            default: break;
+        }
+        if (s == Bad) return false;
+        if (w_ >= kFlushAt) Flush(out, true);
+        if (s == More || state_ == State::Done) break;
+    }
+    Flush(out, false);
+    if (state_ == State::Done){
+        if (coding_ == ContentCoding::Gzip && (crc_ != check_ || (uint32_t)outTotal_ != isize_)){
+            Fail("gzip checksum mismatch");
+            return false;
+        }
+        if (zlib_ && ((adlerB_ << 16) | adlerA_) != check_){
+            Fail("zlib checksum mismatch");
+            return false;
+        }
+    }
+    return true;
+}
+
+bool InflateAll(std::string_view in, std::string& out){
+    out.clear();
+    const bool gzip = in.size() >= 2 && (uint8_t)in[0] == 0x1f && (uint8_t)in[1] == 0x8b;
+    Inflater inf(gzip ? ContentCoding::Gzip : ContentCoding::Deflate);
+    return inf.Feed(in.data(), in.size(), [&](const char* p, size_t n){ out.append(p, n); }) && inf.Done();
+}
+
+// ========================== Compressor ==========================
+namespace {
+
+struct BitWriter {
+    std::string& s;
+    uint64_t bits = 0;
+    int n = 0;
+    void Put(uint32_t v, int k){
+        bits |= (uint64_t)v << n; n += k;
+        while (n >= 8){ s.push_back((char)(bits & 0xFF)); bits >>= 8; n -= 8; }
+    }
+    void Code(uint32_t code, int len){      // Huffman codes go most significant bit first
+        uint32_t r = 0;
+        for (int b = 0; b < len; ++b) r |= ((code >> b) & 1) << (len - 1 - b);
+        Put(r, len);
+    }
+    void Align(){ if (n) Put(0, 8 - n); }
+};
+
+void FixedLiteral(BitWriter& bw, int sym){
+    if      (sym < 144) bw.Code(0x30 + sym, 8);
+    else if (sym < 256) bw.Code(0x190 + sym - 144, 9);
+    else if (sym < 280) bw.Code(sym - 256, 7);
+    else                bw.Code(0xC0 + sym - 280, 8);
+}
+
+void PutLE32(std::string& s, uint32_t v){ for (int i = 0; i < 4; ++i) s.push_back((char)(v >> (8 * i))); }
+
+} // namespace
+
+std::string Deflate(std::string_view in, ContentCoding coding){
+    std::string out;
+    if (coding == ContentCoding::Gzip) out.assign("\x1f\x8b\x08\x00\x00\x00\x00\x00\x00\xff", 10);
+    else out.assign("\x78\x01", 2);
+
+    BitWriter bw{out};
+    bw.Put(1, 1); bw.Put(1, 2);             // one final block, fixed codes
+    const uint8_t* p = (const uint8_t*)in.data();
+    const size_t n = in.size();
+    std::vector<int32_t> head(1 << 15, -1), prev(kWindow, -1);
+    auto hash = [&](size_t i){ return ((p[i] << 10) ^ (p[i+1] << 5) ^ p[i+2]) & 0x7FFF; };
+    auto insert = [&](size_t i){ if (i + 3 <= n){ const int h = hash(i); prev[i & (kWindow - 1)] = head[h]; head[h] = (int32_t)i; } };
+    for (size_t i = 0; i < n; ){
+        size_t best = 0, bestDist = 0;
+        if (i + 3 <= n){
+            int32_t c = head[hash(i)];
+            for (int chain = 0; chain < 32 && c >= 0 && i - (size_t)c <= kWindow - 1; ++chain){
+                size_t l = 0;
+                const size_t max = std::min<size_t>(258, n - i);
+                while (l < max && p[c + l] == p[i + l]) ++l;
+                if (l > best){ best = l; bestDist = i - (size_t)c; if (l == max) break; }
+                c = prev[c & (kWindow - 1)];
+            }
+        }
+        if (best < 3){ FixedLiteral(bw, p[i]); insert(i); ++i; continue; }
+        int ls = 28;
+        while (kLenBase[ls] > best) --ls;
+        FixedLiteral(bw, 257 + ls);
+        bw.Put((uint32_t)(best - kLenBase[ls]), kLenExtra[ls]);
+        int ds = 29;
+        while (kDistBase[ds] > bestDist) --ds;
+        bw.Code((uint32_t)ds, 5);
+        bw.Put((uint32_t)(bestDist - kDistBase[ds]), kDistExtra[ds]);
+        for (size_t k = 0; k < best; ++k) insert(i + k);
+        i += best;
+    }
+    FixedLiteral(bw, 256);
+    bw.Align();
+
+    if (coding == ContentCoding::Gzip){
+        PutLE32(out, Crc32(in.data(), in.size()));
+        PutLE32(out, (uint32_t)in.size());
+    } else {
+        uint32_t a = 1, b = 0;
+        Adler32(p, n, a, b);
+        const uint32_t adler = (b << 16) | a;
+        for (int i = 3; i >= 0; --i) out.push_back((char)(adler >> (8 * i)));
+    }
+    return out;
+}
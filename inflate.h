@@ -0,0 +1,91 @@
+// inflate.h — gzip / deflate response bodies (RFC 1950-1952) without an external library.
+// Inflater decodes a body piece by piece as it comes off the connection and hands the decoded
+// bytes straight on (to DeathBatchParser, or into a string), so a compressed page is never held
+// whole either. Deflate() is the small compressor the stand-in and the bench use to make such
+// bodies: greedy LZ77 matches and the fixed Huffman codes, nothing tuned.
+// Portable; Crc32 is also the checksum of the session files.
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+uint32_t Crc32(const void* data, size_t n, uint32_t crc = 0);
+
+enum class ContentCoding { Identity, Gzip, Deflate, Unsupported };
+
+// A Content-Encoding header value ("" = identity). "deflate" means zlib-wrapped by the RFC, but raw
+// deflate is what some servers send: Inflater tells them apart from the first two bytes.
+ContentCoding ParseContentCoding(std::string_view value);
+
+// What the transports send as Accept-Encoding.
+inline const char* AcceptedCodings(){ return "gzip, deflate"; }
+
+class Inflater {
+public:
+    using Sink = std::function<void(const char*, size_t)>;
+    explicit Inflater(ContentCoding coding);
+
+    // Decodes as much of the body as the bytes so far allow and passes the output on (in pieces
+    // of up to 64 KB). False once the data is found to be bad; then Error() says why.
+    bool Feed(const char* p, size_t n, const Sink& out);
+    bool Done() const { return state_ == State::Done; }        // end of stream, checksum matched
+    bool Failed() const { return state_ == State::Bad; }
+    const char* Error() const { return error_; }
+    uint64_t In() const { return inTotal_; }
+    uint64_t Out() const { return outTotal_; }
+
+private:
+    enum class State { Wrapper, Block, Stored, Codes, Trailer, Done, Bad };
+    enum Step { Ok, More, Bad };
+    struct Huffman {
+        uint16_t fast[1 << 10];   // low 10 bits of the stream -> (symbol << 4) | length; 0 = longer code
+        uint16_t count[16];
+        uint16_t symbol[288];
+    };
+    struct Mark { size_t pos; uint64_t bits; int nbits; };
+
+    Step Fail(const char* why){ state_ = State::Bad; error_ = why; return Bad; }
+    Mark Save() const { return { pos_, bits_, nbits_ }; }
+    void Restore(const Mark& m){ pos_ = m.pos; bits_ = m.bits; nbits_ = m.nbits; }
+    void Refill();
+    bool Take(int n, uint32_t& v);
+    Step Decode(const Huffman& h, int& sym);
+    static bool Build(Huffman& h, const uint8_t* lengths, int n);
+
+    Step Wrapper();
+    Step BlockHeader();
+    Step DynamicTables();
+    Step Stored();
+    Step Codes();
+    Step Trailer();
+    void Flush(const Sink& out, bool slide);
+
+    ContentCoding coding_;
+    bool   zlib_ = false;         // Deflate coding with the zlib wrapper (else raw)
+    State  state_ = State::Wrapper;
+    const char* error_ = "";
+    bool   last_ = false;         // the current block is the final one
+    uint32_t storedLeft_ = 0;
+
+    std::string in_;              // compressed bytes not yet in bits_
+    size_t   pos_ = 0;
+    uint64_t bits_ = 0;
+    int      nbits_ = 0;
+
+    Huffman lit_, dist_;
+    std::vector<uint8_t> out_;    // the last 32 KB (for matches) then what is not passed on yet
+    size_t   w_ = 0, sent_ = 0;   // write position; out_[sent_, w_) is not passed on yet
+    uint32_t crc_ = 0, adlerA_ = 1, adlerB_ = 0;
+    uint32_t check_ = 0, isize_ = 0;  // from the trailer
+    uint64_t inTotal_ = 0, outTotal_ = 0;
+};
+
+// Whole body at once (tools): gzip, zlib or raw deflate, told apart from the first bytes.
+bool InflateAll(std::string_view in, std::string& out);
+
+// in compressed as coding (Gzip, or Deflate = zlib-wrapped).
+std::string Deflate(std::string_view in, ContentCoding coding = ContentCoding::Gzip);
@@ -0,0 +1,189 @@
+// json_scan.h — single-pass, zero-copy JSON tokenizer.
+// Walks the buffer once; strings/numbers come back as views into the source (no allocation).
+// Lenient where our inputs need it: // and /* */ comments are whitespace (config.json has them),
+// commas are separators, and a string followed by ':' is reported as a Key.
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <cstdint>
+
+enum class JsonTok { End, Error, ObjBegin, ObjEnd, ArrBegin, ArrEnd, Key, String, Number, True, False, Null };
+
+class JsonScanner {
+public:
+    explicit JsonScanner(std::string_view src) : s_(src) {}
+
+    JsonTok Next(){
+        SkipWs();
+        if (i_ >= s_.size()) return JsonTok::End;
+        char c = s_[i_];
+        switch (c){
+            case '{': ++i_; ++depth_; return JsonTok::ObjBegin;
+            case '[': ++i_; ++depth_; return JsonTok::ArrBegin;
+            case '}': ++i_; --depth_; return JsonTok::ObjEnd;
+            case ']': ++i_; --depth_; return JsonTok::ArrEnd;
+            case '"': {
+                if (!ScanString()) return JsonTok::Error;
+                SkipWs();
+                if (i_ < s_.size() && s_[i_] == ':'){ ++i_; return JsonTok::Key; }
+                return JsonTok::String;
+            }
+            case 't': return Literal("true",  JsonTok::True);
+            case 'f': return Literal("false", JsonTok::False);
+            case 'n': return Literal("null",  JsonTok::Null);
+            default: break;
+        }
+        if (c=='-' || c=='+' || (c>='0' && c<='9')){
+            size_t b = i_++;
+            while (i_ < s_.size()){
+                char d = s_[i_];
+                if ((d>='0' && d<='9') || d=='.' || d=='e' || d=='E' || d=='-' || d=='+') ++i_;
+                else break;
+            }
+            text_ = s_.substr(b, i_-b); escaped_ = false;
+            return JsonTok::Number;
+        }
+        return JsonTok::Error;
+    }
+
+    // Skips the value that starts with token t (just returned by Next()).
+    void SkipValue(JsonTok t){
+        if (t != JsonTok::ObjBegin && t != JsonTok::ArrBegin) return;
+        int target = depth_ - 1;
+        while (depth_ > target){
+            JsonTok k = Next();
+            if (k == JsonTok::End || k == JsonTok::Error) return;
+        }
+    }
+
+    // Key/String: raw contents between the quotes (escapes untouched). Number: the literal.
+    std::string_view Text() const { return text_; }
+    bool Escaped() const { return escaped_; }
+    // Nesting depth after the last token (inside the top-level object == 1).
+    int Depth() const { return depth_; }
+    size_t Offset() const { return i_; }
+
+private:
+    void SkipWs(){
+        while (i_ < s_.size()){
+            char c = s_[i_];
+            if (c==' '||c=='\t'||c=='\n'||c=='\r'||c==','){ ++i_; continue; }
+            if (c=='/' && i_+1 < s_.size()){
+                if (s_[i_+1]=='/'){
+                    i_ += 2;
+                    while (i_ < s_.size() && s_[i_] != '\n') ++i_;
+                    continue;
+                }
+                if (s_[i_+1]=='*'){
+                    size_t e = s_.find("*/", i_+2);
+                    i_ = (e == std::string_view::npos) ? s_.size() : e + 2;
+                    continue;
+                }
+            }
+            break;
+        }
+    }
+    bool ScanString(){
+        size_t b = ++i_;
+        escaped_ = false;
+        while (i_ < s_.size()){
+            char c = s_[i_];
+            if (c == '"'){ text_ = s_.substr(b, i_-b); ++i_; return true; }
+            if (c == '\\'){ escaped_ = true; i_ += 2; continue; }
+            ++i_;
+        }
+        i_ = s_.size();
+        return false;
+    }
+    JsonTok Literal(const char* w, JsonTok t){
+        std::string_view lit(w);
+        if (s_.compare(i_, lit.size(), lit) != 0) return JsonTok::Error;
+        i_ += lit.size();
+        text_ = s_.substr(i_ - lit.size(), lit.size()); escaped_ = false;
+        return t;
+    }
+
+    std::string_view s_;
+    size_t i_ = 0;
+    int depth_ = 0;
+    std::string_view text_;
+    bool escaped_ = false;
+};
+
+// Decodes the JSON escapes of a raw string body (\uXXXX incl. surrogate pairs -> UTF-8).
+inline void JsonUnescape(std::string_view raw, std::string& out){
+    out.clear(); out.reserve(raw.size());
+    auto hex4 = [&](size_t at, uint32_t& v){
+        if (at + 4 > raw.size()) return false;
+        v = 0;
+        for (size_t k=0;k<4;++k){
+            char h = raw[at+k]; v <<= 4;
+            if (h>='0'&&h<='9') v |= (uint32_t)(h-'0');
+            else if (h>='a'&&h<='f') v |= (uint32_t)(h-'a'+10);
+            else if (h>='A'&&h<='F') v |= (uint32_t)(h-'A'+10);
+            else return false;
+        }
+        return true;
+    };
+    for (size_t i=0; i<raw.size(); ++i){
+        char c = raw[i];
+        if (c != '\\' || i+1 >= raw.size()){ out.push_back(c); continue; }
+        char e = raw[++i];
+        switch (e){
+            case 'b': out.push_back('\b'); break;
+            case 'f': out.push_back('\f'); break;
+            case 'n': out.push_back('\n'); break;
+            case 'r': out.push_back('\r'); break;
+            case 't': out.push_back('\t'); break;
+            case 'u': {
+                uint32_t cp;
+                if (!hex4(i+1, cp)){ out.push_back('u'); break; }
+                i += 4;
+                if (cp >= 0xD800 && cp < 0xDC00 && i+2 < raw.size() && raw[i+1]=='\\' && raw[i+2]=='u'){
+                    uint32_t lo;
+                    if (hex4(i+3, lo) && lo >= 0xDC00 && lo < 0xE000){
+                        cp = 0x10000 + ((cp - 0xD800) << 10) + (lo - 0xDC00);
+                        i += 6;
+                    }
+                }
+                if (cp >= 0xD800 && cp < 0xE000) cp = 0xFFFD; // lone surrogate
+                if (cp < 0x80) out.push_back((char)cp);
+                else if (cp < 0x800){ out.push_back((char)(0xC0|(cp>>6))); out.push_back((char)(0x80|(cp&0x3F))); }
+                else if (cp < 0x10000){
+                    out.push_back((char)(0xE0|(cp>>12)));
+                    out.push_back((char)(0x80|((cp>>6)&0x3F)));
+                    out.push_back((char)(0x80|(cp&0x3F)));
+                } else {
+                    out.push_back((char)(0xF0|(cp>>18)));
+                    out.push_back((char)(0x80|((cp>>12)&0x3F)));
+                    out.push_back((char)(0x80|((cp>>6)&0x3F)));
+                    out.push_back((char)(0x80|(cp&0x3F)));
+                }
+                break;
+            }
+            default: out.push_back(e); break; // \" \\ \/
+        }
+    }
+}
+
+// Current Key/String token as UTF-8; only allocates/decodes when the raw text had escapes.
+inline std::string JsonText(const JsonScanner& sc){
+    if (!sc.Escaped()) return std::string(sc.Text());
+    std::string s; JsonUnescape(sc.Text(), s); return s;
+}
+
+// Leading signed integer of a Number (or numeric String) token; false if there are no digits.
+inline bool JsonToInt(std::string_view t, int& out){
+    size_t i = 0; bool neg = false;
+    if (i < t.size() && (t[i]=='-' || t[i]=='+')){ neg = (t[i]=='-'); ++i; }
+    size_t b = i; long long v = 0;
+    while (i < t.size() && t[i]>='0' && t[i]<='9'){
+        if (v < 0x7fffffffLL) v = v*10 + (t[i]-'0');
+        ++i;
+    }
+    if (i == b) return false;
+    if (v > 0x7fffffffLL) v = 0x7fffffffLL;
+    out = (int)(neg ? -v : v);
+    return true;
+}
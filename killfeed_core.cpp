@@ -0,0 +1,1102 @@
+// killfeed_core.cpp — parse/dedupe/aggregate pipeline shared by the overlay and the replay tool.
+
+#include "killfeed_core.h"
+#include "json_scan.h"
+#include "metrics.h"
+#include <algorithm>
+#include <climits>
+#include <condition_variable>
+#include <cstdint>
+#include <cstring>
+#include <map>
+#include <thread>
+
+// =========================== Utilities ======================
+// Portable UTF-8 -> wchar_t (UTF-16 with surrogates where wchar_t is 16-bit, UTF-32 otherwise),
+// appended to out.
+static void AppendWide(std::wstring& out, std::string_view s){
+    size_t i = 0, n = s.size();
+    while(i < n){
+        unsigned char c = (unsigned char)s[i];
+        uint32_t cp; int extra;
+        if(c < 0x80){ cp = c; extra = 0; }
+        else if((c & 0xE0) == 0xC0){ cp = c & 0x1F; extra = 1; }
+        else if((c & 0xF0) == 0xE0){ cp = c & 0x0F; extra = 2; }
+        else if((c & 0xF8) == 0xF0){ cp = c & 0x07; extra = 3; }
+        else { out.push_back(L'\xFFFD'); ++i; continue; }
+        if(i + extra >= n){ out.push_back(L'\xFFFD'); break; }
+        bool bad = false;
+        for(int k=1; k<=extra; ++k){
+            unsigned char cc = (unsigned char)s[i+k];
+            if((cc & 0xC0) != 0x80){ bad = true; break; }
+            cp = (cp << 6) | (cc & 0x3F);
+        }
+        if(bad){ out.push_back(L'\xFFFD'); ++i; continue; }
+        i += 1 + extra;
+        if(sizeof(wchar_t) == 2 && cp >= 0x10000){
+            cp -= 0x10000;
+            out.push_back((wchar_t)(0xD800 + (cp >> 10)));
+            out.push_back((wchar_t)(0xDC00 + (cp & 0x3FF)));
+        } else {
+            out.push_back((wchar_t)cp);
+        }
+    }
+}
+
+std::wstring Utf8ToWide(std::string_view s){
+    std::wstring out; out.reserve(s.size());
+    AppendWide(out, s);
+    return out;
+}
+
+// Digits straight into a string (to_wstring_compat goes through a stream).
+static void AppendDecimal(std::wstring& s, unsigned long long v){
+    wchar_t buf[20];
+    int n = 0;
+    do { buf[n++] = (wchar_t)(L'0' + v % 10); v /= 10; } while (v);
+    while (n) s += buf[--n];
+}
+
+std::string WideToUtf8(const std::wstring& w){
+    std::string out; out.reserve(w.size());
+    for(size_t i=0; i<w.size(); ++i){
+        uint32_t cp = (uint32_t)w[i];
+        if(sizeof(wchar_t) == 2 && cp >= 0xD800 && cp < 0xDC00 && i+1 < w.size()){
+            uint32_t lo = (uint32_t)w[i+1];
+            if(lo >= 0xDC00 && lo < 0xE000){ cp = 0x10000 + ((cp - 0xD800) << 10) + (lo - 0xDC00); ++i; }
+        }
+        if(cp < 0x80) out.push_back((char)cp);
+        else if(cp < 0x800){ out.push_back((char)(0xC0 | (cp >> 6))); out.push_back((char)(0x80 | (cp & 0x3F))); }
+        else if(cp < 0x10000){
+            out.push_back((char)(0xE0 | (cp >> 12)));
+            out.push_back((char)(0x80 | ((cp >> 6) & 0x3F)));
+            out.push_back((char)(0x80 | (cp & 0x3F)));
+        } else {
+            out.push_back((char)(0xF0 | (cp >> 18)));
+            out.push_back((char)(0x80 | ((cp >> 12) & 0x3F)));
+            out.push_back((char)(0x80 | ((cp >> 6) & 0x3F)));
+            out.push_back((char)(0x80 | (cp & 0x3F)));
+        }
+    }
+    return out;
+}
+
+std::wstring ToLowerAscii(const std::wstring& s){
+    std::wstring t = s;
+    for(auto& ch : t) if(ch >= L'A' && ch <= L'Z') ch = (wchar_t)(ch - L'A' + L'a');
+    return t;
+}
+
+unsigned long long ParseULL(const std::wstring& w){
+    unsigned long long v = 0;
+    for(wchar_t c : w){
+        if(c < L'0' || c > L'9') break;
+        v = v*10 + (unsigned)(c - L'0');
+    }
+    return v;
+}
+
+unsigned long long ParseULL(std::string_view s){
+    unsigned long long v = 0;
+    for(char c : s){
+        if(c < '0' || c > '9') break;
+        v = v*10 + (unsigned)(c - '0');
+    }
+    return v;
+}
+
+// ========================== API builders ==========================
+std::wstring BuildCharacterByNamePath(const std::wstring& serviceId, const std::wstring& characterName){
+    std::wstring lower = ToLowerAscii(characterName);
+    return L"/" + serviceId + L"/get/ps2:v2/character?name.first_lower=" + lower;
+}
+std::wstring BuildCharactersByNamesPath(const std::wstring& serviceId, const std::vector<std::wstring>& characterNames){
+    std::wstring list;
+    for (size_t i = 0; i < characterNames.size(); ++i){
+        if (i) list += L',';
+        list += ToLowerAscii(characterNames[i]);
+    }
+    return L"/" + serviceId + L"/get/ps2:v2/character?name.first_lower=" + list +
+           L"&c:show=character_id,name.first&c:limit=" + to_wstring_compat(characterNames.size());
+}
+std::wstring BuildLatestDeathJoinedDesc(const std::wstring& serviceId, const std::wstring& charId){
+    return L"/" + serviceId +
+           L"/get/ps2:v2/characters_event/?character_id=" + charId +
+           L"&type=DEATH&c:limit=1&c:sort=timestamp:desc"
+           L"&c:join=character^on:attacker_character_id^to:character_id^inject_at:attacker^show:name.first";
+}
+// Built once per page: one string, sized up front.
+std::wstring BuildDeathsSincePath(const std::wstring& serviceId,
+                                  const std::wstring& charId,
+                                  unsigned long long afterTs,
+                                  int start,
+                                  int limit)
+{
+    if (limit <= 0) limit = 1000;
+    unsigned long long afterTsSafe = (afterTs > 0) ? (afterTs - 1) : 0;
+
+    std::wstring p;
+    p.reserve(serviceId.size() + charId.size() + 160);
+    p += L"/"; p += serviceId;
+    p += L"/get/ps2:v2/characters_event/?character_id="; p += charId;
+    p += L"&type=DEATH&after="; AppendDecimal(p, afterTsSafe);
+    p += L"&c:limit=";          AppendDecimal(p, (unsigned)limit);
+    p += L"&c:start=";          AppendDecimal(p, (unsigned)std::max(start, 0));
+    p += L"&c:sort=timestamp:asc";
+    return p;
+}
+std::wstring BuildCharacterNamesPath(const std::wstring& serviceId, const uint64_t* ids, size_t n){
+    std::wstring p;
+    p.reserve(serviceId.size() + 21 * n + 100);
+    p += L"/"; p += serviceId;
+    p += L"/get/ps2:v2/character?character_id=";
+    for (size_t i = 0; i < n; ++i){
+        if (i) p += L',';
+        AppendDecimal(p, ids[i]);
+    }
+    p += L"&c:show=character_id,name.first&c:limit="; AppendDecimal(p, n);
+    return p;
+}
+
+// ========================== Parsers ============================
+// All parsers walk the response once with JsonScanner; field values are views into the body.
+// Death events keep their attacker name as one (see DeathEvent); names that outlive the body
+// (LatestOne, CharacterName) are copied, as UTF-8.
+
+static std::wstring WideFromToken(const JsonScanner& sc){
+    if (!sc.Escaped()) return Utf8ToWide(sc.Text());
+    return Utf8ToWide(JsonText(sc));
+}
+
+// Moves the scanner to the value of the first key named `key` (any depth). Returns that value's token.
+static JsonTok SeekKey(JsonScanner& sc, std::string_view key){
+    for(;;){
+        JsonTok t = sc.Next();
+        if (t == JsonTok::End || t == JsonTok::Error) return t;
+        if (t == JsonTok::Key && sc.Text() == key) return sc.Next();
+    }
+}
+
+bool ParseCharacterId(const std::string& body, std::wstring& outId){
+    JsonScanner sc(body);
+    if (SeekKey(sc, "character_list") != JsonTok::ArrBegin) return false;
+    if (sc.Next() != JsonTok::ObjBegin) return false;
+    const int objDepth = sc.Depth();
+    for(;;){
+        JsonTok t = sc.Next();
+        if (t == JsonTok::End || t == JsonTok::Error) return false;
+        if (t == JsonTok::ObjEnd && sc.Depth() < objDepth) return false;
+        if (t != JsonTok::Key) continue;
+        bool want = (sc.Depth() == objDepth && sc.Text() == "character_id");
+        JsonTok v = sc.Next();
+        if (want && v == JsonTok::String){
+            outId = WideFromToken(sc);
+            return !outId.empty();
+        }
+        sc.SkipValue(v);
+    }
+}
+
+// Reads name.first from a "name" object; scanner sits just inside it.
+static void ReadNameFirst(JsonScanner& sc, std::string& outName){
+    const int nameDepth = sc.Depth();
+    while (sc.Depth() >= nameDepth){
+        JsonTok t = sc.Next();
+        if (t == JsonTok::End || t == JsonTok::Error) return;
+        if (t != JsonTok::Key) continue;
+        bool want = (sc.Depth() == nameDepth && sc.Text() == "first");
+        JsonTok v = sc.Next();
+        if (want && v == JsonTok::String) outName = JsonText(sc);
+        else sc.SkipValue(v);
+    }
+}
+
+bool ParseCharacterNames(const std::string& body, std::vector<CharacterName>& out){
+    StageTimer timer(Stage::Parse);
+    out.clear();
+    JsonScanner sc(body);
+    if (SeekKey(sc, "character_list") != JsonTok::ArrBegin) return false;
+    const int arrDepth = sc.Depth();
+    for(;;){
+        JsonTok t = sc.Next();
+        if (t == JsonTok::End || t == JsonTok::Error) return false;
+        if (t == JsonTok::ArrEnd) return true;   // nested arrays are skipped whole, so this is the list's
+        if (t != JsonTok::ObjBegin || sc.Depth() != arrDepth + 1){ sc.SkipValue(t); continue; }
+        CharacterName c;
+        const int objDepth = sc.Depth();
+        while (sc.Depth() >= objDepth){
+            JsonTok k = sc.Next();
+            if (k == JsonTok::End || k == JsonTok::Error) return false;
+            if (k != JsonTok::Key || sc.Depth() != objDepth) continue;
+            std::string_view key = sc.Text();
+            JsonTok v = sc.Next();
+            if      (key == "character_id" && v == JsonTok::String) c.id = ParseULL(sc.Text());
+            else if (key == "name" && v == JsonTok::ObjBegin)        ReadNameFirst(sc, c.name);
+            else sc.SkipValue(v);
+        }
+        if (c.id && !c.name.empty()) out.push_back(std::move(c));
+    }
+}
+
+// Reads attacker.name.first from the injected join; scanner sits just inside the "attacker" object.
+static void ReadInjectedAttackerName(JsonScanner& sc, DeathEvent& e){
+    const int attDepth = sc.Depth();
+    while (sc.Depth() >= attDepth){
+        JsonTok t = sc.Next();
+        if (t == JsonTok::End || t == JsonTok::Error) return;
+        if (t != JsonTok::Key) continue;
+        const int keyDepth = sc.Depth();
+        std::string_view k = sc.Text();
+        JsonTok v = sc.Next();
+        if (keyDepth == attDepth && k == "name" && v == JsonTok::ObjBegin) continue;   // descend
+        if (keyDepth == attDepth + 1 && k == "first" && v == JsonTok::String){
+            e.attackerName = sc.Text();
+            e.nameEscaped = sc.Escaped();
+            continue;
+        }
+        sc.SkipValue(v);
+    }
+}
+
+// Fills e from one event object; scanner sits just inside it and is left just past its '}'.
+// Returns whether the object carried an attacker_character_id key.
+static bool ReadDeathObject(JsonScanner& sc, DeathEvent& e){
+    const int objDepth = sc.Depth();
+    bool hasAttacker = false;
+    while (sc.Depth() >= objDepth){
+        JsonTok t = sc.Next();
+        if (t == JsonTok::End || t == JsonTok::Error) break;
+        if (t != JsonTok::Key) continue;
+        std::string_view k = sc.Text();
+        JsonTok v = sc.Next();
+        if (v == JsonTok::String){
+            if      (k == "attacker_character_id"){ hasAttacker = true; e.attackerId = ParseULL(sc.Text()); }
+            else if (k == "is_headshot")            e.isHS = (sc.Text() == "1");
+            else if (k == "event_id")               e.eventId = ParseULL(sc.Text());
+            else if (k == "character_id")           e.victimId = ParseULL(sc.Text());
+            else if (k == "timestamp")              e.ts = ParseULL(sc.Text());
+        } else if (v == JsonTok::ObjBegin && k == "attacker"){
+            ReadInjectedAttackerName(sc, e);
+        } else {
+            sc.SkipValue(v);
+        }
+    }
+    return hasAttacker;
+}
+
+// Calls f(DeathEvent&&) for each event object of the first array in the body; stops when f returns false.
+template<typename F>
+static void ForEachDeathObject(const std::string& body, F&& f){
+    JsonScanner sc(body);
+    JsonTok t;
+    do { t = sc.Next(); } while (t != JsonTok::ArrBegin && t != JsonTok::End && t != JsonTok::Error);
+    if (t != JsonTok::ArrBegin) return;
+    const int arrDepth = sc.Depth();
+    for(;;){
+        t = sc.Next();
+        if (t == JsonTok::End || t == JsonTok::Error || t == JsonTok::ArrEnd) return;
+        if (t != JsonTok::ObjBegin){ sc.SkipValue(t); continue; }
+        if (sc.Depth() != arrDepth + 1) return;
+        DeathEvent e{};
+        if (ReadDeathObject(sc, e) && !f(std::move(e))) return;
+    }
+}
+
+LatestOne ParseLatestJoinedOne(const std::string& body){
+    StageTimer timer(Stage::Parse);
+    LatestOne r{};
+    ForEachDeathObject(body, [&](DeathEvent&& e){
+        r.attackerId   = e.attackerId;
+        r.attackerName = DecodedAttackerName(e);
+        r.eventId      = e.eventId;
+        r.victimId     = e.victimId;
+        r.ts           = e.ts;
+        r.isHS         = e.isHS;
+        r.ok           = (r.ts != 0);
+        return false;
+    });
+    return r;
+}
+
+std::vector<DeathEvent> ParseDeathBatch(const std::string& body){
+    StageTimer timer(Stage::Parse);
+    std::vector<DeathEvent> out;
+    ForEachDeathObject(body, [&](DeathEvent&& e){
+        if (e.ts != 0ULL) out.push_back(std::move(e));
+        return true;
+    });
+    return out;
+}
+
+std::string DecodedAttackerName(const DeathEvent& e){
+    std::string s;
+    if (e.nameEscaped) JsonUnescape(e.attackerName, s);
+    else s = e.attackerName;
+    return s;
+}
+
+std::string_view TextArena::Copy(std::string_view s){
+    if (s.empty()) return {};
+    if (blocks_.empty() || blocks_.back().size - used_ < s.size()){
+        Block b;
+        b.size = std::max(blockBytes_, s.size());
+        b.p.reset(new char[b.size]);
+        blocks_.push_back(std::move(b));
+        used_ = 0;
+    }
+    char* at = blocks_.back().p.get() + used_;
+    std::memcpy(at, s.data(), s.size());
+    used_ += s.size();
+    return std::string_view(at, s.size());
+}
+
+void TextArena::Reset(){
+    used_ = 0;
+    if (blocks_.size() <= 1) return;
+    size_t total = 0;
+    for (const Block& b : blocks_) total += b.size;
+    blocks_.clear();
+    Block b;
+    b.size = total;
+    b.p.reset(new char[total]);
+    blocks_.push_back(std::move(b));
+}
+
+// Byte-level walk that only tracks strings and nesting, to find where each event object of the
+// first array starts and ends; the objects themselves go through ReadDeathObject as usual.
+void DeathBatchParser::Feed(const char* p, size_t n){
+    bytes_ += n;
+    bool carried = inObject_;      // the open object began in an earlier piece
+    size_t objStart = 0;
+    for (size_t i = 0; i < n && state_ != Done; ++i){
+        const char c = p[i];
+        if (inString_){
+            if (escape_) escape_ = false;
+            else if (c == '\\') escape_ = true;
+            else if (c == '"') inString_ = false;
+            continue;
+        }
+        if (c == '"'){ inString_ = true; continue; }
+        if (state_ == BeforeArray){
+            if (c == '[') state_ = InArray;
+            continue;
+        }
+        if (c == '{' || c == '['){
+            if (depth_++ == 0 && c == '{'){ inObject_ = true; carried = false; objStart = i; }
+        } else if (c == '}' || c == ']'){
+            if (depth_ == 0){ state_ = Done; break; }
+            if (--depth_ == 0 && inObject_){
+                inObject_ = false;
+                if (!carried){ Emit(std::string_view(p + objStart, i + 1 - objStart)); continue; }
+                carry_.append(p, i + 1);
+                Emit(carry_);
+                carry_.clear();
+            }
+        }
+    }
+    if (inObject_){
+        if (carried) carry_.append(p, n);
+        else carry_.assign(p + objStart, n - objStart);
+        carryPeak_ = std::max(carryPeak_, carry_.size());
+    }
+}
+
+void DeathBatchParser::Emit(std::string_view object){
+    JsonScanner sc(object);
+    sc.Next();   // '{'
+    DeathEvent e{};
+    if (!ReadDeathObject(sc, e) || e.ts == 0ULL) return;
+    e.attackerName = names_.Copy(e.attackerName);   // object is in the piece or carry_, both reused
+    events.push_back(e);
+}
+
+void DeathBatchParser::Reset(){
+    events.clear();
+    state_ = BeforeArray;
+    depth_ = 0;
+    inString_ = escape_ = inObject_ = false;
+    carry_.clear();
+    bytes_ = 0;
+    names_.Reset();
+}
+
+// ========================== Common apply (de-dupe + counters) =================
+static SynthKey MakeSynthKey(const DeathEvent& e){
+    return SynthKey{(e.ts << 1) | (e.isHS ? 1u : 0u), e.attackerId};
+}
+// event_id when we have one, unless the session mixes in stream deliveries (they never carry it).
+static bool KeyedById(const KillfeedState& st, const DeathEvent& e){
+    return e.eventId != 0 && !st.keyBySynth;
+}
+static bool AlreadySeen(const KillfeedState& st, const DeathEvent& e){
+    if (e.ts < st.dedupeFloor) return true;
+    if (KeyedById(st, e)) return st.seenEventIds.Contains(e.eventId);
+    return st.seenSynth.Contains(MakeSynthKey(e));
+}
+// The synth key always, so a session can switch to keyBySynth (stream mode) without the overlap
+// window it already counted by event_id being counted again.
+static void MarkSeen(KillfeedState& st, const DeathEvent& e){
+    if (KeyedById(st, e)) st.seenEventIds[e.eventId] = e.ts;
+    st.seenSynth.Insert(MakeSynthKey(e));
+}
+
+void SettleDedupe(KillfeedState& st){
+    RaiseDedupeFloor(st, (st.lastDeathTs > st.dedupeWindow) ? st.lastDeathTs - st.dedupeWindow : 0);
+}
+
+void RaiseDedupeFloor(KillfeedState& st, unsigned long long floor){
+    if (floor <= st.dedupeFloor) return;
+    st.dedupeFloor = floor;
+    st.seenEventIds.RetainIf([&](uint64_t, unsigned long long ts){ return ts >= floor; });
+    st.seenSynth.RetainIf([&](const SynthKey& k, FlatEmpty){ return (k.tsHs >> 1) >= floor; });
+}
+
+// ========================== Name cache ============================
+const std::string* NameCache::Find(uint64_t id){
+    auto* it = index_.Find(id);
+    if (!it) return nullptr;
+    lru_.splice(lru_.begin(), lru_, *it);
+    return &(*it)->second;
+}
+
+void NameCache::Put(uint64_t id, std::string_view name){
+    bool inserted = false;
+    auto& it = index_.Upsert(id, &inserted);
+    if (!inserted){
+        lru_.splice(lru_.begin(), lru_, it);
+        if (it->second != name){ it->second.assign(name); ++changes; }
+        return;
+    }
+    lru_.emplace_front(id, name);
+    it = lru_.begin();
+    ++changes;
+    if (lru_.size() > capacity_){
+        index_.Erase(lru_.back().first);
+        lru_.pop_back();
+    }
+}
+
+static const std::string& NameOf(const KillfeedState& st, const AttackerSlot* a){
+    static const std::string resolving = "(resolving\xE2\x80\xA6)";
+    return (a && a->name) ? st.names[a->name - 1] : resolving;
+}
+
+static RankKey RankKeyOf(const KillfeedState& st, uint64_t id, const AttackerSlot& a){
+    return RankKey{a.cnt.tot, a.cnt.hs, &NameOf(st, &a), id};
+}
+
+const std::string& GetNameFor(const KillfeedState& st, uint64_t attackerId){
+    return NameOf(st, st.counts.Find(attackerId));
+}
+
+std::wstring GetDisplayNameFor(const KillfeedState& st, uint64_t attackerId){
+    return Utf8ToWide(GetNameFor(st, attackerId));
+}
+
+// Sets the interned name of a; the caller re-ranks (the ranking key points at the name).
+static void SetName(KillfeedState& st, AttackerSlot& a, std::string_view name){
+    if (!a.name){ st.names.emplace_back(name); a.name = (uint32_t)st.names.size(); }
+    else if (st.names[a.name - 1] != name) st.names[a.name - 1].assign(name);
+}
+
+// Name for an attacker that has none yet: the event's, the cache's, or a later lookup's.
+static void NameAttacker(KillfeedState& st, uint64_t id, AttackerSlot& a, std::string_view name){
+    if (!name.empty()){
+        SetName(st, a, name);
+        if (st.nameCache) st.nameCache->Put(id, name);
+        st.unnamed.Erase(id);
+        return;
+    }
+    if (a.name || id == 0) return;
+    if (const std::string* cached = st.nameCache ? st.nameCache->Find(id) : nullptr) SetName(st, a, *cached);
+    else st.unnamed.Insert(id);
+}
+
+bool ApplyDeathEvent(KillfeedState& st, const DeathEvent& e){
+    if (AlreadySeen(st, e)) return false;
+    if (st.journal) st.journal(e);
+
+    if (st.skipEnvironment && e.attackerId == 0){
+        MarkSeen(st, e);
+        if (e.ts > st.lastDeathTs) st.lastDeathTs = e.ts;
+        return false;
+    }
+
+    // Re-rank: take the attacker's node out under its old key, update, put it back. O(log n),
+    // and the node is reused, so only a new attacker allocates.
+    AttackerSlot& a = st.counts[e.attackerId];
+    auto node = (a.cnt.tot > 0) ? st.ranking.extract(a.rank) : decltype(st.ranking)::node_type{};
+    if (!e.nameEscaped) NameAttacker(st, e.attackerId, a, e.attackerName);
+    else NameAttacker(st, e.attackerId, a, DecodedAttackerName(e));
+    a.cnt.tot += 1;
+    if (e.isHS) a.cnt.hs += 1;
+    if (e.ts > a.lastTs) a.lastTs = e.ts;
+    if (node){ node.value() = RankKeyOf(st, e.attackerId, a); a.rank = st.ranking.insert(std::move(node)).position; }
+    else a.rank = st.ranking.insert(RankKeyOf(st, e.attackerId, a)).first;
+    for (WindowCounts& w : st.windows) w.Add(e.attackerId, e.ts, e.isHS);
+
+    // Gap-fill rows can arrive after a newer death; "last" stays the newest one.
+    if (e.ts >= st.lastDeathTs){
+        st.lastAttackerId   = e.attackerId;
+        st.lastAttackerName = NameOf(st, &a);
+    }
+
+    MarkSeen(st, e);
+
+    if (e.ts > st.lastDeathTs) st.lastDeathTs = e.ts;
+    return true;
+}
+
+void RestoreAttacker(KillfeedState& st, uint64_t id, Counters cnt, unsigned long long lastTs, std::string_view name){
+    bool inserted = false;
+    AttackerSlot& a = st.counts.Upsert(id, &inserted);
+    if (!inserted && a.cnt.tot > 0) st.ranking.erase(a.rank);
+    NameAttacker(st, id, a, name);
+    a.cnt = cnt;
+    a.lastTs = lastTs;
+    a.rank = st.ranking.insert(st.ranking.end(), RankKeyOf(st, id, a));
+}
+
+std::vector<RankedRow> RankNemeses(const KillfeedState& st, size_t maxRows, int minDeaths){
+    std::vector<RankedRow> out;
+    for (const RankKey& k : st.ranking){
+        if (out.size() >= maxRows || k.tot < minDeaths) break;
+        if (k.id == 0 && st.skipEnvironment) continue;
+        out.push_back(RankedRow{k.id, Counters{k.hs, k.tot}});
+    }
+    return out;
+}
+
+// ========================== Rolling windows ================
+WindowCounts::WindowCounts(unsigned seconds)
+    : seconds_(std::max(seconds, (unsigned)kBuckets)), width_(seconds_ / kBuckets), buckets_(kBuckets) {}
+
+void WindowCounts::Count(uint64_t attackerId, bool hs, int delta){
+    Counters& c = counts_[attackerId];
+    c.tot += delta;
+    if (hs) c.hs += delta;
+    if (c.tot == 0) counts_.Erase(attackerId);
+}
+
+std::vector<RankedRow> WindowCounts::Top(size_t maxRows, int minDeaths) const {
+    std::vector<RankedRow> out;
+    counts_.ForEach([&](uint64_t id, const Counters& c){ if (c.tot >= minDeaths) out.push_back(RankedRow{id, c}); });
+    auto before = [](const RankedRow& a, const RankedRow& b){
+        if (a.cnt.tot != b.cnt.tot) return a.cnt.tot > b.cnt.tot;
+        if (a.cnt.hs  != b.cnt.hs)  return a.cnt.hs  > b.cnt.hs;
+        return a.id < b.id;
+    };
+    const size_t n = std::min(maxRows, out.size());
+    std::partial_sort(out.begin(), out.begin() + n, out.end(), before);
+    out.resize(n);
+    return out;
+}
+
+bool WindowCounts::Add(uint64_t attackerId, unsigned long long ts, bool hs){
+    const unsigned long long b = ts / width_;
+    if (b > head_) Advance(ts);
+    else if (!Covers(ts)) return false;
+    buckets_[b % kBuckets].push_back(Death{attackerId, hs});
+    Count(attackerId, hs, +1);
+    ++deaths_;
+    return true;
+}
+
+bool WindowCounts::Advance(unsigned long long now){
+    const unsigned long long b = now / width_;
+    if (b <= head_) return false;
+    bool expired = false;
+    // Buckets head_+1 .. b take the places of the oldest ones; past kBuckets steps that is all of them.
+    const unsigned long long from = (b - head_ > (unsigned long long)kBuckets) ? b - kBuckets + 1 : head_ + 1;
+    for (unsigned long long i = from; i <= b; ++i){
+        std::vector<Death>& old = buckets_[i % kBuckets];
+        for (const Death& d : old) Count(d.attacker, d.hs, -1);
+        deaths_ -= old.size();
+        expired = expired || !old.empty();
+        old.clear();                    // keeps its capacity for the next lap
+    }
+    head_ = b;
+    return expired;
+}
+
+bool AdvanceWindows(KillfeedState& st, unsigned long long now){
+    bool changed = false;
+    for (WindowCounts& w : st.windows) changed = w.Advance(now) || changed;
+    return changed;
+}
+
+std::vector<RankedRow> RankView(const KillfeedState& st, int view, size_t maxRows, int minDeaths){
+    if (view < 0 || (size_t)view >= st.windows.size()) return RankNemeses(st, maxRows, minDeaths);
+    return st.windows[view].Top(maxRows, minDeaths);
+}
+
+std::wstring ViewLabel(const KillfeedState& st, int view){
+    if (view < 0 || (size_t)view >= st.windows.size()) return L"session";
+    return L"last " + to_wstring_compat((int)(st.windows[view].Seconds() / 60)) + L" min";
+}
+
+std::unique_ptr<DisplaySnapshot> BuildSnapshot(const KillfeedState& st, size_t maxRows, int minDeaths, int view){
+    auto snap = std::make_unique<DisplaySnapshot>();
+    snap->status = st.status;
+    snap->line   = st.line;
+    if (view >= 0 && (size_t)view < st.windows.size()) snap->status += L"  -  " + ViewLabel(st, view);
+    for (const RankedRow& r : RankView(st, view, maxRows, minDeaths))
+        snap->rows.push_back(DisplayRow{GetDisplayNameFor(st, r.id), r.cnt});
+    return snap;
+}
+
+// ========================== Core polling (Hybrid PEAK + Batch) ================
+std::wstring KilledByLine(const KillfeedState& st, const std::wstring& suffix){
+    const AttackerSlot* a = st.counts.Find(st.lastAttackerId);
+    Counters c = a ? a->cnt : Counters{};
+    std::wstring s;
+    s.reserve(32 + st.lastAttackerName.size() + suffix.size());
+    s += L"Killed by "; AppendWide(s, st.lastAttackerName);
+    s += L"  -  ";      AppendDecimal(s, (unsigned)c.hs);
+    s += L'/';          AppendDecimal(s, (unsigned)c.tot);
+    s += suffix;
+    return s;
+}
+
+bool KillfeedResolveCharacter(KillfeedState& st, const FetchFn& fetch){
+    if(!st.characterId.empty()) return true;
+    if(st.characterName.empty()){
+        st.status = L"Set character_name in config.json";
+        return false;
+    }
+    std::string body = fetch(BuildCharacterByNamePath(st.serviceId, st.characterName));
+    std::wstring cid;
+    if(!body.empty() && ParseCharacterId(body, cid)){
+        st.characterId = cid;
+        st.status = L"Character ID = " + st.characterId;
+        return true;
+    }
+    st.status = L"Could not resolve character_id from name";
+    return false;
+}
+
+// ========================== Death pages ================
+ChunkFetchFn WholeBodies(FetchFn fetch){
+    return [fetch](const std::wstring& path, const ChunkSink& sink){
+        std::string body = fetch(path);
+        if (body.empty()) return false;
+        sink(body.data(), body.size());
+        return true;
+    };
+}
+
+// One page of deaths into parser (Reset first), parsed while it downloads. True when it arrived
+// and its array was not cut off; the events of a cut-off page are still there (every one complete).
+static bool FetchDeathPage(const ChunkFetchFn& pages, const std::wstring& path, DeathBatchParser& parser){
+    parser.Reset();
+    uint64_t parseUs = 0;
+    bool ok = pages(path, [&](const char* p, size_t n){
+        const uint64_t t0 = MonoMicros();
+        parser.Feed(p, n);
+        parseUs += MonoMicros() - t0;
+    });
+    PipelineMetrics().Record(Stage::Parse, parseUs);
+    return ok && parser.Bytes() > 0 && !parser.Truncated();
+}
+
+// ========================== Parallel catch-up ================
+PageFetcher::PageFetcher(FetchFactory make, int workers)
+    : make_(std::move(make)), workers_(std::max(1, workers)) {}
+
+PageRun PageFetcher::Run(const std::function<std::wstring(int page)>& pagePath, int first, int pageSize,
+                         const std::function<void(const std::vector<DeathEvent>&)>& apply){
+    while ((int)fetch_.size() < workers_) fetch_.push_back(make_());
+
+    struct Page { bool ok = false; std::unique_ptr<DeathBatchParser> parsed; };
+    std::mutex mu;
+    std::condition_variable cv;
+    std::map<int, Page> done;          // fetched, not yet applied
+    int next = first;                  // next page to claim
+    int end = INT_MAX;                 // one past the last page worth fetching
+    int consumer = first;              // next page the caller waits for
+    bool stop = false;
+    PageRun run;
+    const int window = 2 * workers_;
+
+    auto worker = [&](int w){
+        std::unique_lock<std::mutex> lock(mu);
+        while (true){
+            cv.wait(lock, [&]{ return stop || next >= end || next < consumer + window; });
+            if (stop || next >= end) return;
+            const int k = next++;
+            Page p;
+            if (!spare_.empty()){ p.parsed = std::move(spare_.back()); spare_.pop_back(); }
+            lock.unlock();
+            if (!p.parsed) p.parsed = std::make_unique<DeathBatchParser>();
+            p.ok = FetchDeathPage(fetch_[w], pagePath(k), *p.parsed);
+            lock.lock();
+            ++run.requests;
+            if (!p.ok || (int)p.parsed->events.size() < pageSize) end = std::min(end, k + 1);
+            done[k] = std::move(p);
+            cv.notify_all();
+        }
+    };
+    std::vector<std::thread> threads;
+    for (int w = 0; w < workers_; ++w) threads.emplace_back(worker, w);
+
+    for (int k = first; ; ++k){
+        Page p;
+        {
+            std::unique_lock<std::mutex> lock(mu);
+            cv.wait(lock, [&]{ return k >= end || done.count(k); });
+            auto it = done.find(k);
+            if (it == done.end()) break;
+            p = std::move(it->second);
+            done.erase(it);
+            consumer = k + 1;
+            cv.notify_all();
+        }
+        const std::vector<DeathEvent>& events = p.parsed->events;
+        if (p.ok || !events.empty()) apply(events);
+        const size_t got = events.size();
+        { std::lock_guard<std::mutex> lock(mu); spare_.push_back(std::move(p.parsed)); }
+        if (!p.ok){ run.failed = true; break; }
+        ++run.pages;
+        if ((int)got < pageSize) break;
+    }
+
+    { std::lock_guard<std::mutex> lock(mu); stop = true; }
+    cv.notify_all();
+    for (std::thread& t : threads) t.join();
+    return run;
+}
+
+// Renames a counted attacker in place: out of the ranking under the old name, back in under the new.
+static void RenameAttacker(KillfeedState& st, uint64_t id, std::string_view name){
+    AttackerSlot* a = st.counts.Find(id);
+    if (!a) return;
+    auto node = (a->cnt.tot > 0) ? st.ranking.extract(a->rank) : decltype(st.ranking)::node_type{};
+    SetName(st, *a, name);
+    if (node){ node.value() = RankKeyOf(st, id, *a); a->rank = st.ranking.insert(std::move(node)).position; }
+    if (id == st.lastAttackerId){
+        st.lastAttackerName.assign(name);
+        st.line = KilledByLine(st, L"");
+    }
+}
+
+// One lookup for the unnamed attackers of every state, highest ranked first (and the states taking
+// turns), so after a big catch-up the rows on screen get their names first.
+static NameLookup ResolveNames(KillfeedState* const* states, size_t n, const FetchFn& fetch, size_t maxBatch){
+    NameLookup r;
+    std::vector<std::vector<uint64_t>> wanted(n);
+    size_t total = 0;
+    for (size_t i = 0; i < n; ++i){
+        const KillfeedState& st = *states[i];
+        if (st.unnamed.empty()) continue;
+        for (auto it = st.ranking.begin(); it != st.ranking.end() && wanted[i].size() < maxBatch; ++it)
+            if (st.unnamed.Contains(it->id)) wanted[i].push_back(it->id);
+        if (wanted[i].empty())
+            st.unnamed.ForEach([&](uint64_t id, FlatEmpty){ if (wanted[i].size() < maxBatch) wanted[i].push_back(id); });
+        total += wanted[i].size();
+    }
+    if (!total) return r;
+    std::vector<uint64_t> ids;
+    FlatSet<uint64_t> picked;
+    for (size_t k = 0; ids.size() < maxBatch && k < maxBatch; ++k)
+        for (size_t i = 0; i < n && ids.size() < maxBatch; ++i)
+            if (k < wanted[i].size() && picked.Insert(wanted[i][k])) ids.push_back(wanted[i][k]);
+
+    std::string body = fetch(BuildCharacterNamesPath(states[0]->serviceId, ids.data(), ids.size()));
+    ++r.requests;
+    std::vector<CharacterName> found;
+    if (body.empty() || !ParseCharacterNames(body, found)){ r.failed = true; return r; }
+    for (const CharacterName& c : found){
+        if (!picked.Contains(c.id)) continue;
+        for (size_t i = 0; i < n; ++i){
+            KillfeedState& st = *states[i];
+            if (!st.unnamed.Erase(c.id)) continue;
+            if (st.nameCache) st.nameCache->Put(c.id, c.name);
+            RenameAttacker(st, c.id, c.name);
+            ++r.resolved;
+        }
+    }
+    for (uint64_t id : ids)
+        for (size_t i = 0; i < n; ++i)
+            if (states[i]->unnamed.Erase(id)) RenameAttacker(*states[i], id, "(unknown)");
+    return r;
+}
+
+NameLookup KillfeedResolveNames(KillfeedState& st, const FetchFn& fetch, size_t maxBatch){
+    KillfeedState* one = &st;
+    return ResolveNames(&one, 1, fetch, maxBatch);
+}
+
+// Every squad member without a character id, in one name lookup. Members the lookup does not
+// know get the same status a single character would.
+bool SquadResolveCharacters(Squad& sq, const FetchFn& fetch){
+    if (sq.members.size() == 1) return KillfeedResolveCharacter(*sq.members[0], fetch);
+    std::vector<std::wstring> names;
+    for (const auto& m : sq.members)
+        if (m->characterId.empty() && !m->characterName.empty()) names.push_back(m->characterName);
+    if (!names.empty()){
+        std::string body = fetch(BuildCharactersByNamesPath(sq.members[0]->serviceId, names));
+        std::vector<CharacterName> found;
+        bool ok = !body.empty() && ParseCharacterNames(body, found);
+        for (const auto& m : sq.members){
+            if (!m->characterId.empty() || m->characterName.empty()) continue;
+            const std::wstring want = ToLowerAscii(m->characterName);
+            for (const CharacterName& c : found)
+                if (ToLowerAscii(Utf8ToWide(c.name)) == want){ m->characterId = to_wstring_compat(c.id); break; }
+            m->status = !m->characterId.empty() ? L"Character ID = " + m->characterId
+                      : ok ? L"Could not resolve character_id from name" : L"Request failed, retrying";
+        }
+    }
+    bool any = false;
+    for (const auto& m : sq.members){
+        if (m->characterName.empty()) m->status = L"Set character_name in config.json";
+        any = any || !m->characterId.empty();
+    }
+    return any;
+}
+
+// "  (+N)", or "  (+1 peek, +N batch)" when the poll also counted the peeked death.
+static std::wstring AppliedSuffix(bool peek, int batch){
+    std::wstring s = peek ? L"  (+1 peek, +" : L"  (+";
+    AppendDecimal(s, (unsigned)batch);
+    s += peek ? L" batch)" : L")";
+    return s;
+}
+
+// The poll itself, for one character or a squad: every state in states has its characterId, and
+// the deaths of all of them come from one query that starts at watermark.
+static PollResult PollStates(KillfeedState* const* states, size_t n, unsigned long long& watermark,
+                             const FetchFn& fetch, const std::function<void()>& onChange, PageFetcher* catchUp,
+                             const ChunkFetchFn& pages, DeathBatchParser& page){
+    StageTimer timer(Stage::Poll);
+    PipelineMetrics().Add(Counter::Polls);
+    PollResult res;
+    const std::wstring& serviceId = states[0]->serviceId;
+    std::wstring charIds;
+    std::vector<uint64_t> victims(n);
+    for (size_t i = 0; i < n; ++i){
+        if (i) charIds += L',';
+        charIds += states[i]->characterId;
+        victims[i] = ParseULL(states[i]->characterId);
+    }
+    // A lone character takes every row, as it always has; a squad sorts them by character_id.
+    auto stateOf = [&](const DeathEvent& e) -> int {
+        if (n == 1) return 0;
+        for (size_t i = 0; i < n; ++i) if (victims[i] == e.victimId) return (int)i;
+        return -1;
+    };
+    std::vector<int> appliedBatch(n, 0);
+    std::vector<bool> appliedPeek(n, false);
+    auto counted = [&](int i, const DeathEvent& e){
+        if (i < 0 || !ApplyDeathEvent(*states[i], e)) return false;
+        ++res.applied;
+        PipelineMetrics().Add(Counter::Events);
+        if (e.ts > res.newestTs) res.newestTs = e.ts;
+        return true;
+    };
+    auto newestSeen = [&]{
+        for (size_t i = 0; i < n; ++i) watermark = std::max(watermark, states[i]->lastDeathTs);
+    };
+
+    // First poll of the session: start at the latest death.
+    if (watermark == 0){
+        std::string peekJ = fetch(BuildLatestDeathJoinedDesc(serviceId, charIds));
+        ++res.requests;
+        LatestOne latest = ParseLatestJoinedOne(peekJ);
+        if(!latest.ok){
+            res.failed = peekJ.empty();
+            for (size_t i = 0; i < n; ++i) states[i]->status = L"No latest death found";
+            return res;
+        }
+
+        DeathEvent pe{};
+        pe.attackerId   = latest.attackerId;
+        pe.attackerName = latest.attackerName;
+        pe.isHS         = latest.isHS;
+        pe.eventId      = latest.eventId;
+        pe.ts           = latest.ts;
+        pe.victimId     = latest.victimId;
+        const int i = stateOf(pe);
+        if (counted(i, pe)){
+            appliedPeek[i] = true;
+            states[i]->line   = KilledByLine(*states[i], L"  (+1)");
+            states[i]->status = L"Peek applied";
+            if (onChange) onChange();
+        }
+        newestSeen();
+    }
+
+    // Pages cover everything since the watermark as it was when the poll started. Fixed for the
+    // whole loop: c:start offsets are relative to it, and ascending order keeps them stable while
+    // new deaths land at the end.
+    const int PAGE = 1000;
+    const unsigned long long sinceTs = watermark;
+    int start = 0;
+
+    auto applyPage = [&](const std::vector<DeathEvent>& events){
+        StageTimer apply(Stage::Apply);
+        PipelineMetrics().Add(Counter::Pages);
+        for (const DeathEvent& e : events){
+            const int i = stateOf(e);
+            if (counted(i, e)) ++appliedBatch[i];
+        }
+    };
+
+    const ChunkFetchFn pageFetch = pages ? pages : WholeBodies(fetch);
+    const std::vector<DeathEvent>& events = page.events;   // reset by every FetchDeathPage
+    while(true){
+        const bool ok = FetchDeathPage(pageFetch, BuildDeathsSincePath(serviceId, charIds, sinceTs, start, PAGE), page);
+        ++res.requests;
+        if (ok || !events.empty()) applyPage(events);
+        if (!ok){ res.failed = true; break; }
+
+        if ((int)events.size() < PAGE) break;
+        start += PAGE;
+
+        // A full page means a backlog (late start, long disconnect): fetch the rest in parallel.
+        if (catchUp && catchUp->Workers() > 1){
+            PageRun run = catchUp->Run([&](int k){
+                return BuildDeathsSincePath(serviceId, charIds, sinceTs, k * PAGE, PAGE);
+            }, start / PAGE, PAGE, applyPage);
+            res.requests += run.requests;
+            res.failed = res.failed || run.failed;
+            break;
+        }
+    }
+
+    for (size_t i = 0; i < n; ++i) SettleDedupe(*states[i]);
+    newestSeen();
+
+    NameLookup names = ResolveNames(states, n, fetch, 100);
+    res.requests += names.requests;
+
+    bool changed = false;
+    for (size_t i = 0; i < n; ++i){
+        KillfeedState& st = *states[i];
+        if (res.failed && appliedBatch[i] == 0 && !appliedPeek[i]){
+            st.status = L"Request failed, retrying";
+        } else if (appliedBatch[i] == 0 && !appliedPeek[i]){
+            st.status = L"No new deaths";
+        } else if (appliedBatch[i] > 0 && appliedPeek[i]){
+            st.line   = KilledByLine(st, AppliedSuffix(true, appliedBatch[i]));
+            st.status = L"Updated (peek+batch)";
+            changed = true;
+        } else if (appliedBatch[i] > 0){
+            st.line   = KilledByLine(st, AppliedSuffix(false, appliedBatch[i]));
+            st.status = L"Updated (batch)";
+            changed = true;
+        }
+    }
+    if (changed && onChange) onChange();
+    return res;
+}
+
+PollResult KillfeedPoll(KillfeedState& st, const FetchFn& fetch, const std::function<void()>& onChange,
+                        PageFetcher* catchUp, const ChunkFetchFn& pages){
+    const int lookup = (st.characterId.empty() && !st.characterName.empty()) ? 1 : 0;
+    if(!KillfeedResolveCharacter(st, fetch)){
+        PollResult res;
+        res.requests = lookup;
+        res.failed = true;
+        return res;
+    }
+    KillfeedState* one = &st;
+    unsigned long long watermark = st.lastDeathTs;
+    PollResult res = PollStates(&one, 1, watermark, fetch, onChange, catchUp, pages, st.pollPage);
+    res.requests += lookup;
+    return res;
+}
+
+PollResult SquadPoll(Squad& sq, const FetchFn& fetch, const std::function<void()>& onChange, PageFetcher* catchUp,
+                     const ChunkFetchFn& pages){
+    if (sq.members.size() == 1) return KillfeedPoll(*sq.members[0], fetch, onChange, catchUp, pages);
+    PollResult res;
+    std::vector<KillfeedState*> ready;
+    bool missing = false;
+    for (const auto& m : sq.members){
+        if (!m->characterId.empty()) ready.push_back(m.get());
+        else missing = missing || !m->characterName.empty();
+    }
+    if (missing){
+        SquadResolveCharacters(sq, fetch);
+        res.requests = 1;
+        ready.clear();
+        for (const auto& m : sq.members) if (!m->characterId.empty()) ready.push_back(m.get());
+    }
+    if (ready.empty()){ res.failed = true; return res; }
+
+    // Restored sessions can stop at different deaths; the combined query starts at the oldest.
+    if (sq.watermark == 0){
+        for (KillfeedState* st : ready)
+            if (st->lastDeathTs && (!sq.watermark || st->lastDeathTs < sq.watermark)) sq.watermark = st->lastDeathTs;
+    }
+    PollResult r = PollStates(ready.data(), ready.size(), sq.watermark, fetch, onChange, catchUp, pages, sq.pollPage);
+    r.requests += res.requests;
+    return r;
+}
+
+std::unique_ptr<DisplaySnapshot> BuildSquadSnapshot(const Squad& sq, size_t maxRows, int minDeaths, int view){
+    auto snap = BuildSnapshot(*sq.members[0], maxRows, minDeaths, view);
+    if (sq.members.size() == 1) return snap;
+    snap->line = sq.members[0]->characterName + L": " + snap->line;
+    for (size_t i = 1; i < sq.members.size(); ++i){
+        const KillfeedState& st = *sq.members[i];
+        DisplayBlock b;
+        b.line = st.characterName + L": " + st.line;
+        for (const RankedRow& r : RankView(st, view, maxRows, minDeaths))
+            b.rows.push_back(DisplayRow{GetDisplayNameFor(st, r.id), r.cnt});
+        snap->squad.push_back(std::move(b));
+    }
+    return snap;
+}
+
+// ========================== Poll scheduling ================
+PollScheduler::PollScheduler(int baseMs, int maxMs, uint64_t seed)
+    : base_(std::max(100, baseMs)), max_(std::max(std::max(100, baseMs), maxMs)), rng_(seed | 1) {}
+
+// +-15%, so many overlays started together do not poll in lockstep.
+int PollScheduler::Jitter(int ms){
+    rng_ += 0x9E3779B97F4A7C15ull;
+    double u = (double)(MixU64(rng_) >> 11) / 9007199254740992.0;   // [0,1)
+    return std::max(100, (int)(ms * (0.85 + 0.30 * u)));
+}
+
+int PollScheduler::Next(const PollResult& r, uint64_t nowMs){
+    if (!startMs_) startMs_ = nowMs;
+    if (r.failed){
+        errors_ = std::min(errors_ + 1, 16);
+        long long d = (long long)base_ << errors_;
+        return Jitter((int)std::min<long long>(d, std::max(errorMaxMs, base_)));
+    }
+    errors_ = 0;
+    if (r.applied > 0){ lastDeathMs_ = nowMs; idle_ = 0; }
+
+    const uint64_t since = nowMs - (lastDeathMs_ ? lastDeathMs_ : startMs_);
+    if (lastDeathMs_ && since < (uint64_t)hotMs) return Jitter(fastMs > 0 ? fastMs : std::max(250, base_ / 2));
+    if (since < (uint64_t)quietAfterMs){ idle_ = 0; return Jitter(base_); }
+    idle_ = idle_ ? std::min(max_, idle_ * 3 / 2) : base_;
+    return Jitter(idle_);
+}
+
+void PollStats::Record(const PollResult& r, uint64_t nowUnixMs, uint64_t nowMs){
+    if (!startMs_.load()) startMs_ = nowMs;
+    lastMs_ = nowMs;
+    requests_ += (uint64_t)r.requests;
+    if (!r.newestTs || nowUnixMs < r.newestTs * 1000) return;
+    std::lock_guard<std::mutex> lock(mu_);
+    double ms = (double)(nowUnixMs - r.newestTs * 1000);
+    if (latency_.size() < 256) latency_.push_back(ms);
+    else latency_[next_++ % 256] = ms;
+}
+
+double PollStats::RequestsPerHour() const {
+    uint64_t span = lastMs_.load() - startMs_.load();
+    return span ? requests_.load() * 3600000.0 / span : 0.0;
+}
+
+double PollStats::MedianLatencyMs() const {
+    std::lock_guard<std::mutex> lock(mu_);
+    if (latency_.empty()) return 0;
+    std::vector<double> v = latency_;
+    std::nth_element(v.begin(), v.begin() + v.size() / 2, v.end());
+    return v[v.size() / 2];
+}
@@ -0,0 +1,442 @@
+// killfeed_core.h — platform-free parse/dedupe/aggregate pipeline for the deaths overlay.
+// No Win32 here: the overlay (main.cpp) and the Linux replay tool (replay.cpp) both link this.
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <deque>
+#include <list>
+#include <set>
+#include <functional>
+#include <memory>
+#include <atomic>
+#include <mutex>
+#include <sstream>
+#include <cstddef>
+#include <cstdint>
+#include "flat_table.h"
+
+// =========================== Utilities ======================
+template<typename T>
+std::wstring to_wstring_compat(T v){ std::wstringstream ss; ss<<v; return ss.str(); }
+
+std::wstring Utf8ToWide(std::string_view s);
+std::string  WideToUtf8(const std::wstring& w);
+std::wstring ToLowerAscii(const std::wstring& s);
+unsigned long long ParseULL(const std::wstring& w);
+unsigned long long ParseULL(std::string_view s);
+
+// ========================== API builders ==========================
+std::wstring BuildCharacterByNamePath(const std::wstring& serviceId, const std::wstring& characterName);
+std::wstring BuildCharactersByNamesPath(const std::wstring& serviceId, const std::vector<std::wstring>& characterNames);
+// charId may be a comma-separated list of ids (one query for a whole squad).
+std::wstring BuildLatestDeathJoinedDesc(const std::wstring& serviceId, const std::wstring& charId);
+std::wstring BuildDeathsSincePath(const std::wstring& serviceId, const std::wstring& charId,
+                                  unsigned long long afterTs, int start, int limit);
+std::wstring BuildCharacterNamesPath(const std::wstring& serviceId, const uint64_t* ids, size_t n);
+
+// ========================== Parsers ============================
+// Character and event ids are numeric in Census; they are parsed once into integers here and
+// never handled as strings again. Attacker id 0 is the environment (fall damage, etc.).
+// Names stay UTF-8 from the response to KillfeedState; only what is drawn gets widened.
+struct LatestOne {
+    uint64_t attackerId = 0;
+    std::string attackerName;
+    uint64_t eventId = 0;
+    uint64_t victimId = 0;
+    unsigned long long ts = 0;
+    bool isHS = false;
+    bool ok = false;
+};
+
+struct DeathEvent {
+    uint64_t attackerId = 0;
+    // As it appears in the response, pointing into the body ParseDeathBatch read (or the
+    // DeathBatchParser that made the event): valid as long as that is. Empty when the query joins
+    // no names. nameEscaped: it still has JSON \-escapes in it; DecodedAttackerName decodes.
+    std::string_view attackerName;
+    bool nameEscaped = false;
+    bool isHS = false;
+    uint64_t eventId = 0;       // 0 = none (stream payloads never carry one)
+    uint64_t victimId = 0;      // character_id: whose death it is, when one query covers a squad
+    unsigned long long ts = 0;
+};
+
+bool ParseCharacterId(const std::string& body, std::wstring& outId);
+// character_id + name.first of every entry of a character lookup; false if the body has no
+// character_list or ends (truncated, garbled) before the list closes.
+struct CharacterName { uint64_t id = 0; std::string name; };
+bool ParseCharacterNames(const std::string& body, std::vector<CharacterName>& out);
+LatestOne ParseLatestJoinedOne(const std::string& body);
+// The events' names point into body.
+std::vector<DeathEvent> ParseDeathBatch(const std::string& body);
+std::string DecodedAttackerName(const DeathEvent& e);
+
+// Bump storage for strings that live as long as one page: Copy hands out views that stay put
+// until Reset. Reset keeps one block big enough for everything the last round held, so once
+// warmed up a page's strings cost no allocation.
+class TextArena {
+public:
+    explicit TextArena(size_t blockBytes = 16384) : blockBytes_(blockBytes) {}
+    std::string_view Copy(std::string_view s);
+    void Reset();
+    size_t Blocks() const { return blocks_.size(); }
+private:
+    struct Block { std::unique_ptr<char[]> p; size_t size = 0; };
+    std::vector<Block> blocks_;
+    size_t used_ = 0;             // of blocks_.back()
+    size_t blockBytes_;
+};
+
+// ParseDeathBatch for a body that arrives in pieces: Feed each piece as it comes in (any size,
+// cut anywhere) and the events show up in events as soon as their closing brace is in. Objects
+// are parsed in place in the piece; only one cut by a piece boundary is copied, so nothing holds
+// the whole body. Same events as ParseDeathBatch on the joined body; their names are copied into
+// the parser and stay valid until Reset. Reset starts the next page and keeps every buffer, so a
+// parser used for page after page stops allocating once it has seen a full one.
+class DeathBatchParser {
+public:
+    void Feed(const char* p, size_t n);
+    void Reset();
+    bool Complete() const { return state_ == Done; }          // the event array is closed
+    bool Truncated() const { return state_ == InArray; }      // array opened, not closed (yet)
+    size_t Bytes() const { return bytes_; }
+    size_t CarryPeak() const { return carryPeak_; }           // largest object held across pieces
+    std::vector<DeathEvent> events;
+private:
+    void Emit(std::string_view object);
+    enum State { BeforeArray, InArray, Done };
+    State  state_ = BeforeArray;
+    int    depth_ = 0;            // inside the array: 0 between elements
+    bool   inString_ = false, escape_ = false;
+    bool   inObject_ = false;     // an event object is open
+    std::string carry_;           // its bytes from earlier pieces
+    size_t bytes_ = 0, carryPeak_ = 0;
+    TextArena names_;             // the events' attackerName bytes
+};
+
+// ========================== Name cache ============================
+// Attacker names by character id, shared by everything in the process that tracks deaths and
+// saved across sessions (SaveNameCache). Past capacity the least recently used name goes first.
+// UTF-8.
+class NameCache {
+public:
+    explicit NameCache(size_t capacity = 8192) : capacity_(capacity ? capacity : 1) {}
+    const std::string* Find(uint64_t id);      // and marks it used
+    void Put(uint64_t id, std::string_view name);
+    size_t size() const { return index_.size(); }
+    size_t capacity() const { return capacity_; }
+    uint64_t changes = 0;                      // Puts that added or changed a name, lifetime
+    template<typename F> void ForEachOldestFirst(F&& f) const {
+        for (auto it = lru_.rbegin(); it != lru_.rend(); ++it) f(it->first, it->second);
+    }
+private:
+    using Entry = std::pair<uint64_t, std::string>;
+    std::list<Entry> lru_;                     // most recently used first
+    FlatTable<uint64_t, std::list<Entry>::iterator> index_;
+    size_t capacity_;
+};
+
+// ========================== Session state ============================
+struct Counters { int hs=0; int tot=0; };
+
+// Ranking order: deaths desc, headshots desc, name asc, id asc. name points into
+// KillfeedState::names (a deque, so entries never move) or at a shared placeholder.
+struct RankKey {
+    int tot = 0, hs = 0;
+    const std::string* name = nullptr;
+    uint64_t id = 0;
+};
+struct RankOrder {
+    bool operator()(const RankKey& a, const RankKey& b) const {
+        if (a.tot != b.tot) return a.tot > b.tot;
+        if (a.hs  != b.hs)  return a.hs  > b.hs;
+        if (int c = a.name->compare(*b.name)) return c < 0;
+        return a.id < b.id;
+    }
+};
+
+// One row of the attacker table: counters, interned display name and the newest death, together.
+struct AttackerSlot {
+    Counters cnt;
+    uint32_t name = 0;                  // index+1 into KillfeedState::names, 0 = not known yet
+    unsigned long long lastTs = 0;
+    std::set<RankKey, RankOrder>::iterator rank;   // valid once cnt.tot > 0
+};
+
+// Synthetic dedupe key for events without an event_id: timestamp and headshot bit packed into
+// one word, attacker id in the other.
+struct SynthKey {
+    uint64_t tsHs = 0;
+    uint64_t attacker = 0;
+    bool operator==(const SynthKey& o) const { return tsHs == o.tsHs && attacker == o.attacker; }
+};
+struct SynthKeyHash { uint64_t operator()(const SynthKey& k) const { return MixU64(k.tsHs ^ MixU64(k.attacker)); } };
+
+struct RankedRow { uint64_t id; Counters cnt; };
+
+// Deaths per attacker over the last `seconds`, next to the session totals. The window is a ring of
+// kBuckets time buckets, each holding the deaths that landed in it; when the clock moves past a
+// bucket its deaths are subtracted again, so every death costs one add and one expiry (a table
+// update each) however long the session runs. The edge moves in bucket steps (20 s for a 10 minute
+// window). There is no standing ranking: a window holds a few hundred attackers at most, and Top
+// sorts the ones it returns when a snapshot asks.
+class WindowCounts {
+public:
+    static constexpr int kBuckets = 30;
+    explicit WindowCounts(unsigned seconds);
+
+    unsigned Seconds() const { return seconds_; }
+    // One death; ignored (false) when ts is already outside the window. A newer ts moves the window.
+    bool Add(uint64_t attackerId, unsigned long long ts, bool hs);
+    // Moves the window's end up to now (never back). True when deaths expired.
+    bool Advance(unsigned long long now);
+    // Whether ts would still be counted.
+    bool Covers(unsigned long long ts) const { return ts / width_ + kBuckets > head_; }
+
+    // Deaths desc, headshots desc, id asc (not names: those can change while a window is open).
+    std::vector<RankedRow> Top(size_t maxRows, int minDeaths = 1) const;
+    size_t Deaths() const { return deaths_; }
+    size_t Attackers() const { return counts_.size(); }
+
+private:
+    struct Death { uint64_t attacker; bool hs; };
+    void Count(uint64_t attackerId, bool hs, int delta);
+
+    unsigned seconds_;
+    unsigned long long width_;          // seconds per bucket
+    unsigned long long head_ = 0;       // bucket number (ts / width_) of the newest bucket
+    std::vector<std::vector<Death>> buckets_;   // bucket b lives at b % kBuckets
+    FlatTable<uint64_t, Counters> counts_;
+    size_t deaths_ = 0;
+};
+
+// Everything one tracked character accumulates during a session. The overlay keeps one
+// of these as a global; the replay tool builds a fresh one per run. Move-only: ranking
+// points into names.
+struct KillfeedState {
+    KillfeedState() = default;
+    KillfeedState(KillfeedState&&) = default;
+    KillfeedState& operator=(KillfeedState&&) = default;
+    KillfeedState(const KillfeedState&) = delete;
+    KillfeedState& operator=(const KillfeedState&) = delete;
+
+    // Settings (copied from config)
+    std::wstring serviceId;
+    std::wstring characterName;
+    bool skipEnvironment = true;
+
+    // Display
+    std::wstring status = L"Waiting for data…";
+    std::wstring line   = L"(no deaths yet)";
+    std::wstring characterId;
+
+    // De-dup state. keyBySynth: ignore event_id and key everything on ts|attacker|hs, so REST
+    // rows and stream deliveries (which have no event_id) share one key space.
+    // lastDeathTs is the watermark. Events older than dedupeFloor are rejected on their timestamp
+    // alone; exact keys are only kept for the overlap window above it (see SettleDedupe).
+    bool keyBySynth = false;
+    unsigned long long lastDeathTs  = 0;
+    unsigned long long dedupeFloor  = 0;
+    unsigned long long dedupeWindow = 60;       // seconds below the watermark kept exactly
+    FlatTable<uint64_t, unsigned long long> seenEventIds;   // event_id -> timestamp
+    FlatSet<SynthKey, SynthKeyHash>         seenSynth;      // every event, event_id or not
+
+    // Per-attacker counters + interned names, and every counted attacker in display order
+    // (updated by ApplyDeathEvent, so reading the top rows never sorts).
+    FlatTable<uint64_t, AttackerSlot> counts;
+    std::deque<std::string>           names;      // UTF-8
+    std::set<RankKey, RankOrder>      ranking;
+    uint64_t     lastAttackerId   = 0;
+    std::string  lastAttackerName = "(unknown)";
+
+    // Names come from nameCache or a batched lookup (KillfeedResolveNames); the per-tick death
+    // query does not join them in. unnamed: counted attackers still waiting for that lookup.
+    NameCache*   nameCache = nullptr;
+    FlatSet<uint64_t> unnamed;
+
+    // Called with every event that got past dedupe, before it is applied (SessionStore journals them).
+    std::function<void(const DeathEvent&)> journal;
+
+    // Rolling windows (config windows_minutes), fed by ApplyDeathEvent and moved on by AdvanceWindows.
+    // Not saved with the session: after a restart they refill from the journal (or the history).
+    std::vector<WindowCounts> windows;
+
+    // KillfeedPoll's page buffers (events and their names), kept from poll to poll so a
+    // warmed-up session parses its pages without allocating.
+    DeathBatchParser pollPage;
+};
+
+// An attacker's name as kept (UTF-8), and widened for drawing.
+const std::string& GetNameFor(const KillfeedState& st, uint64_t attackerId);
+std::wstring GetDisplayNameFor(const KillfeedState& st, uint64_t attackerId);
+bool ApplyDeathEvent(KillfeedState& st, const DeathEvent& e);
+// Call once everything up to lastDeathTs has been applied (end of a poll, each live stream event):
+// moves dedupeFloor to lastDeathTs - dedupeWindow and forgets the exact keys below it.
+void SettleDedupe(KillfeedState& st);
+// Moves dedupeFloor up to floor (never down) and forgets the exact keys below it.
+void RaiseDedupeFloor(KillfeedState& st, unsigned long long floor);
+// Puts back one attacker from a saved session. Cheapest when called in ranking order.
+void RestoreAttacker(KillfeedState& st, uint64_t id, Counters cnt, unsigned long long lastTs, std::string_view name);
+
+// The first maxRows attackers with at least minDeaths deaths, in ranking order; environment
+// rows honor skipEnvironment. Cost depends on maxRows, not on how many attackers there are.
+std::vector<RankedRow> RankNemeses(const KillfeedState& st, size_t maxRows, int minDeaths = 1);
+// The same over st.windows[window]; view < 0 (or no such window) ranks the session totals.
+std::vector<RankedRow> RankView(const KillfeedState& st, int view, size_t maxRows, int minDeaths = 1);
+// Moves every window's end to now (unix seconds; the caller's clock, or the newest death when
+// replaying). True when a ranking changed.
+bool AdvanceWindows(KillfeedState& st, unsigned long long now);
+// "last 10 min" for a window index, "session" otherwise.
+std::wstring ViewLabel(const KillfeedState& st, int view);
+
+// ========================== Polling (Hybrid PEAK + Batch) ================
+// fetch performs one GET of an API path and returns the body ("" on failure).
+// onChange is called whenever status/line/counters changed mid-poll so the caller can repaint.
+// Only the first poll of a session peeks at the latest death (to start there instead of at the
+// beginning of history); after that a tick is one "deaths since the watermark" page, plus more
+// pages only when a page comes back full, plus one batched name lookup when it counted attackers
+// the name cache did not know (the page query carries no names).
+using FetchFn = std::function<std::string(const std::wstring& path)>;
+// Pages of deaths are fetched this way instead: the body goes to sink piece by piece as it
+// downloads and is parsed on the fly (DeathBatchParser). False on transport failure.
+using ChunkSink    = std::function<void(const char* data, size_t n)>;
+using ChunkFetchFn = std::function<bool(const std::wstring& path, const ChunkSink& sink)>;
+// For a fetch that only has whole bodies: hands each one to sink in one piece ("" = failure).
+ChunkFetchFn WholeBodies(FetchFn fetch);
+struct PollResult {
+    int  requests = 0;
+    int  applied  = 0;                 // deaths counted by this poll
+    bool failed   = false;             // a request came back empty (network/API error)
+    unsigned long long newestTs = 0;   // newest death counted, 0 if none
+};
+
+// Catch-up pages on several connections at once. Each worker owns a ChunkFetchFn made by the factory
+// (its own connection, kept across runs), claims the next page, downloads and parses it while
+// the others do the same, and never runs more than 2*workers pages ahead of the caller. The
+// caller gets the pages strictly in page order, so with ascending pages deaths are still applied
+// oldest first. The first short or failed page ends the run.
+using FetchFactory = std::function<ChunkFetchFn()>;
+struct PageRun { int requests = 0; int pages = 0; bool failed = false; };
+class PageFetcher {
+public:
+    PageFetcher(FetchFactory make, int workers);
+    int Workers() const { return workers_; }
+    // pagePath(k) is the path of page k; apply is called on the calling thread for pages
+    // first, first+1, ... until (and including) the first one with fewer than pageSize events.
+    PageRun Run(const std::function<std::wstring(int page)>& pagePath, int first, int pageSize,
+                const std::function<void(const std::vector<DeathEvent>&)>& apply);
+private:
+    FetchFactory make_;
+    int workers_;
+    std::vector<ChunkFetchFn> fetch_;  // one per worker, made on first use
+    std::vector<std::unique_ptr<DeathBatchParser>> spare_;   // parsers of applied pages, reused
+};
+
+// catchUp: when the first page comes back full, the rest of the backlog goes through it
+// (nullptr or a single worker: one page at a time on pages).
+// pages: how death pages are fetched; empty = WholeBodies(fetch).
+PollResult KillfeedPoll(KillfeedState& st, const FetchFn& fetch, const std::function<void()>& onChange,
+                        PageFetcher* catchUp = nullptr, const ChunkFetchFn& pages = nullptr);
+// Resolves characterId from characterName if needed; sets status and returns false on failure.
+bool KillfeedResolveCharacter(KillfeedState& st, const FetchFn& fetch);
+// Names up to maxBatch attackers from st.unnamed with one character lookup and puts them in the
+// name cache. Ids the lookup does not return (deleted characters) show as "(unknown)".
+struct NameLookup { int requests = 0; int resolved = 0; bool failed = false; };
+NameLookup KillfeedResolveNames(KillfeedState& st, const FetchFn& fetch, size_t maxBatch = 100);
+// "Killed by <last attacker>  -  hs/tot<suffix>"
+std::wstring KilledByLine(const KillfeedState& st, const std::wstring& suffix);
+
+// ========================== Squads ================
+// Several characters tracked by one process. Each keeps its own KillfeedState (counters, ranking,
+// dedupe, session); the squad resolves their ids with one lookup and polls all of them with one
+// multi-id query per tick, applying each death to its victim's state, so a tick costs the same
+// number of requests however many characters there are. A squad of one polls exactly like
+// KillfeedPoll.
+struct Squad {
+    std::vector<std::unique_ptr<KillfeedState>> members;
+    unsigned long long watermark = 0;   // newest death the combined query has returned
+    DeathBatchParser pollPage;          // as KillfeedState::pollPage, for the combined query
+};
+bool SquadResolveCharacters(Squad& sq, const FetchFn& fetch);   // false if no member has an id
+PollResult SquadPoll(Squad& sq, const FetchFn& fetch, const std::function<void()>& onChange,
+                     PageFetcher* catchUp = nullptr, const ChunkFetchFn& pages = nullptr);
+
+// Poll interval: faster for a while right after a death (respawn/redeploy), the configured
+// interval while there has been one recently, then a jittered back-off towards maxMs during long
+// quiet stretches; errors back off exponentially (up to errorMaxMs). nowMs: any monotonic clock.
+class PollScheduler {
+public:
+    PollScheduler(int baseMs, int maxMs, uint64_t seed);
+    int Next(const PollResult& r, uint64_t nowMs);
+
+    int hotMs        = 45000;    // after a death: poll at fastMs for this long
+    int fastMs       = 0;        // 0 = baseMs / 2 (not below 250)
+    int quietAfterMs = 300000;   // no deaths for this long: start backing off
+    int errorMaxMs   = 60000;
+private:
+    int Jitter(int ms);
+    int base_, max_;
+    uint64_t rng_;
+    uint64_t startMs_ = 0, lastDeathMs_ = 0;
+    int idle_ = 0, errors_ = 0;
+};
+
+// Request rate and how long deaths took to show up (poll time minus the death's timestamp).
+// Written by the ingest thread, read by the UI.
+class PollStats {
+public:
+    void Record(const PollResult& r, uint64_t nowUnixMs, uint64_t nowMs);
+    double RequestsPerHour() const;
+    double MedianLatencyMs() const;
+    uint64_t Requests() const { return requests_.load(); }
+private:
+    std::atomic<uint64_t> requests_{0};
+    std::atomic<uint64_t> startMs_{0}, lastMs_{0};
+    mutable std::mutex mu_;
+    std::vector<double> latency_;       // newest 256 samples, ring
+    size_t next_ = 0;
+};
+
+// ========================== Display snapshots ================
+// Immutable copy of what the overlay draws. The ingest side builds one after every change;
+// the renderer only ever reads snapshots, never KillfeedState.
+struct DisplayRow { std::wstring name; Counters cnt; };
+struct DisplayBlock { std::wstring line; std::vector<DisplayRow> rows; };
+struct DisplaySnapshot {
+    std::wstring status;
+    std::wstring line;
+    std::vector<DisplayRow> rows;
+    std::vector<DisplayBlock> squad;    // further squad members, drawn below in the same layout
+    std::wstring hud;                   // metrics line at the bottom; set by the renderer, not the ingest side
+};
+inline bool operator==(const DisplayRow& a, const DisplayRow& b){
+    return a.cnt.tot == b.cnt.tot && a.cnt.hs == b.cnt.hs && a.name == b.name;
+}
+inline bool operator==(const DisplayBlock& a, const DisplayBlock& b){ return a.line == b.line && a.rows == b.rows; }
+// Same pixels: the renderer skips repainting when a new snapshot compares equal to the shown one.
+inline bool operator==(const DisplaySnapshot& a, const DisplaySnapshot& b){
+    return a.status == b.status && a.line == b.line && a.rows == b.rows && a.squad == b.squad && a.hud == b.hud;
+}
+// view: see RankView. A window view names itself at the end of the status line.
+std::unique_ptr<DisplaySnapshot> BuildSnapshot(const KillfeedState& st, size_t maxRows, int minDeaths = 1, int view = -1);
+// One block per member, each line prefixed with the character's name; a squad of one is BuildSnapshot.
+std::unique_ptr<DisplaySnapshot> BuildSquadSnapshot(const Squad& sq, size_t maxRows, int minDeaths = 1, int view = -1);
+
+// Single-producer/single-consumer, latest-wins handoff. Publish() replaces a snapshot the
+// consumer has not taken yet and returns true when the slot was empty (consumer needs a wake-up).
+class SnapshotMailbox {
+public:
+    ~SnapshotMailbox(){ delete slot_.exchange(nullptr); }
+    bool Publish(std::unique_ptr<DisplaySnapshot> s){
+        DisplaySnapshot* prev = slot_.exchange(s.release(), std::memory_order_acq_rel);
+        delete prev;
+        return prev == nullptr;
+    }
+    std::unique_ptr<DisplaySnapshot> Take(){
+        return std::unique_ptr<DisplaySnapshot>(slot_.exchange(nullptr, std::memory_order_acq_rel));
+    }
+private:
+    std::atomic<DisplaySnapshot*> slot_{nullptr};
+};
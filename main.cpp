@@ -1,913 +1,1291 @@
-// main.cpp — PS2 deaths overlay (Hybrid PEAK + Batch, pagination + robust dedupe)
-// True transparent background via per-pixel alpha (no fringes) + configurable text color.
-//
-// Build:
-//   g++ -std=gnu++17 -O2 -Wall -Wextra main.cpp -lgdi32 -luser32 -lwininet -mwindows -o Killfeed.exe
-
-#define WIN32_LEAN_AND_MEAN
-#include <windows.h>
-#include <windowsx.h>
-#include <wininet.h>
-#include <string>
-#include <vector>
-#include <deque>
-#include <unordered_map>
-#include <unordered_set>
-#include <cstdint>
-#include <algorithm>
-#include <sstream>
-#include <cstdio>
-
-// =========================== Config & Globals ===============================
-struct WinCfg { int x=100, y=100, w=520, h=220, alpha=230; };
-struct AppCfg {
-    std::wstring service_id;
-    std::wstring character_name;
-    int  world_id = 0;
-
-    WinCfg window;
-    int  poll_ms = 1000;
-    bool lock_position    = true;
-    bool always_on_top    = true;
-    bool skip_environment = true;
-
-    // If true: per-pixel alpha (recommended; no fringe).
-    // If false: legacy window with uniform alpha.
-    bool transparent_bg   = false;
-
-    // Legacy chroma (ignored when transparent_bg=true)
-    int  chroma_r         = 255;
-    int  chroma_g         = 0;
-    int  chroma_b         = 255;
-
-    // Configurable text color
-    int  text_r           = 0;
-    int  text_g           = 0;
-    int  text_b           = 0;
-} g_cfg;
-
-static const wchar_t* g_apiHost = L"census.daybreakgames.com";
-static bool           g_apiUseHttps = true;
-static unsigned short g_apiPort     = 0;
-
-static HWND g_hwnd = nullptr;
-static UINT TIMER_MS = 1000;
-static const UINT_PTR TIMER_ID = 1;
-
-static std::wstring g_status = L"Waiting for data…";
-static std::wstring g_line   = L"(no deaths yet)";
-static std::wstring g_characterId;
-
-// De-dup state
-static std::unordered_set<std::wstring> g_seenEventIds;
-static unsigned long long g_lastDeathTs = 0;
-
-// Synthetic dedupe
-static std::unordered_set<std::wstring> g_seenSynth;
-static std::deque<std::wstring>         g_seenQueue;
-static const size_t                     g_seenMax = 2048;
-
-// Per-attacker counters + name cache
-struct Counters { int hs=0; int tot=0; };
-static std::unordered_map<std::wstring, Counters>     g_counts;
-static std::unordered_map<std::wstring, std::wstring> g_nameCache;
-static std::wstring g_lastAttackerId   = L"";
-static std::wstring g_lastAttackerName = L"(unknown)";
-
-// Context menu
-static HMENU g_ctxMenu = nullptr;
-#define IDM_EXIT  1001
-
-// For legacy chroma path (ignored when transparent_bg=true)
-static COLORREF g_chroma    = RGB(255,0,255);
-static COLORREF g_textColor = RGB(0,0,0);
-
-// =========================== Utilities ======================
-template<typename T>
-static std::wstring to_wstring_compat(T v){ std::wstringstream ss; ss<<v; return ss.str(); }
-
-static int Clamp255(int v){ return v<0?0:(v>255?255:v); }
-
-static std::wstring Utf8ToWide(const std::string& s){
-    if(s.empty()) return L"";
-    int need = MultiByteToWideChar(CP_UTF8,0,s.data(),(int)s.size(),nullptr,0);
-    std::wstring out(need, L'\0');
-    if(need) MultiByteToWideChar(CP_UTF8,0,s.data(),(int)s.size(),&out[0],need);
-    return out;
-}
-
-static bool ReadFileUtf8(const std::wstring& path, std::string& out){
-    out.clear();
-    FILE* f = _wfopen(path.c_str(), L"rb");
-    if(!f) return false;
-    char buf[4096]; size_t n;
-    while((n=fread(buf,1,sizeof(buf),f))>0) out.append(buf, buf+n);
-    fclose(f);
-    if(out.size()>=3 && (unsigned char)out[0]==0xEF &&
-       (unsigned char)out[1]==0xBB && (unsigned char)out[2]==0xBF)
-        out.erase(0,3);
-    return true;
-}
-
-static std::wstring ToLowerAscii(const std::wstring& s){
-    std::wstring t = s;
-    for(auto& ch : t) if(ch >= L'A' && ch <= L'Z') ch = (wchar_t)(ch - L'A' + L'a');
-    return t;
-}
-
-static std::wstring GetExecutableDir(){
-    wchar_t path[MAX_PATH];
-    GetModuleFileNameW(nullptr, path, MAX_PATH);
-    wchar_t* last = nullptr;
-    for (wchar_t* p = path; *p; ++p) if (*p == L'\\' || *p == L'/') last = p;
-    if (last) *last = L'\0';
-    return path;
-}
-
-static unsigned long long ParseULL(const std::wstring& w){
-    unsigned long long v = 0;
-    for(wchar_t c : w){
-        if(c < L'0' || c > L'9') break;
-        v = v*10 + (unsigned)(c - L'0');
-    }
-    return v;
-}
-
-static void SkipWs(const std::string& j, size_t& i){
-    while(i<j.size() && (j[i]==' '||j[i]=='\t'||j[i]=='\n'||j[i]=='\r')) ++i;
-}
-
-static bool JsonFindString(const std::string& j, const char* key, std::string& outUtf8){
-    size_t i=0; std::string quoted = std::string("\"")+key+"\"";
-    while(true){
-        size_t kpos = j.find(quoted, i); if(kpos==std::string::npos) return false;
-        i = kpos + quoted.size();
-        size_t colon = j.find(':', i); if(colon==std::string::npos) return false;
-        i = colon+1; SkipWs(j,i);
-        if(i>=j.size() || j[i] != '"'){ i = kpos + 1; continue; }
-        ++i;
-        std::string val;
-        while(i<j.size() && j[i]!='"'){
-            char c=j[i++];
-            if(c=='\\' && i<j.size()){ char esc=j[i++]; val.push_back(esc); }
-            else val.push_back(c);
-        }
-        if(i<j.size() && j[i]=='"') ++i;
-        outUtf8 = val;
-        return true;
-    }
-}
-
-static bool JsonFindInt(const std::string& j, const char* key, int& out){
-    size_t i=0; std::string quoted = std::string("\"")+key+"\"";
-    while(true){
-        size_t kpos = j.find(quoted, i); if(kpos==std::string::npos) return false;
-        i = kpos + quoted.size();
-        size_t colon = j.find(':', i); if(colon==std::string::npos) return false;
-        i = colon+1; SkipWs(j,i);
-        size_t start=i; if(i<j.size() && (j[i]=='-'||j[i]=='+')) ++i;
-        while(i<j.size() && j[i]>='0'&&j[i]<='9') ++i;
-        if(start==i){ i = kpos + 1; continue; }
-        out = std::stoi(j.substr(start, i-start)); return true;
-    }
-}
-
-static bool JsonFindBool(const std::string& j, const char* key, bool& out){
-    size_t i=0; std::string quoted = std::string("\"")+key+"\"";
-    while(true){
-        size_t kpos = j.find(quoted, i); if(kpos==std::string::npos) return false;
-        i = kpos + quoted.size();
-        size_t colon = j.find(':', i); if(colon==std::string::npos) return false;
-        i = colon+1; SkipWs(j,i);
-        if(j.compare(i,4,"true")==0){ out=true;  return true; }
-        if(j.compare(i,5,"false")==0){ out=false; return true; }
-        i = kpos + 1;
-    }
-}
-
-static bool JsonFindStringInFirstArrayObj(const std::string& j,
-                                          const char* keyArray,
-                                          const char* innerKey,
-                                          std::string& outValUtf8)
-{
-    std::string ka = std::string("\"")+keyArray+"\"";
-    size_t a = j.find(ka); if(a==std::string::npos) return false;
-    size_t lb = j.find('[', a); if(lb==std::string::npos) return false;
-    size_t ob = j.find('{', lb); if(ob==std::string::npos) return false;
-    std::string sub = j.substr(ob, std::min<size_t>(j.size()-ob, 4096));
-    return JsonFindString(sub, innerKey, outValUtf8);
-}
-
-// ====================== Networking (WinINet) ======================
-static std::string FetchUrlBody(const std::wstring& path){
-    std::string body;
-
-    HINTERNET hInternet = InternetOpenW(L"PS2Overlay/1.0", INTERNET_OPEN_TYPE_PRECONFIG, NULL, NULL, 0);
-    if(!hInternet){ g_status = L"InternetOpen failed"; return body; }
-
-    INTERNET_PORT port = g_apiPort ? g_apiPort : (g_apiUseHttps ? INTERNET_DEFAULT_HTTPS_PORT : INTERNET_DEFAULT_HTTP_PORT);
-    DWORD flags = INTERNET_FLAG_RELOAD | INTERNET_FLAG_NO_CACHE_WRITE | INTERNET_FLAG_KEEP_CONNECTION;
-    if(g_apiUseHttps) flags |= INTERNET_FLAG_SECURE;
-
-    HINTERNET hConnect = InternetConnectW(hInternet, g_apiHost, port, NULL, NULL, INTERNET_SERVICE_HTTP, 0, 0);
-    if(!hConnect){ g_status = L"InternetConnect failed"; InternetCloseHandle(hInternet); return body; }
-
-    const wchar_t* accept[] = { L"*/*", nullptr };
-    HINTERNET hReq = HttpOpenRequestW(hConnect, L"GET", path.c_str(), NULL, NULL, accept, flags, 0);
-    if(!hReq){ g_status = L"HttpOpenRequest failed"; InternetCloseHandle(hConnect); InternetCloseHandle(hInternet); return body; }
-
-    if(!HttpSendRequestW(hReq, NULL, 0, NULL, 0)){
-        g_status = L"HttpSendRequest failed";
-        InternetCloseHandle(hReq); InternetCloseHandle(hConnect); InternetCloseHandle(hInternet);
-        return body;
-    }
-
-    char buf[4096]; DWORD rd=0;
-    while(InternetReadFile(hReq, buf, sizeof(buf), &rd) && rd>0) body.append(buf, buf+rd);
-
-    InternetCloseHandle(hReq); InternetCloseHandle(hConnect); InternetCloseHandle(hInternet);
-    return body;
-}
-
-// ========================== API builders ==========================
-static std::wstring BuildCharacterByNamePath(){
-    std::wstring lower = ToLowerAscii(g_cfg.character_name);
-    return L"/" + g_cfg.service_id + L"/get/ps2:v2/character?name.first_lower=" + lower;
-}
-static std::wstring BuildLatestDeathJoinedDesc(const std::wstring& charId){
-    return L"/" + g_cfg.service_id +
-           L"/get/ps2:v2/characters_event/?character_id=" + charId +
-           L"&type=DEATH&c:limit=1&c:sort=timestamp:desc"
-           L"&c:join=character^on:attacker_character_id^to:character_id^inject_at:attacker^show:name.first";
-}
-static std::wstring BuildDeathsSincePath(const std::wstring& charId,
-                                         unsigned long long afterTs,
-                                         int start,
-                                         int limit)
-{
-    if (limit <= 0) limit = 1000;
-    unsigned long long afterTsSafe = (afterTs > 0) ? (afterTs - 1) : 0;
-
-    return L"/" + g_cfg.service_id +
-           L"/get/ps2:v2/characters_event/?character_id=" + charId +
-           L"&type=DEATH"
-           L"&after=" + to_wstring_compat(afterTsSafe) +
-           L"&c:limit=" + to_wstring_compat(limit) +
-           L"&c:start=" + to_wstring_compat(start) +
-           L"&c:sort=timestamp:asc"
-           L"&c:join=character^on:attacker_character_id^to:character_id^inject_at:attacker^show:name.first";
-}
-
-// ========================== Parsers ============================
-static bool ParseCharacterId(const std::string& body, std::wstring& outId){
-    std::string idUtf8;
-    if(!JsonFindStringInFirstArrayObj(body, "character_list", "character_id", idUtf8))
-        return false;
-    outId = Utf8ToWide(idUtf8);
-    return !outId.empty();
-}
-
-static bool TryParseInjectedAttackerName(const std::string& segment, std::wstring& outName){
-    size_t pos = segment.find("\"attacker\"");
-    if (pos == std::string::npos) return false;
-    size_t npos = segment.find("\"name\"", pos);
-    if (npos == std::string::npos) return false;
-    size_t fpos = segment.find("\"first\"", npos);
-    if (fpos == std::string::npos) return false;
-    std::string firstUtf8;
-    if(!JsonFindString(segment.substr(fpos, 512), "first", firstUtf8)) return false;
-    outName = Utf8ToWide(firstUtf8);
-    return !outName.empty();
-}
-
-struct LatestOne {
-    std::wstring attackerId;
-    std::wstring attackerName;
-    std::wstring eventId;
-    unsigned long long ts = 0;
-    bool isHS = false;
-    bool ok = false;
-};
-
-static LatestOne ParseLatestJoinedOne(const std::string& body){
-    LatestOne r{};
-    std::string s;
-    if(!JsonFindString(body, "attacker_character_id", s)) return r;
-    r.attackerId = Utf8ToWide(s);
-    if(JsonFindString(body, "is_headshot", s)) r.isHS = (s=="1");
-    if(JsonFindString(body, "event_id", s))    r.eventId = Utf8ToWide(s);
-    if(JsonFindString(body, "timestamp", s))   r.ts = ParseULL(Utf8ToWide(s));
-    std::wstring nm; if (TryParseInjectedAttackerName(body, nm)) r.attackerName = nm;
-    r.ok = (!r.attackerId.empty() && r.ts!=0);
-    return r;
-}
-
-struct DeathEvent {
-    std::wstring attackerId;
-    std::wstring attackerName;
-    bool isHS = false;
-    std::wstring eventId;
-    unsigned long long ts = 0;
-};
-
-// Brace-balanced batch parser
-static std::vector<DeathEvent> ParseDeathBatch(const std::string& body){
-    std::vector<DeathEvent> out;
-    size_t arrStart = body.find('[');
-    if (arrStart == std::string::npos) return out;
-    size_t arrEnd = std::string::npos;
-    for (int depth = 0, i = (int)arrStart; i < (int)body.size(); ++i){
-        char c = body[i];
-        if (c == '[') ++depth;
-        else if (c == ']'){ --depth; if (depth == 0){ arrEnd = i; break; } }
-    }
-    if (arrEnd == std::string::npos) return out;
-    const std::string arr = body.substr(arrStart, arrEnd - arrStart + 1);
-
-    size_t i = 0;
-    while (i < arr.size()){
-        size_t objL = arr.find('{', i);
-        if (objL == std::string::npos) break;
-
-        int depth = 0;
-        size_t j = objL;
-        for (; j < arr.size(); ++j){
-            char c = arr[j];
-            if (c == '{') ++depth;
-            else if (c == '}'){ --depth; if (depth == 0){ ++j; break; } }
-        }
-        if (j <= objL) break;
-        std::string evt = arr.substr(objL, j - objL);
-
-        if (evt.find("\"attacker_character_id\"") != std::string::npos){
-            DeathEvent e{};
-            std::string s;
-            if (JsonFindString(evt, "attacker_character_id", s)) e.attackerId = Utf8ToWide(s);
-            if (JsonFindString(evt, "is_headshot", s))          e.isHS = (s == "1");
-            if (JsonFindString(evt, "event_id", s))             e.eventId = Utf8ToWide(s);
-            if (JsonFindString(evt, "timestamp", s))            e.ts = ParseULL(Utf8ToWide(s));
-            std::wstring nm; if (TryParseInjectedAttackerName(evt, nm)) e.attackerName = nm;
-
-            if (!e.attackerId.empty() && e.ts != 0ULL) out.push_back(std::move(e));
-        }
-        i = j;
-    }
-    return out;
-}
-
-// ========================== Topmost/UI helpers =================
-static void SetTopMost(HWND hwnd, bool on){
-    SetWindowPos(hwnd, on ? HWND_TOPMOST : HWND_NOTOPMOST,
-                 0,0,0,0, SWP_NOMOVE|SWP_NOSIZE|SWP_NOACTIVATE|SWP_SHOWWINDOW);
-}
-static void ReassertTopMost(){
-    if (g_cfg.always_on_top && g_hwnd) {
-        SetWindowPos(g_hwnd, HWND_TOPMOST, 0,0,0,0,
-                     SWP_NOMOVE|SWP_NOSIZE|SWP_NOACTIVATE);
-    }
-}
-static std::wstring GetDisplayNameFor(const std::wstring& attackerId){
-    auto it = g_nameCache.find(attackerId);
-    if (it != g_nameCache.end()) return it->second;
-    return L"(resolving…)";
-}
-static void EnsureContextMenu(){
-    if (!g_ctxMenu) {
-        g_ctxMenu = CreatePopupMenu();
-        AppendMenuW(g_ctxMenu, MF_STRING, IDM_EXIT, L"Exit");
-    }
-}
-
-// ========================== Alpha-layer rendering ============================
-// Create a 32-bit DIB section (premultiplied ARGB) and backbuffer DC.
-static HBITMAP CreateDIB32(HDC ref, int w, int h, void** outBits){
-    BITMAPINFO bmi{};
-    bmi.bmiHeader.biSize        = sizeof(BITMAPINFOHEADER);
-    bmi.bmiHeader.biWidth       = w;
-    bmi.bmiHeader.biHeight      = -h; // top-down
-    bmi.bmiHeader.biPlanes      = 1;
-    bmi.bmiHeader.biBitCount    = 32;
-    bmi.bmiHeader.biCompression = BI_RGB; // we'll manage alpha manually
-    void* bits = nullptr;
-    HBITMAP hbmp = CreateDIBSection(ref, &bmi, DIB_RGB_COLORS, &bits, nullptr, 0);
-    if (outBits) *outBits = bits;
-    return hbmp;
-}
-
-// Draws text as WHITE onto black, then converts white intensity -> alpha and tints to config color.
-// Finally pushes to the layered window with UpdateLayeredWindow.
-static void RepaintLayered(){
-    if (!g_hwnd) return;
-
-    RECT rc; GetClientRect(g_hwnd, &rc);
-    int W = rc.right - rc.left, H = rc.bottom - rc.top;
-    if (W<=0 || H<=0) return;
-
-    HDC screen = GetDC(nullptr);
-    HDC memDC  = CreateCompatibleDC(screen);
-
-    void* bits = nullptr;
-    HBITMAP dib = CreateDIB32(screen, W, H, &bits);
-    HGDIOBJ old = SelectObject(memDC, dib);
-
-    // Clear to black (RGB=0, alpha=0)
-    GdiFlush();
-    memset(bits, 0x00, W*H*4);
-
-    // GDI text settings
-    HFONT hFont = (HFONT)GetStockObject(DEFAULT_GUI_FONT);
-    HGDIOBJ oldFont = SelectObject(memDC, hFont);
-    SetBkMode(memDC, TRANSPARENT);
-    SetTextColor(memDC, RGB(255,255,255)); // draw in white
-
-    // Layout
-    TEXTMETRICW tm{}; GetTextMetricsW(memDC,&tm);
-    int lineH = tm.tmHeight + 6;
-    int y = 6, left = 8;
-
-    // Status
-    RECT r{left,y, W-8, y+lineH};
-    DrawTextW(memDC, g_status.c_str(), (int)g_status.size(), &r, DT_LEFT|DT_SINGLELINE|DT_NOPREFIX);
-    y += lineH + 2;
-
-    // Latest line
-    RECT r2{left,y, W-8, y+lineH};
-    DrawTextW(memDC, g_line.c_str(), (int)g_line.size(), &r2, DT_LEFT|DT_SINGLELINE|DT_NOPREFIX);
-    y += lineH + 6;
-
-    // Top 3 nemeses
-    struct Row { std::wstring id; Counters cnt; };
-    std::vector<Row> entries; entries.reserve(g_counts.size());
-    for (auto it = g_counts.begin(); it != g_counts.end(); ++it) {
-        if (it->first == L"0" && g_cfg.skip_environment) continue;
-        if (it->second.tot <= 0) continue;
-        entries.push_back(Row{it->first, it->second});
-    }
-    std::sort(entries.begin(), entries.end(),
-        [&](const Row& A, const Row& B){
-            if (A.cnt.tot != B.cnt.tot) return A.cnt.tot > B.cnt.tot;
-            if (A.cnt.hs  != B.cnt.hs)  return A.cnt.hs  > B.cnt.hs;
-            return GetDisplayNameFor(A.id) < GetDisplayNameFor(B.id);
-        });
-
-    int shown = 0;
-    for (size_t i = 0; i < entries.size() && shown < 3; ++i) {
-        const Row& e = entries[i];
-        std::wstring name = GetDisplayNameFor(e.id);
-        std::wstring line = to_wstring_compat(shown+1) + L") " + name +
-                            L"  " + to_wstring_compat(e.cnt.hs) + L"/" + to_wstring_compat(e.cnt.tot);
-        RECT r3{left,y, W-8, y+lineH};
-        DrawTextW(memDC, line.c_str(), (int)line.size(), &r3, DT_LEFT|DT_SINGLELINE|DT_NOPREFIX);
-        y += lineH; ++shown;
-    }
-
-    // Convert white->alpha; set RGB to configured color (premultiplied)
-    unsigned char* p = (unsigned char*)bits;
-    const unsigned cR = (unsigned)g_cfg.text_r;
-    const unsigned cG = (unsigned)g_cfg.text_g;
-    const unsigned cB = (unsigned)g_cfg.text_b;
-
-    for (int i=0;i<W*H;++i){
-        unsigned char B = p[0], G = p[1], R = p[2];
-        unsigned char A = (R>G?R:G); if (B>A) A = B; // A = max(R,G,B)
-        p[2] = (unsigned char)((cR * A + 127) / 255); // R premultiplied
-        p[1] = (unsigned char)((cG * A + 127) / 255); // G
-        p[0] = (unsigned char)((cB * A + 127) / 255); // B
-        p[3] = A;                                     // A
-        p += 4;
-    }
-
-    // Push to window
-    POINT ptPos{0,0};
-    SIZE  sz{W,H};
-    POINT ptSrc{0,0};
-    BLENDFUNCTION bf{AC_SRC_OVER, 0, 255, AC_SRC_ALPHA};
-
-    LONG ex = GetWindowLongW(g_hwnd, GWL_EXSTYLE);
-    if(!(ex & WS_EX_LAYERED)) SetWindowLongW(g_hwnd, GWL_EXSTYLE, ex | WS_EX_LAYERED);
-
-    RECT wr; GetWindowRect(g_hwnd, &wr);
-    POINT wndPos{wr.left, wr.top};
-
-    UpdateLayeredWindow(g_hwnd, screen, &wndPos, &sz, memDC, &ptSrc, 0, &bf, ULW_ALPHA);
-
-    // Cleanup
-    SelectObject(memDC, oldFont);
-    SelectObject(memDC, old);
-    DeleteObject(dib);
-    DeleteDC(memDC);
-    ReleaseDC(nullptr, screen);
-}
-
-// ========================== Legacy (uniform alpha) painting ===================
-static void PaintLegacyOpaque(HDC hdc, RECT rc){
-    // Fill white background (legacy path)
-    HBRUSH hFill = CreateSolidBrush(RGB(255,255,255));
-    FillRect(hdc, &rc, hFill);
-    DeleteObject(hFill);
-
-    HFONT hFont = (HFONT)GetStockObject(DEFAULT_GUI_FONT);
-    HFONT hOld  = (HFONT)SelectObject(hdc, hFont);
-    SetBkMode(hdc, TRANSPARENT);
-    SetTextColor(hdc, g_textColor); // use configured color
-
-    TEXTMETRICW tm{}; GetTextMetricsW(hdc,&tm);
-    int lineH = tm.tmHeight + 6;
-    int y = rc.top + 6, left = rc.left + 8;
-
-    RECT r{left,y, rc.right-8, y+lineH};
-    DrawTextW(hdc, g_status.c_str(), (int)g_status.size(), &r, DT_LEFT|DT_SINGLELINE|DT_NOPREFIX);
-    y += lineH + 2;
-
-    RECT r2{left,y, rc.right-8, y+lineH};
-    DrawTextW(hdc, g_line.c_str(), (int)g_line.size(), &r2, DT_LEFT|DT_SINGLELINE|DT_NOPREFIX);
-    y += lineH + 6;
-
-    struct Row { std::wstring id; Counters cnt; };
-    std::vector<Row> entries; entries.reserve(g_counts.size());
-    for (auto it = g_counts.begin(); it != g_counts.end(); ++it) {
-        if (it->first == L"0" && g_cfg.skip_environment) continue;
-        if (it->second.tot <= 0) continue;
-        entries.push_back(Row{it->first, it->second});
-    }
-    std::sort(entries.begin(), entries.end(),
-        [&](const Row& A, const Row& B){
-            if (A.cnt.tot != B.cnt.tot) return A.cnt.tot > B.cnt.tot;
-            if (A.cnt.hs  != B.cnt.hs)  return A.cnt.hs  > B.cnt.hs;
-            return GetDisplayNameFor(A.id) < GetDisplayNameFor(B.id);
-        });
-
-    int shown = 0;
-    for (size_t i = 0; i < entries.size() && shown < 3; ++i) {
-        const Row& e = entries[i];
-        std::wstring name = GetDisplayNameFor(e.id);
-        std::wstring line = to_wstring_compat(shown+1) + L") " + name +
-                            L"  " + to_wstring_compat(e.cnt.hs) + L"/" + to_wstring_compat(e.cnt.tot);
-        RECT r3{left,y, rc.right-8, y+lineH};
-        DrawTextW(hdc, line.c_str(), (int)line.size(), &r3, DT_LEFT|DT_SINGLELINE|DT_NOPREFIX);
-        y += lineH; ++shown;
-    }
-    SelectObject(hdc, hOld);
-}
-
-// ========================== Window/config helpers =================
-static void SetTopMostIfNeeded(){
-    if (g_cfg.always_on_top && g_hwnd) {
-        SetWindowPos(g_hwnd, HWND_TOPMOST, 0,0,0,0, SWP_NOMOVE|SWP_NOSIZE|SWP_NOACTIVATE);
-    }
-}
-
-static void ApplyWindowConfig(HWND hwnd){
-    SetWindowPos(hwnd, nullptr, g_cfg.window.x, g_cfg.window.y, g_cfg.window.w, g_cfg.window.h,
-                 SWP_NOZORDER | SWP_NOACTIVATE);
-
-    LONG ex = GetWindowLongW(hwnd, GWL_EXSTYLE);
-    if(!(ex & WS_EX_LAYERED)) SetWindowLongW(hwnd, GWL_EXSTYLE, ex | WS_EX_LAYERED);
-
-    if (!g_cfg.transparent_bg){
-        // Uniform alpha for legacy opaque window
-        BYTE a = (BYTE) (g_cfg.window.alpha<0?0:(g_cfg.window.alpha>255?255:g_cfg.window.alpha));
-        SetLayeredWindowAttributes(hwnd, 0, a, LWA_ALPHA);
-    }
-    SetTopMostIfNeeded();
-}
-
-static bool LoadConfigFromFile(){
-    std::wstring cfgPath = GetExecutableDir() + L"\\config.json";
-    std::string j; if(!ReadFileUtf8(cfgPath, j)) return false;
-
-    std::string s;
-    if(JsonFindString(j, "service_id", s))      g_cfg.service_id      = Utf8ToWide(s);
-    if(JsonFindString(j, "character_name", s))  g_cfg.character_name  = Utf8ToWide(s);
-
-    int v;
-    if(JsonFindInt(j, "poll_ms", v))            g_cfg.poll_ms         = v;
-    if(JsonFindInt(j, "world_id", v))           g_cfg.world_id        = v;
-
-    bool bflag;
-    if(JsonFindBool(j, "transparent_bg", bflag)) g_cfg.transparent_bg = bflag;
-    if(JsonFindInt(j, "chroma_r", v))            g_cfg.chroma_r = Clamp255(v);
-    if(JsonFindInt(j, "chroma_g", v))            g_cfg.chroma_g = Clamp255(v);
-    if(JsonFindInt(j, "chroma_b", v))            g_cfg.chroma_b = Clamp255(v);
-    g_chroma = RGB(g_cfg.chroma_r, g_cfg.chroma_g, g_cfg.chroma_b);
-
-    // NEW: text color
-    if(JsonFindInt(j, "text_r", v)) g_cfg.text_r = Clamp255(v);
-    if(JsonFindInt(j, "text_g", v)) g_cfg.text_g = Clamp255(v);
-    if(JsonFindInt(j, "text_b", v)) g_cfg.text_b = Clamp255(v);
-    g_textColor = RGB(g_cfg.text_r, g_cfg.text_g, g_cfg.text_b);
-
-    // window
-    size_t p = j.find("\"window\"");
-    if(p!=std::string::npos){
-        size_t b = j.find('{', p), e=b; int depth=0;
-        for(; e<j.size(); ++e){ if(j[e]=='{') ++depth; else if(j[e]=='}'){ --depth; if(depth==0){ ++e; break; } } }
-        if(b!=std::string::npos && e!=std::string::npos){
-            std::string win = j.substr(b, e-b);
-            if(JsonFindInt(win, "x", v))        g_cfg.window.x     = v;
-            if(JsonFindInt(win, "y", v))        g_cfg.window.y     = v;
-            if(JsonFindInt(win, "w", v))        g_cfg.window.w     = v;
-            if(JsonFindInt(win, "h", v))        g_cfg.window.h     = v;
-            if(JsonFindInt(win, "alpha", v))    g_cfg.window.alpha = v;
-        }
-    }
-
-    bool b;
-    if(JsonFindBool(j, "lock_position", b))     g_cfg.lock_position    = b;
-    if(JsonFindBool(j, "always_on_top", b))     g_cfg.always_on_top    = b;
-    if(JsonFindBool(j, "skip_environment", b))  g_cfg.skip_environment = b;
-
-    if(g_cfg.service_id.empty()) g_cfg.service_id = L"s:example";
-    TIMER_MS = (g_cfg.poll_ms>100 ? (UINT)g_cfg.poll_ms : 1000);
-    return true;
-}
-
-// ========================== Common apply (de-dupe + counters) =================
-static void RememberSynth(const std::wstring& key){
-    if (g_seenSynth.insert(key).second) {
-        g_seenQueue.push_back(key);
-        if (g_seenQueue.size() > g_seenMax) {
-            g_seenSynth.erase(g_seenQueue.front());
-            g_seenQueue.pop_front();
-        }
-    }
-}
-static bool SeenSynth(const std::wstring& key){
-    return g_seenSynth.find(key) != g_seenSynth.end();
-}
-
-static bool ApplyDeathEvent(const DeathEvent& e){
-    if (!e.eventId.empty()){
-        if (g_seenEventIds.count(e.eventId)) return false;
-    } else {
-        std::wstring key = to_wstring_compat(e.ts) + L"|" + e.attackerId + (e.isHS?L"|1":L"|0");
-        if (SeenSynth(key)) return false;
-    }
-
-    if (g_cfg.skip_environment && e.attackerId == L"0"){
-        if (!e.eventId.empty()) g_seenEventIds.insert(e.eventId);
-        else {
-            std::wstring key = to_wstring_compat(e.ts) + L"|" + e.attackerId + (e.isHS?L"|1":L"|0");
-            RememberSynth(key);
-        }
-        if (e.ts > g_lastDeathTs) g_lastDeathTs = e.ts;
-        return false;
-    }
-
-    if(!e.attackerName.empty()) g_nameCache[e.attackerId] = e.attackerName;
-
-    g_lastAttackerId   = e.attackerId;
-    g_lastAttackerName = (g_nameCache.find(e.attackerId)!=g_nameCache.end())
-                          ? g_nameCache[e.attackerId] : L"(resolving…)";
-    Counters &c = g_counts[e.attackerId];
-    c.tot += 1;
-    if (e.isHS) c.hs += 1;
-
-    if (!e.eventId.empty()) g_seenEventIds.insert(e.eventId);
-    else {
-        std::wstring key = to_wstring_compat(e.ts) + L"|" + e.attackerId + (e.isHS?L"|1":L"|0");
-        RememberSynth(key);
-    }
-
-    if (e.ts > g_lastDeathTs) g_lastDeathTs = e.ts;
-    return true;
-}
-
-// ========================== Core polling (Hybrid PEAK + Batch) ================
-static void PollOnce(){
-    if(!g_characterId.empty() || !g_cfg.character_name.empty()){
-        if (g_characterId.empty()){
-            std::string body = FetchUrlBody(BuildCharacterByNamePath());
-            std::wstring cid;
-            if(!body.empty() && ParseCharacterId(body, cid)){
-                g_characterId = cid;
-                g_status = L"Character ID = " + g_characterId;
-            } else {
-                g_status = L"Could not resolve character_id from name";
-                return;
-            }
-        }
-    } else {
-        g_status = L"Set character_name in config.json";
-        return;
-    }
-
-    std::string peekJ = FetchUrlBody(BuildLatestDeathJoinedDesc(g_characterId));
-    LatestOne latest = ParseLatestJoinedOne(peekJ);
-    if(!latest.ok){ g_status = L"No latest death found"; return; }
-
-    const unsigned long long peekTs = latest.ts;
-    bool appliedPeek = false;
-
-    bool unseenPeek = false;
-    if(!latest.eventId.empty()){
-        unseenPeek = (g_seenEventIds.find(latest.eventId) == g_seenEventIds.end());
-    } else {
-        std::wstring key = to_wstring_compat(latest.ts) + L"|" + latest.attackerId + (latest.isHS?L"|1":L"|0");
-        unseenPeek = !SeenSynth(key);
-    }
-
-    if (unseenPeek){
-        DeathEvent e{};
-        e.attackerId   = latest.attackerId;
-        e.attackerName = latest.attackerName;
-        e.isHS         = latest.isHS;
-        e.eventId      = latest.eventId;
-        e.ts           = latest.ts;
-
-        bool applied = ApplyDeathEvent(e);
-        if (applied){
-            appliedPeek = true;
-            Counters c = g_counts[g_lastAttackerId];
-            g_line = L"Killed by " + g_lastAttackerName +
-                     L"  -  " + to_wstring_compat(c.hs) + L"/" + to_wstring_compat(c.tot) +
-                     L"  (+1)";
-            g_status = L"Peek applied";
-            if(g_hwnd) {
-                if (g_cfg.transparent_bg) RepaintLayered(); else InvalidateRect(g_hwnd,nullptr,TRUE);
-            }
-        }
-    }
-
-    const int PAGE = 1000;
-    int start = 0;
-    int appliedBatch = 0;
-    bool anyPageRows = false;
-
-    while(true){
-        std::wstring path = BuildDeathsSincePath(g_characterId, g_lastDeathTs, start, PAGE);
-        std::string  body = FetchUrlBody(path);
-        std::vector<DeathEvent> events = ParseDeathBatch(body);
-        if (events.empty()) break;
-        anyPageRows = true;
-
-        for (size_t i=0;i<events.size();++i){
-            const DeathEvent& e = events[i];
-            if (e.ts > peekTs) break;
-            if (ApplyDeathEvent(e)) ++appliedBatch;
-        }
-
-        if ((int)events.size() < PAGE) break;
-        start += PAGE;
-    }
-
-    if (appliedBatch == 0 && !appliedPeek){
-        if (anyPageRows && peekTs > g_lastDeathTs) g_lastDeathTs = peekTs;
-        g_status = L"No new deaths";
-    } else if (appliedBatch > 0 && appliedPeek){
-        Counters c = g_counts[g_lastAttackerId];
-        g_line = L"Killed by " + g_lastAttackerName +
-                 L"  -  " + to_wstring_compat(c.hs) + L"/" + to_wstring_compat(c.tot) +
-                 L"  (+1 peek, +" + to_wstring_compat(appliedBatch) + L" batch)";
-        g_status = L"Updated (peek+batch)";
-        if(g_hwnd){ if (g_cfg.transparent_bg) RepaintLayered(); else InvalidateRect(g_hwnd,nullptr,TRUE); }
-    } else if (appliedBatch > 0){
-        Counters c = g_counts[g_lastAttackerId];
-        g_line = L"Killed by " + g_lastAttackerName +
-                 L"  -  " + to_wstring_compat(c.hs) + L"/" + to_wstring_compat(c.tot) +
-                 L"  (+" + to_wstring_compat(appliedBatch) + L")";
-        g_status = L"Updated (batch)";
-        if(g_hwnd){ if (g_cfg.transparent_bg) RepaintLayered(); else InvalidateRect(g_hwnd,nullptr,TRUE); }
-    }
-    ReassertTopMost();
-}
-
-// ========================== Window plumbing ===================
-static LRESULT CALLBACK WndProc(HWND hwnd, UINT msg, WPARAM wParam, LPARAM lParam){
-    switch(msg){
-        case WM_CREATE:
-            SetTimer(hwnd, TIMER_ID, TIMER_MS, nullptr);
-            EnsureContextMenu();
-            return 0;
-
-        case WM_WINDOWPOSCHANGING:
-            if (g_cfg.lock_position) {
-                WINDOWPOS* wp = reinterpret_cast<WINDOWPOS*>(lParam);
-                if (wp) {
-                    wp->x  = g_cfg.window.x;
-                    wp->y  = g_cfg.window.y;
-                    wp->cx = g_cfg.window.w;
-                    wp->cy = g_cfg.window.h;
-                    if (g_cfg.always_on_top) wp->hwndInsertAfter = HWND_TOPMOST;
-                }
-            }
-            return 0;
-
-        case WM_ACTIVATE:
-        case WM_ACTIVATEAPP:
-        case WM_NCACTIVATE:
-            ReassertTopMost();
-            return 0;
-
-        case WM_NCHITTEST:
-            return HTCLIENT;
-
-        case WM_CONTEXTMENU: {
-            EnsureContextMenu();
-            POINT pt{ GET_X_LPARAM(lParam), GET_Y_LPARAM(lParam) };
-            if ((SHORT)LOWORD(lParam) == -1 && (SHORT)HIWORD(lParam) == -1) {
-                RECT rc; GetWindowRect(hwnd, &rc);
-                pt.x = rc.left + 10; pt.y = rc.top + 10;
-            }
-            SetForegroundWindow(hwnd);
-            TrackPopupMenu(g_ctxMenu, TPM_RIGHTBUTTON | TPM_LEFTALIGN, pt.x, pt.y, 0, hwnd, nullptr);
-            PostMessageW(hwnd, WM_NULL, 0, 0);
-            return 0;
-        }
-
-        case WM_COMMAND:
-            if (LOWORD(wParam) == IDM_EXIT) { DestroyWindow(hwnd); return 0; }
-            break;
-
-        case WM_KEYDOWN:
-            if (wParam == VK_ESCAPE) { DestroyWindow(hwnd); return 0; }
-            break;
-
-        case WM_SYSCOMMAND:
-            if ((wParam & 0xFFF0) == SC_CLOSE) { DestroyWindow(hwnd); return 0; }
-            break;
-
-        case WM_TIMER:
-            if(wParam==TIMER_ID){
-                PollOnce();
-                ReassertTopMost();
-            }
-            return 0;
-
-        case WM_ERASEBKGND:
-            return 1; // we'll draw everything
-
-        case WM_PAINT:{
-            if (!g_cfg.transparent_bg){
-                PAINTSTRUCT ps; HDC hdc=BeginPaint(hwnd,&ps);
-                RECT rc; GetClientRect(hwnd,&rc);
-                PaintLegacyOpaque(hdc, rc);
-                EndPaint(hwnd,&ps);
-            } else {
-                PAINTSTRUCT ps; BeginPaint(hwnd,&ps); EndPaint(hwnd,&ps);
-                RepaintLayered();
-            }
-        } return 0;
-
-        case WM_SIZE:
-            if (g_cfg.transparent_bg) RepaintLayered();
-            return 0;
-
-        case WM_DESTROY:
-            KillTimer(hwnd, TIMER_ID);
-            if (g_ctxMenu) { DestroyMenu(g_ctxMenu); g_ctxMenu = nullptr; }
-            PostQuitMessage(0);
-            return 0;
-    }
-    return DefWindowProcW(hwnd, msg, wParam, lParam);
-}
-
-// =============================== Entry =======================================
-int APIENTRY WinMain(HINSTANCE hInst, HINSTANCE, LPSTR, int nCmdShow){
-    if(!LoadConfigFromFile()) g_status = L"config.json not found; using defaults";
-    else g_status = L"Loaded config.json";
-
-    DWORD exStyle = WS_EX_LAYERED | WS_EX_TOPMOST | WS_EX_APPWINDOW;
-    DWORD style   = WS_POPUP;
-
-    const wchar_t* cls = L"PS2DeathsOverlay";
-    WNDCLASSW wc{};
-    wc.lpfnWndProc   = WndProc;
-    wc.hInstance     = hInst;
-    wc.hbrBackground = (HBRUSH)GetStockObject(NULL_BRUSH);
-    wc.lpszClassName = cls;
-    wc.hCursor       = LoadCursor(nullptr, IDC_ARROW);
-    if(!RegisterClassW(&wc)){
-        MessageBoxW(nullptr,L"RegisterClassW failed",L"Error",MB_ICONERROR);
-        return 1;
-    }
-
-    g_hwnd = CreateWindowExW(exStyle, cls, L"", style,
-                             g_cfg.window.x, g_cfg.window.y, g_cfg.window.w, g_cfg.window.h,
-                             nullptr, nullptr, hInst, nullptr);
-    if(!g_hwnd){
-        MessageBoxW(nullptr,L"CreateWindowExW failed",L"Error",MB_ICONERROR);
-        return 1;
-    }
-
-    ApplyWindowConfig(g_hwnd);
-    ShowWindow(g_hwnd, nCmdShow);
-    UpdateWindow(g_hwnd);
-
-    // Pre-resolve character id to speed up first paint
-    if (g_characterId.empty() && !g_cfg.character_name.empty()){
-        std::string body = FetchUrlBody(BuildCharacterByNamePath());
-        std::wstring cid;
-        if(!body.empty() && ParseCharacterId(body, cid)) g_characterId = cid;
-    }
-
-    ReassertTopMost();
-    SetForegroundWindow(g_hwnd);
-    SetFocus(g_hwnd);
-
-    if (g_cfg.transparent_bg) RepaintLayered();
-
-    MSG msg;
-    while(GetMessageW(&msg,nullptr,0,0)>0){ TranslateMessage(&msg); DispatchMessageW(&msg); }
-    return (int)msg.wParam;
-}
+// main.cpp — PS2 deaths overlay (Hybrid PEAK + Batch, pagination + robust dedupe)
+// True transparent background via per-pixel alpha (no fringes) + configurable text color.
+//
+// Build:
+//   g++ -std=gnu++17 -O2 -Wall -Wextra main.cpp killfeed_core.cpp event_stream.cpp ws_winhttp.cpp pixel_kernels.cpp text_render.cpp session_store.cpp history_store.cpp file_util.cpp metrics.cpp inflate.cpp -lgdi32 -luser32 -lwininet -lwinhttp -mwindows -o Killfeed.exe
+
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#include <windowsx.h>
+#include <wininet.h>
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <algorithm>
+#include <cstdio>
+#include <cwchar>
+#include <chrono>
+#include <mutex>
+#include "killfeed_core.h"
+#include "event_stream.h"
+#include "json_scan.h"
+#include "http_transport.h"
+#include "inflate.h"
+#include "pixel_kernels.h"
+#include "text_render.h"
+#include "session_store.h"
+#include "history_store.h"
+#include "metrics.h"
+
+// =========================== Config & Globals ===============================
+struct WinCfg { int x=100, y=100, w=520, h=220, alpha=230; };
+struct AppCfg {
+    std::wstring service_id;
+    std::wstring character_name;
+    std::vector<std::wstring> character_names;   // squad: several characters in one overlay (wins over character_name)
+    int  world_id = 0;
+
+    WinCfg window;
+    int  poll_ms = 1000;
+    int  poll_max_ms = 5000;        // slowest poll interval during long quiet stretches
+    int  catchup_workers = 4;       // connections fetching a backlog in parallel; 1 = one page at a time
+    int  max_rows = 3;              // nemesis rows under the "Killed by" line
+    int  min_deaths_to_list = 1;
+    int  window_size = 0;           // text size, see TextPixelHeight; 0 = stock GUI font
+    bool lock_position    = true;
+    bool always_on_top    = true;
+    bool skip_environment = true;
+    // Push ingest from the Census event stream; REST is only used to fill gaps after (re)connect.
+    bool use_stream       = false;
+    bool show_hud         = false;  // p50/p99 per pipeline stage on the bottom line
+    int  metrics_log_seconds = 60;  // metrics.log next to the exe gets a block this often; 0 = off
+    int  max_fps          = 30;     // cap on repaints per second, however fast the view changes; 0 = no cap
+    bool lifetime         = false;  // counts over the character's whole history (history_<name>.kfh), not since the first start
+    std::vector<int> windows_minutes{10, 30};   // rolling windows kept next to the totals
+    int  rank_by_minutes  = 0;      // rank by one of those windows (added if missing); 0 = the totals
+
+    // If true: per-pixel alpha (recommended; no fringe).
+    // If false: legacy window with uniform alpha.
+    bool transparent_bg   = false;
+
+    // Legacy chroma (ignored when transparent_bg=true)
+    int  chroma_r         = 255;
+    int  chroma_g         = 0;
+    int  chroma_b         = 255;
+
+    // Configurable text color
+    int  text_r           = 0;
+    int  text_g           = 0;
+    int  text_b           = 0;
+} g_cfg;
+
+// The rolling windows every member keeps, in minutes: windows_minutes, then rank_by_minutes if it
+// is not one of them; no repeats.
+static std::vector<int> WindowMinutes(){
+    std::vector<int> out;
+    for (int m : g_cfg.windows_minutes) if (std::find(out.begin(), out.end(), m) == out.end()) out.push_back(m);
+    if (g_cfg.rank_by_minutes > 0 && std::find(out.begin(), out.end(), g_cfg.rank_by_minutes) == out.end())
+        out.push_back(g_cfg.rank_by_minutes);
+    return out;
+}
+
+// What the rows rank by: an index into WindowMinutes(), or -1 for the totals.
+static int ConfiguredView(){
+    if (g_cfg.rank_by_minutes <= 0) return -1;
+    const std::vector<int> w = WindowMinutes();
+    return (int)(std::find(w.begin(), w.end(), g_cfg.rank_by_minutes) - w.begin());
+}
+
+static const wchar_t* g_apiHost = L"census.daybreakgames.com";
+static bool           g_apiUseHttps = true;
+static unsigned short g_apiPort     = 0;
+static const wchar_t* g_pushHost    = L"push.planetside2.com";
+
+static HWND g_hwnd = nullptr;
+static UINT TIMER_MS = 1000;
+static const UINT_PTR TIMER_ID = 1;
+static const UINT_PTR METRICS_TIMER_ID = 2;   // HUD refresh and metrics log, once a second
+static const UINT_PTR CONFIG_TIMER_ID  = 3;   // config.json is looked at this long after the folder changes
+static const UINT     CONFIG_SETTLE_MS = 250;
+static const UINT_PTR FRAME_TIMER_ID   = 4;   // a frame the message loop could not draw yet (max_fps, modal loops)
+
+// Session state: status/line, character id, dedupe, counters, one KillfeedState per tracked
+// character (see killfeed_core.h). Owned by the ingest thread only once it runs; the UI thread
+// draws g_view, the last snapshot it took.
+static Squad g_squad;
+static SnapshotMailbox                  g_mailbox;
+static std::unique_ptr<DisplaySnapshot> g_view;
+static PollStats g_pollStats;
+static std::vector<std::unique_ptr<SessionStore>> g_sessions;   // per member, next to the exe; none in lifetime mode
+static std::vector<std::unique_ptr<HistoryStore>> g_histories;  // per member in lifetime mode, ingest thread only
+static NameCache   g_names;                       // names.kfn next to the exe, ingest thread only
+static std::string g_namesPath;
+static uint64_t    g_namesSaved = 0;              // g_names.changes at the last save
+static HANDLE g_ingestThread = nullptr;
+static HANDLE g_stopEvent    = nullptr;
+#define WM_APP_SNAPSHOT (WM_APP + 1)
+
+// Live reload (UI thread). The exe folder is watched; the folder also holds the session journal and
+// metrics.log, so a change there only means config.json is worth a look (see ReloadConfigIfChanged).
+struct FileStamp {
+    uint64_t time = 0, size = 0;
+    bool operator==(const FileStamp& o) const { return time == o.time && size == o.size; }
+};
+static HANDLE       g_configWatch = INVALID_HANDLE_VALUE;
+static bool         g_configTimerArmed = false;
+static FileStamp    g_configStamp;          // config.json as last read
+static std::wstring g_configNote;           // why the last edit was not applied; shown on the HUD line
+
+// Context menu
+static HMENU g_ctxMenu = nullptr;
+static HMENU g_rankMenu = nullptr;   // "Rank by" submenu of g_ctxMenu
+#define IDM_EXIT  1001
+#define IDM_RENDER_STATS 1002
+#define IDM_HUD   1003
+#define IDM_RANK_VIEW 1100    // + 0 the totals, + 1.. each rolling window
+
+// For legacy chroma path (ignored when transparent_bg=true)
+static COLORREF g_chroma    = RGB(255,0,255);
+static COLORREF g_textColor = RGB(0,0,0);
+
+// =========================== Utilities ======================
+static int Clamp255(int v){ return v<0?0:(v>255?255:v); }
+
+static bool ReadFileUtf8(const std::wstring& path, std::string& out){
+    out.clear();
+    FILE* f = _wfopen(path.c_str(), L"rb");
+    if(!f) return false;
+    char buf[4096]; size_t n;
+    while((n=fread(buf,1,sizeof(buf),f))>0) out.append(buf, buf+n);
+    fclose(f);
+    if(out.size()>=3 && (unsigned char)out[0]==0xEF &&
+       (unsigned char)out[1]==0xBB && (unsigned char)out[2]==0xBF)
+        out.erase(0,3);
+    return true;
+}
+
+static std::wstring GetExecutableDir(){
+    wchar_t path[MAX_PATH];
+    GetModuleFileNameW(nullptr, path, MAX_PATH);
+    wchar_t* last = nullptr;
+    for (wchar_t* p = path; *p; ++p) if (*p == L'\\' || *p == L'/') last = p;
+    if (last) *last = L'\0';
+    return path;
+}
+
+// ====================== Networking (WinINet) ======================
+// Session and connection handles live as long as the ingest thread; only the request handle is
+// per call. After a failed request both are dropped and reopened once before giving up. The body
+// goes to the caller one InternetReadFile buffer at a time.
+class WinInetTransport : public HttpTransport {
+public:
+    ~WinInetTransport() override { Reset(); }
+
+    bool GetChunks(const std::wstring& path, const std::function<void(const char*, size_t)>& sink,
+                   std::wstring& err) override {
+        StageTimer timer(Stage::Fetch);
+        Metrics& m = PipelineMetrics();
+        ++stats_.requests;
+        m.Add(Counter::Requests);
+        for (int attempt = 0; attempt < 2; ++attempt){
+            bool reused = (hConnect_ != nullptr);
+            if (!hConnect_ && !Open(err)) break;
+            size_t delivered = 0, decoded = 0;
+            if (Request(path, sink, delivered, decoded, err)){
+                m.Add(Counter::Bytes, delivered);
+                m.Add(Counter::Decoded, decoded);
+                return true;
+            }
+            Reset();
+            if (!reused || decoded) break;
+        }
+        ++stats_.failures;
+        m.Add(Counter::Failures);
+        return false;
+    }
+
+    void Reset() override {
+        if (hConnect_)  { InternetCloseHandle(hConnect_);  hConnect_  = nullptr; }
+        if (hInternet_) { InternetCloseHandle(hInternet_); hInternet_ = nullptr; }
+    }
+
+private:
+    bool Open(std::wstring& err){
+        hInternet_ = InternetOpenW(L"PS2Overlay/1.0", INTERNET_OPEN_TYPE_PRECONFIG, NULL, NULL, 0);
+        if(!hInternet_){ err = L"InternetOpen failed"; return false; }
+        INTERNET_PORT port = g_apiPort ? g_apiPort : (g_apiUseHttps ? INTERNET_DEFAULT_HTTPS_PORT : INTERNET_DEFAULT_HTTP_PORT);
+        hConnect_ = InternetConnectW(hInternet_, g_apiHost, port, NULL, NULL, INTERNET_SERVICE_HTTP, 0, 0);
+        if(!hConnect_){ err = L"InternetConnect failed"; Reset(); return false; }
+        ++stats_.connects;
+        return true;
+    }
+
+    // Asks for gzip/deflate; WinINet hands the body over as sent (HTTP decoding is off by default)
+    // and Inflater decodes it, unless the server answered in identity.
+    bool Request(const std::wstring& path, const std::function<void(const char*, size_t)>& sink, size_t& delivered,
+                 size_t& decoded, std::wstring& err){
+        DWORD flags = INTERNET_FLAG_RELOAD | INTERNET_FLAG_NO_CACHE_WRITE | INTERNET_FLAG_KEEP_CONNECTION;
+        if(g_apiUseHttps) flags |= INTERNET_FLAG_SECURE;
+
+        const wchar_t* accept[] = { L"*/*", nullptr };
+        HINTERNET hReq = HttpOpenRequestW(hConnect_, L"GET", path.c_str(), NULL, NULL, accept, flags, 0);
+        if(!hReq){ err = L"HttpOpenRequest failed"; return false; }
+
+        // Returns once the response headers are in, after connecting first if the connection is new.
+        StageTimer ttfb(Stage::Ttfb);
+        const std::wstring headers = L"Accept-Encoding: " + Utf8ToWide(AcceptedCodings()) + L"\r\n";
+        if(!HttpSendRequestW(hReq, headers.c_str(), (DWORD)-1L, NULL, 0)){
+            err = L"HttpSendRequest failed";
+            InternetCloseHandle(hReq);
+            return false;
+        }
+        ttfb.Stop();
+
+        wchar_t enc[64] = L""; DWORD encLen = sizeof(enc);
+        ContentCoding coding = ContentCoding::Identity;
+        if(HttpQueryInfoW(hReq, HTTP_QUERY_CONTENT_ENCODING, enc, &encLen, NULL)) coding = ParseContentCoding(WideToUtf8(enc));
+        if(coding == ContentCoding::Unsupported){
+            err = L"unsupported Content-Encoding";
+            InternetCloseHandle(hReq);
+            return false;
+        }
+        std::unique_ptr<Inflater> inflater;
+        if(coding != ContentCoding::Identity) inflater = std::make_unique<Inflater>(coding);
+        auto out = [&](const char* p, size_t n){ decoded += n; sink(p, n); };
+
+        char buf[16384]; DWORD rd=0;
+        size_t got = 0;
+        bool readOk;
+        while((readOk = InternetReadFile(hReq, buf, sizeof(buf), &rd) != FALSE) && rd>0){
+            got += rd;
+            if(inflater) inflater->Feed(buf, rd, out); else out(buf, rd);
+        }
+        delivered += got;
+
+        // As HttpSocketTransport: a read that fails, or stops short of Content-Length, is an error.
+        DWORD length = 0, lengthSize = sizeof(length);
+        const bool sized = HttpQueryInfoW(hReq, HTTP_QUERY_CONTENT_LENGTH | HTTP_QUERY_FLAG_NUMBER, &length, &lengthSize, NULL) != FALSE;
+        InternetCloseHandle(hReq);
+        if(!readOk || (sized && got < length)){
+            err = L"truncated body";
+            return false;
+        }
+        if(inflater && !inflater->Done()){
+            const char* why = inflater->Failed() ? inflater->Error() : "compressed body cut short";
+            err = Utf8ToWide(why);
+            return false;
+        }
+        return true;
+    }
+
+    HINTERNET hInternet_ = nullptr;
+    HINTERNET hConnect_  = nullptr;
+};
+
+// Owned by the ingest thread. g_stream is created before the thread starts so StopIngest can Abort it.
+static std::unique_ptr<HttpTransport>   g_http;
+static std::unique_ptr<StreamTransport> g_stream;
+
+static std::string FetchUrlBody(const std::wstring& path){
+    std::string body; std::wstring err;
+    if (!g_http) g_http = std::make_unique<WinInetTransport>();
+    if (!g_http->Get(path, body, err)) for (auto& m : g_squad.members) m->status = err;
+    return body;
+}
+
+// Death pages: parsed while they download instead of after (see DeathBatchParser).
+static bool FetchUrlChunks(const std::wstring& path, const ChunkSink& sink){
+    std::wstring err;
+    if (!g_http) g_http = std::make_unique<WinInetTransport>();
+    if (g_http->GetChunks(path, sink, err)) return true;
+    for (auto& m : g_squad.members) m->status = err;
+    return false;
+}
+
+// Catch-up workers: one WinINet connection each, kept for the life of the ingest thread. They run
+// beside the ingest thread, so errors only show up as a failed page, never in g_squad.
+static std::unique_ptr<PageFetcher> g_catchUp;
+
+static ChunkFetchFn MakeCatchUpFetch(){
+    std::shared_ptr<HttpTransport> http = std::make_shared<WinInetTransport>();
+    return [http](const std::wstring& path, const ChunkSink& sink){
+        std::wstring err;
+        return http->GetChunks(path, sink, err);
+    };
+}
+
+// ========================== Topmost/UI helpers =================
+static void SetTopMost(HWND hwnd, bool on){
+    SetWindowPos(hwnd, on ? HWND_TOPMOST : HWND_NOTOPMOST,
+                 0,0,0,0, SWP_NOMOVE|SWP_NOSIZE|SWP_NOACTIVATE|SWP_SHOWWINDOW);
+}
+static void ReassertTopMost(){
+    if (g_cfg.always_on_top && g_hwnd) {
+        SetWindowPos(g_hwnd, HWND_TOPMOST, 0,0,0,0,
+                     SWP_NOMOVE|SWP_NOSIZE|SWP_NOACTIVATE);
+    }
+}
+static void FillRankMenu(){
+    while (GetMenuItemCount(g_rankMenu) > 0) DeleteMenu(g_rankMenu, 0, MF_BYPOSITION);
+    const std::vector<int> w = WindowMinutes();
+    AppendMenuW(g_rankMenu, MF_STRING, IDM_RANK_VIEW, L"Session");
+    for (size_t i = 0; i < w.size(); ++i)
+        AppendMenuW(g_rankMenu, MF_STRING, IDM_RANK_VIEW + 1 + i, (L"Last " + to_wstring_compat(w[i]) + L" min").c_str());
+    CheckMenuRadioItem(g_rankMenu, IDM_RANK_VIEW, IDM_RANK_VIEW + (UINT)w.size(), IDM_RANK_VIEW + 1 + ConfiguredView(), MF_BYCOMMAND);
+}
+
+static void EnsureContextMenu(){
+    if (!g_ctxMenu) {
+        g_ctxMenu = CreatePopupMenu();
+        g_rankMenu = CreatePopupMenu();
+        FillRankMenu();
+        AppendMenuW(g_ctxMenu, MF_POPUP, (UINT_PTR)g_rankMenu, L"Rank by");
+        AppendMenuW(g_ctxMenu, MF_STRING, IDM_RENDER_STATS, L"Stats");
+        AppendMenuW(g_ctxMenu, MF_STRING | (g_cfg.show_hud ? MF_CHECKED : 0), IDM_HUD, L"Metrics HUD");
+        AppendMenuW(g_ctxMenu, MF_STRING, IDM_EXIT, L"Exit");
+    }
+}
+
+// ========================== Render bookkeeping ============================
+// GDI allocations are DCs, bitmaps and brushes created by the paint paths. Steady state is zero
+// per frame; only the first frame and resizes create anything.
+struct RenderStats {
+    unsigned long long skipped    = 0;  // snapshots that changed nothing on screen
+    unsigned long long resizes    = 0;  // DIB (re)creations
+    unsigned long long gdiCreates = 0;  // lifetime total
+    unsigned long long lastFrameGdi = 0;
+    unsigned long long lastFrameGlyphs = 0;  // glyphs rasterized by the last frame (atlas misses)
+} g_renderStats;
+
+// Whatever changes what the window shows (new snapshot content, resize, config, HUD) calls
+// MarkDirty; nothing paints on the spot. The message loop draws one frame per turn once its queue
+// is empty (PresentFrame), so a burst of snapshots during a catch-up costs one repaint, and never
+// more than max_fps a second. FRAME_TIMER_ID covers what the loop can't: a frame held back by the
+// cap, and modal loops (menu, Stats box, dragging) that dispatch messages without it.
+static FramePacer g_pacer;
+static bool       g_frameTimerArmed = false;
+
+static void ArmFrameTimer(uint64_t waitUs){
+    if (g_frameTimerArmed || !g_hwnd) return;
+    const UINT ms = (UINT)std::max<uint64_t>(USER_TIMER_MINIMUM, (waitUs + 999) / 1000);
+    g_frameTimerArmed = SetTimer(g_hwnd, FRAME_TIMER_ID, ms, nullptr) != 0;
+}
+
+static void MarkDirty(){
+    g_pacer.Request();
+    ArmFrameTimer(0);
+}
+
+// ========================== Text font ============================
+// Created once from window_size (the stock GUI face at that height) and shared by both paint paths.
+static HFONT g_textFont      = nullptr;
+static bool  g_textFontOwned = false;
+
+static HFONT EnsureTextFont(){
+    if (g_textFont) return g_textFont;
+    HFONT stock = (HFONT)GetStockObject(DEFAULT_GUI_FONT);
+    int px = TextPixelHeight(g_cfg.window_size);
+    LOGFONTW lf{};
+    if (px > 0 && GetObjectW(stock, sizeof(lf), &lf)){
+        lf.lfHeight  = -px;
+        lf.lfWidth   = 0;
+        lf.lfQuality = ANTIALIASED_QUALITY;
+        g_textFont = CreateFontIndirectW(&lf);
+        if (g_textFont){ g_textFontOwned = true; ++g_renderStats.gdiCreates; }
+    }
+    if (!g_textFont){ g_textFont = stock; g_textFontOwned = false; }
+    return g_textFont;
+}
+
+static void ReleaseTextFont(){
+    if (g_textFont && g_textFontOwned) DeleteObject(g_textFont);
+    g_textFont = nullptr; g_textFontOwned = false;
+}
+
+// Glyph coverage straight from the font outline (65 gray levels), no DrawTextW involved.
+class GdiGlyphSource : public GlyphSource {
+public:
+    explicit GdiGlyphSource(HDC dc) : dc_(dc) {}
+
+    FontMetrics Metrics() override {
+        TEXTMETRICW tm{}; GetTextMetricsW(dc_, &tm);
+        return {(int)tm.tmAscent, (int)tm.tmHeight};
+    }
+
+    bool Rasterize(uint32_t ch, GlyphBitmap& out) override {
+        static const MAT2 identity{{0,1},{0,0},{0,0},{0,1}};
+        GLYPHMETRICS gm{};
+        DWORD need = GetGlyphOutlineW(dc_, ch, GGO_GRAY8_BITMAP, &gm, 0, nullptr, &identity);
+        if (need == GDI_ERROR) return false;
+        out.advance = gm.gmCellIncX;
+        out.left    = gm.gmptGlyphOrigin.x;
+        out.top     = gm.gmptGlyphOrigin.y;
+        out.w = out.h = 0;
+        out.coverage.clear();
+        if (need == 0) return true;  // blank (space)
+        buf_.resize(need);
+        if (GetGlyphOutlineW(dc_, ch, GGO_GRAY8_BITMAP, &gm, need, buf_.data(), &identity) == GDI_ERROR) return false;
+        out.w = (int)gm.gmBlackBoxX; out.h = (int)gm.gmBlackBoxY;
+        const int pitch = (out.w + 3) & ~3;  // rows are DWORD aligned
+        out.coverage.resize((size_t)out.w * out.h);
+        for (int y = 0; y < out.h; ++y)
+            for (int x = 0; x < out.w; ++x){
+                unsigned v = std::min<unsigned>(buf_[(size_t)y * pitch + x], 64);
+                out.coverage[(size_t)y * out.w + x] = (uint8_t)((v * 255 + 32) / 64);
+            }
+        return true;
+    }
+
+private:
+    HDC dc_;
+    std::vector<uint8_t> buf_;
+};
+
+// ========================== Alpha-layer rendering ============================
+// Backbuffer for the layered window: memory DC with a 32-bit top-down DIB and the font selected,
+// kept for the window's lifetime. Only the DIB is replaced, and only when the client size changes.
+// Text comes from the glyph atlas; the font in the DC is only used to rasterize atlas misses.
+struct LayeredSurface {
+    HDC     dc      = nullptr;
+    HBITMAP dib     = nullptr;
+    HGDIOBJ oldBmp  = nullptr;
+    HGDIOBJ oldFont = nullptr;
+    void*   bits    = nullptr;
+    int     w = 0, h = 0;
+    int     lineH = 0;
+};
+static LayeredSurface g_surface;
+static std::unique_ptr<GdiGlyphSource> g_glyphSource;
+static GlyphAtlas g_atlas;
+
+// Create a 32-bit DIB section (premultiplied ARGB) and backbuffer DC.
+static HBITMAP CreateDIB32(HDC ref, int w, int h, void** outBits){
+    BITMAPINFO bmi{};
+    bmi.bmiHeader.biSize        = sizeof(BITMAPINFOHEADER);
+    bmi.bmiHeader.biWidth       = w;
+    bmi.bmiHeader.biHeight      = -h; // top-down
+    bmi.bmiHeader.biPlanes      = 1;
+    bmi.bmiHeader.biBitCount    = 32;
+    bmi.bmiHeader.biCompression = BI_RGB; // we'll manage alpha manually
+    void* bits = nullptr;
+    HBITMAP hbmp = CreateDIBSection(ref, &bmi, DIB_RGB_COLORS, &bits, nullptr, 0);
+    if (outBits) *outBits = bits;
+    return hbmp;
+}
+
+static bool EnsureSurface(int W, int H){
+    LayeredSurface& s = g_surface;
+    if (!s.dc){
+        s.dc = CreateCompatibleDC(nullptr);
+        if (!s.dc) return false;
+        ++g_renderStats.gdiCreates;
+        s.oldFont = SelectObject(s.dc, EnsureTextFont());
+        g_glyphSource.reset(new GdiGlyphSource(s.dc));
+        g_atlas.Reset(g_glyphSource.get());
+        s.lineH = g_atlas.Height() + 6;
+    }
+    if (s.dib && s.w == W && s.h == H) return true;
+
+    if (s.dib){ SelectObject(s.dc, s.oldBmp); DeleteObject(s.dib); s.dib = nullptr; }
+    s.dib = CreateDIB32(s.dc, W, H, &s.bits);
+    if (!s.dib){ s.w = s.h = 0; return false; }
+    ++g_renderStats.gdiCreates;
+    ++g_renderStats.resizes;
+    s.oldBmp = SelectObject(s.dc, s.dib);
+    s.w = W; s.h = H;
+    return true;
+}
+
+static void ReleaseSurface(){
+    LayeredSurface& s = g_surface;
+    if (!s.dc) return;
+    if (s.dib){ SelectObject(s.dc, s.oldBmp); DeleteObject(s.dib); }
+    SelectObject(s.dc, s.oldFont);
+    DeleteDC(s.dc);
+    s = LayeredSurface{};
+    g_atlas.Reset(nullptr);
+    g_glyphSource.reset();
+}
+
+// Status, "Killed by" line and the nemesis rows, in whatever font/color dc has selected.
+// The HUD line, when on, goes at the bottom.
+static void DrawOverlayText(HDC dc, int left, int top, int right, int bottom, int lineH){
+    if (!g_view->hud.empty()){
+        RECT rh{left, bottom - lineH, right, bottom};
+        DrawTextW(dc, g_view->hud.c_str(), (int)g_view->hud.size(), &rh, DT_LEFT|DT_SINGLELINE|DT_NOPREFIX);
+    }
+    int y = top;
+    RECT r{left,y, right, y+lineH};
+    DrawTextW(dc, g_view->status.c_str(), (int)g_view->status.size(), &r, DT_LEFT|DT_SINGLELINE|DT_NOPREFIX);
+    y += lineH + 2;
+
+    // Nemesis rows; formatted on the stack so a frame does not touch the heap.
+    wchar_t buf[256];
+    auto block = [&](const std::wstring& line, const std::vector<DisplayRow>& rows){
+        RECT r2{left,y, right, y+lineH};
+        DrawTextW(dc, line.c_str(), (int)line.size(), &r2, DT_LEFT|DT_SINGLELINE|DT_NOPREFIX);
+        y += lineH + 6;
+        for (size_t i = 0; i < rows.size(); ++i) {
+            const DisplayRow& e = rows[i];
+            int n = swprintf(buf, sizeof(buf)/sizeof(buf[0]), L"%d) %ls  %d/%d",
+                             (int)i + 1, e.name.c_str(), e.cnt.hs, e.cnt.tot);
+            if (n < 0) n = (int)wcslen(buf);
+            RECT r3{left,y, right, y+lineH};
+            DrawTextW(dc, buf, n, &r3, DT_LEFT|DT_SINGLELINE|DT_NOPREFIX);
+            y += lineH;
+        }
+    };
+    block(g_view->line, g_view->rows);
+    for (const DisplayBlock& b : g_view->squad){ y += 6; block(b.line, b.rows); }
+}
+
+// Composes text as WHITE onto black from the glyph atlas, then converts white intensity -> alpha
+// and tints to config color.
+// Finally pushes to the layered window with UpdateLayeredWindow; between pushes the layered
+// window keeps showing the last bitmap. Only PresentFrame calls this.
+static void RepaintLayered(){
+    if (!g_hwnd || !g_view) return;
+
+    RECT rc; GetClientRect(g_hwnd, &rc);
+    int W = rc.right - rc.left, H = rc.bottom - rc.top;
+    if (W<=0 || H<=0) return;
+
+    const unsigned long long gdi0 = g_renderStats.gdiCreates;
+    if (!EnsureSurface(W, H)) return;
+    StageTimer timer(Stage::Repaint);
+    HDC memDC = g_surface.dc;
+    void* bits = g_surface.bits;
+    const uint64_t glyphs0 = g_atlas.rasterized;
+
+    // Clear to black (RGB=0, alpha=0)
+    GdiFlush();
+    memset(bits, 0x00, (size_t)W*H*4);
+
+    ComposeOverlayText(g_atlas, *g_view, (uint32_t*)bits, W, H, 8, 6, W-8, g_surface.lineH);
+
+    // Convert white->alpha; set RGB to configured color (premultiplied)
+    TintWhiteToPremultiplied((uint32_t*)bits, (size_t)W*H,
+                             (uint8_t)g_cfg.text_r, (uint8_t)g_cfg.text_g, (uint8_t)g_cfg.text_b);
+
+    // Push to window
+    SIZE  sz{W,H};
+    POINT ptSrc{0,0};
+    BLENDFUNCTION bf{AC_SRC_OVER, 0, 255, AC_SRC_ALPHA};
+
+    LONG ex = GetWindowLongW(g_hwnd, GWL_EXSTYLE);
+    if(!(ex & WS_EX_LAYERED)) SetWindowLongW(g_hwnd, GWL_EXSTYLE, ex | WS_EX_LAYERED);
+
+    RECT wr; GetWindowRect(g_hwnd, &wr);
+    POINT wndPos{wr.left, wr.top};
+
+    UpdateLayeredWindow(g_hwnd, nullptr, &wndPos, &sz, memDC, &ptSrc, 0, &bf, ULW_ALPHA);
+
+    g_pacer.Drawn(MonoMicros());
+    PipelineMetrics().Add(Counter::Frames);
+    g_renderStats.lastFrameGdi = g_renderStats.gdiCreates - gdi0;
+    g_renderStats.lastFrameGlyphs = g_atlas.rasterized - glyphs0;
+}
+
+// ========================== Legacy (uniform alpha) painting ===================
+static void PaintLegacyOpaque(HDC hdc, RECT rc){
+    if (!g_view) return;
+    StageTimer timer(Stage::Repaint);
+    // Fill white background (legacy path)
+    FillRect(hdc, &rc, (HBRUSH)GetStockObject(WHITE_BRUSH));
+
+    HFONT hOld  = (HFONT)SelectObject(hdc, EnsureTextFont());
+    SetBkMode(hdc, TRANSPARENT);
+    SetTextColor(hdc, g_textColor); // use configured color
+
+    TEXTMETRICW tm{}; GetTextMetricsW(hdc,&tm);
+    DrawOverlayText(hdc, rc.left + 8, rc.top + 6, rc.right - 8, rc.bottom, tm.tmHeight + 6);
+    SelectObject(hdc, hOld);
+
+    g_pacer.Drawn(MonoMicros());
+    PipelineMetrics().Add(Counter::Frames);
+    g_renderStats.lastFrameGdi = 0;
+    g_renderStats.lastFrameGlyphs = 0;
+}
+
+static void ShowRenderStats(HWND hwnd){
+    wchar_t buf[640];
+    swprintf(buf, sizeof(buf)/sizeof(buf[0]),
+             L"Frames drawn: %llu\nRepaint requests: %llu (%llu folded into a pending frame, %llu waits for max_fps)\n"
+             L"Snapshots skipped (unchanged): %llu\nSurface (re)creations: %llu\n"
+             L"GDI objects created (total): %llu\nGDI objects created by the last frame: %llu\n"
+             L"Glyphs cached: %llu (%llu KB atlas)\nGlyphs rasterized by the last frame: %llu\n\n"
+             L"API requests: %llu (%.0f per hour)\nMedian detection latency: %.1f s",
+             (unsigned long long)g_pacer.Frames(), (unsigned long long)g_pacer.Requests(),
+             (unsigned long long)g_pacer.Coalesced(), (unsigned long long)g_pacer.Held(),
+             g_renderStats.skipped, g_renderStats.resizes,
+             g_renderStats.gdiCreates, g_renderStats.lastFrameGdi,
+             (unsigned long long)g_atlas.Glyphs(), (unsigned long long)(g_atlas.AtlasBytes() / 1024),
+             g_renderStats.lastFrameGlyphs,
+             (unsigned long long)g_pollStats.Requests(), g_pollStats.RequestsPerHour(),
+             g_pollStats.MedianLatencyMs() / 1000.0);
+    MessageBoxW(hwnd, buf, L"Stats", MB_OK);
+}
+
+// ========================== Metrics HUD and log ============================
+// Both run on the UI thread off METRICS_TIMER_ID. The HUD shows p50/p99 since start; each log
+// block has what happened since the previous one, then the totals.
+static std::unique_ptr<MetricsLog> g_metricsLog;   // metrics.log next to the exe; null when off
+static MetricsSnapshot g_metricsLogged;            // as of the last log block
+static int             g_metricsTicks = 0;
+
+static void UpdateHud(){
+    if (!g_view) return;
+    std::wstring hud = g_configNote;
+    if (g_cfg.show_hud){
+        MetricsSnapshot m; PipelineMetrics().Take(m);
+        std::wstring line = MetricsHudLine(m);
+        if (line.empty()) line = L"(no samples yet)";
+        hud = hud.empty() ? line : hud + L"  |  " + line;
+    }
+    if (hud == g_view->hud) return;
+    g_view->hud = hud;
+    MarkDirty();
+}
+
+static void WriteMetricsLog(){
+    if (!g_metricsLog) return;
+    MetricsSnapshot now; PipelineMetrics().Take(now);
+    g_metricsLog->Write(now.Since(g_metricsLogged), now, (uint64_t)std::chrono::duration_cast<std::chrono::milliseconds>(
+                            std::chrono::system_clock::now().time_since_epoch()).count());
+    g_metricsLogged = now;
+}
+
+static void OpenMetricsLog(){
+    g_metricsLog = std::make_unique<MetricsLog>(WideToUtf8(GetExecutableDir() + L"\\metrics.log"));
+    PipelineMetrics().Take(g_metricsLogged);
+    g_metricsTicks = 0;
+}
+
+static void OnMetricsTimer(){
+    UpdateHud();
+    if (g_metricsLog && ++g_metricsTicks >= g_cfg.metrics_log_seconds){ g_metricsTicks = 0; WriteMetricsLog(); }
+}
+
+// ========================== Window/config helpers =================
+static void SetTopMostIfNeeded(){
+    if (g_cfg.always_on_top && g_hwnd) {
+        SetWindowPos(g_hwnd, HWND_TOPMOST, 0,0,0,0, SWP_NOMOVE|SWP_NOSIZE|SWP_NOACTIVATE);
+    }
+}
+
+static void ApplyWindowConfig(HWND hwnd){
+    SetWindowPos(hwnd, nullptr, g_cfg.window.x, g_cfg.window.y, g_cfg.window.w, g_cfg.window.h,
+                 SWP_NOZORDER | SWP_NOACTIVATE);
+
+    LONG ex = GetWindowLongW(hwnd, GWL_EXSTYLE);
+    if(!(ex & WS_EX_LAYERED)) SetWindowLongW(hwnd, GWL_EXSTYLE, ex | WS_EX_LAYERED);
+
+    if (!g_cfg.transparent_bg){
+        // Uniform alpha for legacy opaque window
+        BYTE a = (BYTE) (g_cfg.window.alpha<0?0:(g_cfg.window.alpha>255?255:g_cfg.window.alpha));
+        SetLayeredWindowAttributes(hwnd, 0, a, LWA_ALPHA);
+    }
+    SetTopMostIfNeeded();
+}
+
+// One pass over the file: top-level keys, plus x/y/w/h/alpha inside "window". Starts from the
+// defaults, so a key taken out of the file goes back to its default. False when the JSON is broken
+// (a file caught half-saved counts as broken).
+static bool ParseConfig(const std::string& j, AppCfg& cfg){
+    cfg = AppCfg{};
+    JsonScanner sc(j);
+    if(sc.Next() != JsonTok::ObjBegin) return false;
+    for(;;){
+        JsonTok t = sc.Next();
+        if(t==JsonTok::End || t==JsonTok::Error) return false;
+        if(sc.Depth()<=0) break;
+        if(t!=JsonTok::Key) continue;
+        const int depth = sc.Depth();
+        std::string_view k = sc.Text();
+        JsonTok vt = sc.Next();
+        std::string_view val = sc.Text();
+
+        if(depth==1 && k=="window" && vt==JsonTok::ObjBegin) continue; // descend
+        if(depth==1 && k=="character_names" && vt==JsonTok::ArrBegin){
+            cfg.character_names.clear();
+            for(JsonTok e = sc.Next(); e!=JsonTok::ArrEnd && e!=JsonTok::End && e!=JsonTok::Error; e = sc.Next()){
+                if(e==JsonTok::String){ std::wstring n = Utf8ToWide(JsonText(sc)); if(!n.empty()) cfg.character_names.push_back(n); }
+                else sc.SkipValue(e);
+            }
+            continue;
+        }
+        if(depth==1 && k=="windows_minutes" && vt==JsonTok::ArrBegin){
+            cfg.windows_minutes.clear();
+            for(JsonTok e = sc.Next(); e!=JsonTok::ArrEnd && e!=JsonTok::End && e!=JsonTok::Error; e = sc.Next()){
+                int m = 0;
+                if(e==JsonTok::Number && JsonToInt(sc.Text(), m) && m > 0) cfg.windows_minutes.push_back(std::min(m, 24 * 60));
+                else sc.SkipValue(e);
+            }
+            continue;
+        }
+        if(vt==JsonTok::ObjBegin || vt==JsonTok::ArrBegin){ sc.SkipValue(vt); continue; }
+
+        int v = 0;
+        bool isInt  = (vt==JsonTok::Number) && JsonToInt(val, v);
+        bool isBool = (vt==JsonTok::True || vt==JsonTok::False);
+        bool b      = (vt==JsonTok::True);
+
+        if(depth==2){
+            if(!isInt) continue;
+            if     (k=="x")     cfg.window.x     = v;
+            else if(k=="y")     cfg.window.y     = v;
+            else if(k=="w")     cfg.window.w     = v;
+            else if(k=="h")     cfg.window.h     = v;
+            else if(k=="alpha") cfg.window.alpha = v;
+            continue;
+        }
+        if(depth!=1) continue;
+
+        if(vt==JsonTok::String){
+            if     (k=="service_id")     cfg.service_id     = Utf8ToWide(JsonText(sc));
+            else if(k=="character_name") cfg.character_name = Utf8ToWide(JsonText(sc));
+        } else if(isInt){
+            if     (k=="poll_ms")  cfg.poll_ms  = v;
+            else if(k=="poll_max_ms") cfg.poll_max_ms = v;
+            else if(k=="catchup_workers") cfg.catchup_workers = std::min(std::max(1, v), 8);
+            else if(k=="metrics_log_seconds") cfg.metrics_log_seconds = std::max(0, v);
+            else if(k=="max_fps") cfg.max_fps = std::min(std::max(0, v), 240);
+            else if(k=="world_id") cfg.world_id = v;
+            else if(k=="max_rows")           cfg.max_rows           = std::max(0, v);
+            else if(k=="min_deaths_to_list") cfg.min_deaths_to_list = std::max(1, v);
+            else if(k=="window_size")        cfg.window_size        = std::max(0, v);
+            else if(k=="rank_by_minutes")    cfg.rank_by_minutes    = std::min(std::max(0, v), 24 * 60);
+            else if(k=="chroma_r") cfg.chroma_r = Clamp255(v);
+            else if(k=="chroma_g") cfg.chroma_g = Clamp255(v);
+            else if(k=="chroma_b") cfg.chroma_b = Clamp255(v);
+            else if(k=="text_r")   cfg.text_r   = Clamp255(v);
+            else if(k=="text_g")   cfg.text_g   = Clamp255(v);
+            else if(k=="text_b")   cfg.text_b   = Clamp255(v);
+        } else if(isBool){
+            if     (k=="transparent_bg")   cfg.transparent_bg   = b;
+            else if(k=="lock_position")    cfg.lock_position    = b;
+            else if(k=="always_on_top")    cfg.always_on_top    = b;
+            else if(k=="skip_environment") cfg.skip_environment = b;
+            else if(k=="use_stream")       cfg.use_stream       = b;
+            else if(k=="show_hud")         cfg.show_hud         = b;
+            else if(k=="lifetime")         cfg.lifetime         = b;
+        }
+    }
+    if(cfg.service_id.empty()) cfg.service_id = L"s:example";
+    return true;
+}
+
+// What follows from g_cfg on the UI side.
+static void DeriveFromConfig(){
+    g_chroma    = RGB(g_cfg.chroma_r, g_cfg.chroma_g, g_cfg.chroma_b);
+    g_textColor = RGB(g_cfg.text_r, g_cfg.text_g, g_cfg.text_b);
+    TIMER_MS = (g_cfg.poll_ms>100 ? (UINT)g_cfg.poll_ms : 1000);
+    g_pacer.SetMaxFps(g_cfg.max_fps);
+}
+
+static std::wstring ConfigPath(){ return GetExecutableDir() + L"\\config.json"; }
+
+// config.json's last write time and size; all zero while there is no such file.
+static FileStamp ConfigStamp(){
+    WIN32_FILE_ATTRIBUTE_DATA fa;
+    if(!GetFileAttributesExW(ConfigPath().c_str(), GetFileExInfoStandard, &fa)) return FileStamp{};
+    return FileStamp{ ((uint64_t)fa.ftLastWriteTime.dwHighDateTime << 32) | fa.ftLastWriteTime.dwLowDateTime,
+                      ((uint64_t)fa.nFileSizeHigh << 32) | fa.nFileSizeLow };
+}
+
+static bool LoadConfigFromFile(){
+    g_configStamp = ConfigStamp();
+    std::string j; AppCfg cfg;
+    const bool ok = ReadFileUtf8(ConfigPath(), j) && ParseConfig(j, cfg);
+    if(ok) g_cfg = cfg;
+    DeriveFromConfig();
+    return ok;
+}
+
+// One member per character_names entry (or just character_name).
+static void BuildSquad(const std::wstring& status){
+    std::vector<std::wstring> names = g_cfg.character_names;
+    if (names.empty()) names.push_back(g_cfg.character_name);
+    g_squad = Squad{};
+    for (const std::wstring& n : names){
+        auto st = std::make_unique<KillfeedState>();
+        st->serviceId       = g_cfg.service_id.empty() ? L"s:example" : g_cfg.service_id;
+        st->characterName   = n;
+        st->skipEnvironment = g_cfg.skip_environment;
+        st->status          = status;
+        st->nameCache       = &g_names;
+        for (int m : WindowMinutes()) st->windows.emplace_back((unsigned)m * 60);
+        g_squad.members.push_back(std::move(st));
+    }
+}
+
+// ========================== Ingest thread (fetch + parse + apply) ================
+// Everything that touches the network or g_squad runs here. After each change it publishes a
+// fresh snapshot and, if the UI had already consumed the previous one, posts WM_APP_SNAPSHOT.
+// Every publish is also a sync point for the session journal.
+// What the ingest thread takes from the config. It works from its own copy, g_ingestCfg (set before
+// the thread starts); after a reload the UI thread leaves a new one in g_ingestCfgNext and signals
+// g_configEvent, and the thread takes it at its next wait.
+struct IngestCfg {
+    int  poll_ms = 1000, poll_max_ms = 5000;
+    int  catchup_workers = 4;
+    int  max_rows = 3, min_deaths_to_list = 1;
+    bool skip_environment = true;
+    std::vector<int> windows;       // WindowMinutes()
+    int  view = -1;                 // ConfiguredView()
+};
+static IngestCfg  g_ingestCfg;
+static IngestCfg  g_ingestCfgNext;
+static std::mutex g_ingestCfgLock;
+static HANDLE     g_configEvent = nullptr;   // auto-reset
+static bool       g_restartPending = false;  // ingest restart waiting for the old thread to end
+static bool       g_restartRebuild = false;  //   ... with a new squad
+
+static IngestCfg IngestCfgFromConfig(){
+    return { (int)TIMER_MS, g_cfg.poll_max_ms, g_cfg.catchup_workers,
+             g_cfg.max_rows, g_cfg.min_deaths_to_list, g_cfg.skip_environment,
+             WindowMinutes(), ConfiguredView() };
+}
+
+static void PostIngestCfg(){
+    { std::lock_guard<std::mutex> lock(g_ingestCfgLock); g_ingestCfgNext = IngestCfgFromConfig(); }
+    if (g_configEvent) SetEvent(g_configEvent);
+}
+
+static void SaveNames(){
+    if (g_names.changes != g_namesSaved && SaveNameCache(g_names, g_namesPath)) g_namesSaved = g_names.changes;
+}
+
+// The rolling windows run on the wall clock, so they drain while nobody is killing the player.
+// True when deaths dropped out of one.
+static bool AdvanceSquadWindows(){
+    const unsigned long long now = (unsigned long long)std::chrono::duration_cast<std::chrono::seconds>(
+                                       std::chrono::system_clock::now().time_since_epoch()).count();
+    bool changed = false;
+    for (auto& m : g_squad.members) changed = AdvanceWindows(*m, now) || changed;
+    return changed;
+}
+
+static void PublishSnapshot(){
+    for (size_t i = 0; i < g_sessions.size(); ++i) g_sessions[i]->Sync(*g_squad.members[i]);
+    if (g_names.changes - g_namesSaved >= 256) SaveNames();
+    AdvanceSquadWindows();
+    if (g_mailbox.Publish(BuildSquadSnapshot(g_squad, (size_t)g_ingestCfg.max_rows, g_ingestCfg.min_deaths_to_list, g_ingestCfg.view)) && g_hwnd)
+        PostMessageW(g_hwnd, WM_APP_SNAPSHOT, 0, 0);
+}
+
+// New windows start empty; the ones kept keep their counts.
+static void SetWindows(KillfeedState& st, const std::vector<int>& minutes){
+    std::vector<WindowCounts> next;
+    for (int m : minutes){
+        auto it = std::find_if(st.windows.begin(), st.windows.end(), [&](const WindowCounts& w){ return w.Seconds() == (unsigned)m * 60; });
+        if (it != st.windows.end()) next.push_back(std::move(*it));
+        else next.emplace_back((unsigned)m * 60);
+    }
+    st.windows = std::move(next);
+}
+
+// Sleeps up to ms; true once StopIngest asks the thread to end. New settings are put into effect
+// as soon as they arrive. When they change the poll timing and retimed is given, the wait ends
+// early and *retimed is set, so the caller can start over on the new interval.
+static bool IngestWait(DWORD ms, bool* retimed = nullptr){
+    const HANDLE events[2] = { g_stopEvent, g_configEvent };
+    const uint64_t until = GetTickCount64() + ms;
+    for (;;){
+        const uint64_t now = GetTickCount64();
+        const DWORD r = WaitForMultipleObjects(2, events, FALSE, now < until ? (DWORD)(until - now) : 0);
+        if (r == WAIT_OBJECT_0) return true;
+        if (r != WAIT_OBJECT_0 + 1) return false;
+        IngestCfg next;
+        { std::lock_guard<std::mutex> lock(g_ingestCfgLock); next = g_ingestCfgNext; }
+        const IngestCfg prev = g_ingestCfg;
+        g_ingestCfg = next;
+        for (auto& m : g_squad.members){
+            m->skipEnvironment = next.skip_environment;
+            if (next.windows != prev.windows) SetWindows(*m, next.windows);
+        }
+        // KillfeedStream holds on to the fetcher it was given; the stream keeps its worker count.
+        if (next.catchup_workers != prev.catchup_workers && !g_stream)
+            g_catchUp = std::make_unique<PageFetcher>(MakeCatchUpFetch, next.catchup_workers);
+        PublishSnapshot();   // max_rows / min_deaths_to_list / view
+        if (retimed && (next.poll_ms != prev.poll_ms || next.poll_max_ms != prev.poll_max_ms)){ *retimed = true; return false; }
+    }
+}
+
+// Lifetime mode: each member's counters come from its history store. What is on disk shows at
+// once; then the deaths since (the whole history, the first time) are fetched into the store and
+// the member is seeded again from it. Polling goes on from there; the deaths it counts reach the
+// store with the next start's backfill.
+static void BackfillHistories(){
+    for (size_t i = 0; i < g_squad.members.size(); ++i){
+        KillfeedState& st = *g_squad.members[i];
+        if (st.characterId.empty()) continue;
+        HistoryStore& h = *g_histories[i];
+        if (h.Open(ParseULL(st.characterId))){ h.Seed(st); PublishSnapshot(); }
+        BackfillRun run = HistoryBackfill(st, h, *g_catchUp, [&](size_t rows){
+            st.status = L"Fetching lifetime history: " + to_wstring_compat(rows) + L" deaths";
+            PublishSnapshot();
+        });
+        if (h.Rows()) h.Seed(st);
+        if (run.failed) st.status = L"Lifetime history incomplete; the rest comes next start";
+        PublishSnapshot();
+        if (WaitForSingleObject(g_stopEvent, 0) == WAIT_OBJECT_0) return;
+    }
+}
+
+static DWORD WINAPI IngestThreadProc(void*){
+    // Warm start: the saved session brings back counters, dedupe state and the character id,
+    // so the first poll only fetches what happened since the saved watermark.
+    // Names first: restored attackers and the first poll look them up in the cache.
+    LoadNameCache(g_names, g_namesPath);
+    g_namesSaved = g_names.changes;
+    bool restored = false;
+    for (size_t i = 0; i < g_sessions.size(); ++i) restored = g_sessions[i]->Load(*g_squad.members[i]) || restored;
+    if (restored) PublishSnapshot();
+    g_catchUp = std::make_unique<PageFetcher>(MakeCatchUpFetch, g_ingestCfg.catchup_workers);
+    // Pre-resolve character ids (one lookup for the whole squad) to speed up first poll
+    SquadResolveCharacters(g_squad, FetchUrlBody);
+    if (!g_histories.empty()) BackfillHistories();
+    if (g_stream){
+        KillfeedStream(*g_squad.members[0], *g_stream, FetchUrlBody, PublishSnapshot,
+                       [](int ms){ if (AdvanceSquadWindows()) PublishSnapshot(); return IngestWait((DWORD)ms); },
+                       g_catchUp.get(), FetchUrlChunks);
+    } else {
+        // Poll interval adapts to what the last poll found (see PollScheduler).
+        PollScheduler sched(g_ingestCfg.poll_ms, g_ingestCfg.poll_max_ms, GetTickCount64());
+        DWORD delay = (DWORD)g_ingestCfg.poll_ms;
+        bool retimed = false;
+        while (!IngestWait(delay, &retimed)){
+            if (retimed){
+                retimed = false;
+                sched = PollScheduler(g_ingestCfg.poll_ms, g_ingestCfg.poll_max_ms, GetTickCount64());
+            }
+            PollResult r = SquadPoll(g_squad, FetchUrlBody, PublishSnapshot, g_catchUp.get(), FetchUrlChunks);
+            const uint64_t now = GetTickCount64();
+            g_pollStats.Record(r, (uint64_t)std::chrono::duration_cast<std::chrono::milliseconds>(
+                                      std::chrono::system_clock::now().time_since_epoch()).count(), now);
+            PublishSnapshot();
+            delay = (DWORD)sched.Next(r, now);
+        }
+    }
+    for (size_t i = 0; i < g_sessions.size(); ++i){
+        KillfeedState& st = *g_squad.members[i];
+        if (!st.characterId.empty()) g_sessions[i]->Compact(st);
+        g_sessions[i]->Detach(st);
+    }
+    SaveNames();
+    g_catchUp.reset();
+    g_http.reset();
+    return 0;
+}
+
+static void StartIngest(){
+    // A lone character keeps session.kfs; squad members get one session per character.
+    // In lifetime mode the history store takes the session's place, one per character always.
+    g_sessions.clear();
+    g_histories.clear();
+    for (const auto& m : g_squad.members){
+        if (g_cfg.lifetime){
+            g_histories.emplace_back(new HistoryStore(WideToUtf8(GetExecutableDir() + L"\\history_" + ToLowerAscii(m->characterName))));
+            continue;
+        }
+        std::wstring base = GetExecutableDir() + L"\\session";
+        if (g_squad.members.size() > 1) base += L"_" + ToLowerAscii(m->characterName);
+        g_sessions.emplace_back(new SessionStore(WideToUtf8(base)));
+    }
+    g_namesPath = WideToUtf8(GetExecutableDir() + L"\\names.kfn");
+    // The stream subscribes one character; a squad always polls.
+    if (g_cfg.use_stream && g_squad.members.size() == 1) g_stream = MakeWinHttpStream(g_pushHost, INTERNET_DEFAULT_HTTPS_PORT);
+    g_ingestCfg = IngestCfgFromConfig();
+    if (!g_configEvent) g_configEvent = CreateEventW(nullptr, FALSE, FALSE, nullptr);
+    ResetEvent(g_configEvent);
+    if (g_stopEvent) CloseHandle(g_stopEvent);
+    g_stopEvent    = CreateEventW(nullptr, TRUE, FALSE, nullptr);
+    g_ingestThread = CreateThread(nullptr, 0, IngestThreadProc, nullptr, 0, nullptr);
+}
+
+// True once the thread has ended.
+static bool StopIngest(DWORD waitMs = 3000){
+    if (g_stopEvent) SetEvent(g_stopEvent);
+    if (g_stream) g_stream->Abort();
+    // A WinINet call in flight can take a while to give up; don't hang the exit on it.
+    if (g_ingestThread && WaitForSingleObject(g_ingestThread, waitMs) != WAIT_OBJECT_0) return false;
+    if (g_ingestThread){ CloseHandle(g_ingestThread); g_ingestThread = nullptr; }
+    g_stream.reset();
+    return true;
+}
+
+// Other characters or another service: the running thread compacts its sessions as at exit, the
+// squad is rebuilt from g_cfg and the new thread loads the sessions that go with it. A thread
+// stuck in a request is not waited for here; the metrics timer tries again each second.
+static void FinishIngestRestart(){
+    if (!StopIngest(0)) return;
+    if (g_restartRebuild){
+        BuildSquad(L"Config changed; re-syncing");
+        g_mailbox.Take();   // a last snapshot of the old squad
+        std::wstring hud = g_view ? g_view->hud : std::wstring();
+        g_view = BuildSquadSnapshot(g_squad, (size_t)g_cfg.max_rows, g_cfg.min_deaths_to_list, ConfiguredView());
+        g_view->hud = hud;
+        MarkDirty();
+    }
+    g_restartPending = g_restartRebuild = false;
+    StartIngest();
+}
+
+static void RestartIngest(bool rebuild){
+    g_restartPending = true;
+    g_restartRebuild = g_restartRebuild || rebuild;
+    FinishIngestRestart();   // only signals the old thread; the UI thread never waits on it
+}
+
+static void ShowLatestSnapshot(){
+    std::unique_ptr<DisplaySnapshot> snap = g_mailbox.Take();
+    if (!snap) return;
+    if (g_view) snap->hud = g_view->hud;
+    if (g_view && *snap == *g_view){ ++g_renderStats.skipped; return; }
+    g_view = std::move(snap);
+    MarkDirty();
+}
+
+// One frame for everything marked dirty since the last one, if max_fps allows; otherwise the frame
+// timer comes back for it. The legacy window paints in WM_PAINT, so it is invalidated and painted now.
+static void PresentFrame(){
+    if (g_frameTimerArmed){ KillTimer(g_hwnd, FRAME_TIMER_ID); g_frameTimerArmed = false; }
+    uint64_t waitUs = 0;
+    if (!g_pacer.Due(MonoMicros(), &waitUs)){
+        if (g_pacer.Dirty()) ArmFrameTimer(waitUs);
+        return;
+    }
+    if (g_cfg.transparent_bg) RepaintLayered();
+    else { InvalidateRect(g_hwnd, nullptr, FALSE); UpdateWindow(g_hwnd); }
+}
+
+// ========================== Live config reload ===================
+// An edited config.json takes effect without a restart and without losing the session: looks,
+// window and timers change in place, the ingest thread takes its part at its next wait, and only
+// other characters, another service, lifetime or use_stream restart ingest (see FinishIngestRestart).
+static void ApplyConfig(const AppCfg& next){
+    const AppCfg prev = g_cfg;
+    const UINT prevTimerMs = TIMER_MS;
+    g_cfg = next;
+    DeriveFromConfig();
+
+    // Per-pixel and uniform alpha don't mix on one layered window: ApplyWindowConfig sets
+    // WS_EX_LAYERED again, in the new mode.
+    if (next.transparent_bg != prev.transparent_bg)
+        SetWindowLongW(g_hwnd, GWL_EXSTYLE, GetWindowLongW(g_hwnd, GWL_EXSTYLE) & ~WS_EX_LAYERED);
+    if (next.window_size != prev.window_size){ ReleaseSurface(); ReleaseTextFont(); }
+    ApplyWindowConfig(g_hwnd);
+    if (next.always_on_top != prev.always_on_top) SetTopMost(g_hwnd, next.always_on_top);
+    if (TIMER_MS != prevTimerMs) SetTimer(g_hwnd, TIMER_ID, TIMER_MS, nullptr);
+
+    if (next.metrics_log_seconds > 0 && !g_metricsLog) OpenMetricsLog();
+    if (next.metrics_log_seconds <= 0 && g_metricsLog){ WriteMetricsLog(); g_metricsLog.reset(); }
+    CheckMenuItem(g_ctxMenu, IDM_HUD, MF_BYCOMMAND | (g_cfg.show_hud ? MF_CHECKED : MF_UNCHECKED));
+    if (g_rankMenu) FillRankMenu();
+
+    const bool resync = next.service_id != prev.service_id || next.character_name != prev.character_name ||
+                        next.character_names != prev.character_names || next.lifetime != prev.lifetime;
+    if (resync || next.use_stream != prev.use_stream) RestartIngest(resync);
+    else PostIngestCfg();
+
+    UpdateHud();
+    MarkDirty();
+}
+
+static void ArmConfigTimer(){
+    if (g_configTimerArmed) return;
+    g_configTimerArmed = SetTimer(g_hwnd, CONFIG_TIMER_ID, CONFIG_SETTLE_MS, nullptr) != 0;
+}
+
+// A broken edit (or one caught half-saved) leaves the running config alone and says so on the
+// HUD line until the file parses again.
+static void ReloadConfigIfChanged(){
+    KillTimer(g_hwnd, CONFIG_TIMER_ID);
+    g_configTimerArmed = false;
+    const FileStamp stamp = ConfigStamp();
+    if (stamp == FileStamp{} || stamp == g_configStamp) return;   // gone for now (saved by rename) or not this file
+    std::string j;
+    if (!ReadFileUtf8(ConfigPath(), j)){ ArmConfigTimer(); return; }   // still open in the editor
+    g_configStamp = stamp;
+    AppCfg next;
+    if (!ParseConfig(j, next)){
+        g_configNote = L"config.json has an error; still using the previous settings";
+        UpdateHud();
+        return;
+    }
+    g_configNote.clear();
+    ApplyConfig(next);
+}
+
+// ========================== Window plumbing ===================
+static LRESULT CALLBACK WndProc(HWND hwnd, UINT msg, WPARAM wParam, LPARAM lParam){
+    switch(msg){
+        case WM_CREATE:
+            SetTimer(hwnd, TIMER_ID, TIMER_MS, nullptr);
+            SetTimer(hwnd, METRICS_TIMER_ID, 1000, nullptr);
+            EnsureContextMenu();
+            return 0;
+
+        case WM_WINDOWPOSCHANGING:
+            if (g_cfg.lock_position) {
+                WINDOWPOS* wp = reinterpret_cast<WINDOWPOS*>(lParam);
+                if (wp) {
+                    wp->x  = g_cfg.window.x;
+                    wp->y  = g_cfg.window.y;
+                    wp->cx = g_cfg.window.w;
+                    wp->cy = g_cfg.window.h;
+                    if (g_cfg.always_on_top) wp->hwndInsertAfter = HWND_TOPMOST;
+                }
+            }
+            return 0;
+
+        case WM_ACTIVATE:
+        case WM_ACTIVATEAPP:
+        case WM_NCACTIVATE:
+            ReassertTopMost();
+            return 0;
+
+        case WM_NCHITTEST:
+            return HTCLIENT;
+
+        case WM_CONTEXTMENU: {
+            EnsureContextMenu();
+            POINT pt{ GET_X_LPARAM(lParam), GET_Y_LPARAM(lParam) };
+            if ((SHORT)LOWORD(lParam) == -1 && (SHORT)HIWORD(lParam) == -1) {
+                RECT rc; GetWindowRect(hwnd, &rc);
+                pt.x = rc.left + 10; pt.y = rc.top + 10;
+            }
+            SetForegroundWindow(hwnd);
+            TrackPopupMenu(g_ctxMenu, TPM_RIGHTBUTTON | TPM_LEFTALIGN, pt.x, pt.y, 0, hwnd, nullptr);
+            PostMessageW(hwnd, WM_NULL, 0, 0);
+            return 0;
+        }
+
+        case WM_COMMAND:
+            if (LOWORD(wParam) == IDM_EXIT) { DestroyWindow(hwnd); return 0; }
+            if (LOWORD(wParam) == IDM_RENDER_STATS) { ShowRenderStats(hwnd); return 0; }
+            if (LOWORD(wParam) == IDM_HUD) {
+                g_cfg.show_hud = !g_cfg.show_hud;
+                CheckMenuItem(g_ctxMenu, IDM_HUD, MF_BYCOMMAND | (g_cfg.show_hud ? MF_CHECKED : MF_UNCHECKED));
+                UpdateHud();
+                return 0;
+            }
+            if (LOWORD(wParam) >= IDM_RANK_VIEW && LOWORD(wParam) <= IDM_RANK_VIEW + WindowMinutes().size()) {
+                // Not written back to config.json, like the HUD toggle.
+                const size_t i = LOWORD(wParam) - IDM_RANK_VIEW;
+                g_cfg.rank_by_minutes = i ? WindowMinutes()[i - 1] : 0;
+                FillRankMenu();
+                PostIngestCfg();
+                return 0;
+            }
+            break;
+
+        case WM_KEYDOWN:
+            if (wParam == VK_ESCAPE) { DestroyWindow(hwnd); return 0; }
+            break;
+
+        case WM_SYSCOMMAND:
+            if ((wParam & 0xFFF0) == SC_CLOSE) { DestroyWindow(hwnd); return 0; }
+            break;
+
+        case WM_TIMER:
+            if(wParam==TIMER_ID) ReassertTopMost();
+            else if(wParam==METRICS_TIMER_ID){ OnMetricsTimer(); if(g_restartPending) FinishIngestRestart(); }
+            else if(wParam==CONFIG_TIMER_ID) ReloadConfigIfChanged();
+            else if(wParam==FRAME_TIMER_ID) PresentFrame();
+            return 0;
+
+        case WM_APP_SNAPSHOT:
+            ShowLatestSnapshot();
+            ReassertTopMost();
+            return 0;
+
+        case WM_ERASEBKGND:
+            return 1; // we'll draw everything
+
+        case WM_PAINT:{
+            if (!g_cfg.transparent_bg){
+                PAINTSTRUCT ps; HDC hdc=BeginPaint(hwnd,&ps);
+                RECT rc; GetClientRect(hwnd,&rc);
+                PaintLegacyOpaque(hdc, rc);
+                EndPaint(hwnd,&ps);
+            } else {
+                // The layered window shows the last bitmap it was given; nothing to draw here.
+                PAINTSTRUCT ps; BeginPaint(hwnd,&ps); EndPaint(hwnd,&ps);
+            }
+        } return 0;
+
+        case WM_SIZE:
+            MarkDirty();
+            return 0;
+
+        case WM_DESTROY:
+            KillTimer(hwnd, TIMER_ID);
+            KillTimer(hwnd, METRICS_TIMER_ID);
+            KillTimer(hwnd, CONFIG_TIMER_ID);
+            KillTimer(hwnd, FRAME_TIMER_ID);
+            g_frameTimerArmed = false;
+            StopIngest();
+            WriteMetricsLog();
+            ReleaseSurface();
+            ReleaseTextFont();
+            if (g_ctxMenu) { DestroyMenu(g_ctxMenu); g_ctxMenu = g_rankMenu = nullptr; }
+            PostQuitMessage(0);
+            return 0;
+    }
+    return DefWindowProcW(hwnd, msg, wParam, lParam);
+}
+
+// =============================== Entry =======================================
+int APIENTRY WinMain(HINSTANCE hInst, HINSTANCE, LPSTR, int nCmdShow){
+    BuildSquad(LoadConfigFromFile() ? L"Loaded config.json" : L"config.json missing or broken; using defaults");
+    g_view = BuildSquadSnapshot(g_squad, (size_t)g_cfg.max_rows, g_cfg.min_deaths_to_list, ConfiguredView());
+    if (g_cfg.metrics_log_seconds > 0) OpenMetricsLog();
+
+    DWORD exStyle = WS_EX_LAYERED | WS_EX_TOPMOST | WS_EX_APPWINDOW;
+    DWORD style   = WS_POPUP;
+
+    const wchar_t* cls = L"PS2DeathsOverlay";
+    WNDCLASSW wc{};
+    wc.lpfnWndProc   = WndProc;
+    wc.hInstance     = hInst;
+    wc.hbrBackground = (HBRUSH)GetStockObject(NULL_BRUSH);
+    wc.lpszClassName = cls;
+    wc.hCursor       = LoadCursor(nullptr, IDC_ARROW);
+    if(!RegisterClassW(&wc)){
+        MessageBoxW(nullptr,L"RegisterClassW failed",L"Error",MB_ICONERROR);
+        return 1;
+    }
+
+    g_hwnd = CreateWindowExW(exStyle, cls, L"", style,
+                             g_cfg.window.x, g_cfg.window.y, g_cfg.window.w, g_cfg.window.h,
+                             nullptr, nullptr, hInst, nullptr);
+    if(!g_hwnd){
+        MessageBoxW(nullptr,L"CreateWindowExW failed",L"Error",MB_ICONERROR);
+        return 1;
+    }
+
+    ApplyWindowConfig(g_hwnd);
+    ShowWindow(g_hwnd, nCmdShow);
+    UpdateWindow(g_hwnd);
+
+    ReassertTopMost();
+    SetForegroundWindow(g_hwnd);
+    SetFocus(g_hwnd);
+
+    MarkDirty();
+    StartIngest();
+
+    // Messages, plus the config.json watch: a change in the folder arms CONFIG_TIMER_ID.
+    g_configWatch = FindFirstChangeNotificationW(GetExecutableDir().c_str(), FALSE,
+                        FILE_NOTIFY_CHANGE_FILE_NAME | FILE_NOTIFY_CHANGE_SIZE | FILE_NOTIFY_CHANGE_LAST_WRITE);
+    const DWORD nWatch = g_configWatch != INVALID_HANDLE_VALUE ? 1 : 0;
+    MSG msg{};
+    for (bool quit = false; !quit; ){
+        if (MsgWaitForMultipleObjects(nWatch, &g_configWatch, FALSE, INFINITE, QS_ALLINPUT) == WAIT_OBJECT_0 && nWatch){
+            FindNextChangeNotification(g_configWatch);
+            if (g_hwnd) ArmConfigTimer();
+            continue;
+        }
+        while (PeekMessageW(&msg, nullptr, 0, 0, PM_REMOVE)){
+            if (msg.message == WM_QUIT){ quit = true; break; }
+            TranslateMessage(&msg); DispatchMessageW(&msg);
+        }
+        if (!quit && g_hwnd) PresentFrame();
+    }
+    if (nWatch) FindCloseChangeNotification(g_configWatch);
+    // Worker still stuck in a request: end the process before globals it uses are destroyed.
+    if (g_ingestThread) ExitProcess((UINT)msg.wParam);
+    return (int)msg.wParam;
+}
@@ -0,0 +1,178 @@
+// metrics.cpp — pipeline counters, histograms and their log (see metrics.h).
+
+#include "metrics.h"
+#include "file_util.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cwchar>
+#include <ctime>
+
+
+const char* StageName(Stage s){
+    static const char* names[] = { "connect", "ttfb", "fetch", "parse", "apply", "poll", "repaint" };
+    return names[(int)s];
+}
+
+const char* CounterName(Counter c){
+    static const char* names[] = { "requests", "failures", "bytes", "decoded", "polls", "pages", "events", "frames", "coalesced" };
+    return names[(int)c];
+}
+
+uint64_t MonoMicros(){
+    return (uint64_t)std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// ========================== Histograms ==========================
+int HistogramCounts::Bucket(uint64_t us){
+    if (us < 16) return (int)us;
+    int e = 63;
+    while (!(us >> e)) --e;
+    const int b = 16 + (e - 4) * 8 + (int)((us >> (e - 3)) & 7);
+    return std::min(b, kBuckets - 1);
+}
+
+uint64_t HistogramCounts::BucketMid(int b){
+    if (b < 16) return (uint64_t)b;
+    const int e = 4 + (b - 16) / 8;
+    const uint64_t width = 1ull << (e - 3);
+    return (uint64_t)(8 + (b - 16) % 8) * width + width / 2;
+}
+
+uint64_t HistogramCounts::Quantile(double q) const {
+    if (!count) return 0;
+    const uint64_t rank = std::max<uint64_t>(1, (uint64_t)std::ceil(q * (double)count));
+    uint64_t seen = 0;
+    for (int b = 0; b < kBuckets; ++b){
+        seen += n[b];
+        if (seen >= rank) return maxUs ? std::min(BucketMid(b), maxUs) : BucketMid(b);
+    }
+    return maxUs;
+}
+
+MetricsSnapshot MetricsSnapshot::Since(const MetricsSnapshot& older) const {
+    MetricsSnapshot d = *this;
+    for (int s = 0; s < (int)Stage::Count; ++s){
+        HistogramCounts& h = d.stage[s];
+        const HistogramCounts& o = older.stage[s];
+        for (int b = 0; b < HistogramCounts::kBuckets; ++b) h.n[b] -= o.n[b];
+        h.count -= o.count;
+        h.sumUs -= o.sumUs;
+    }
+    for (int c = 0; c < (int)Counter::Count; ++c) d.counter[c] -= older.counter[c];
+    d.spanUs = takenUs - older.takenUs;
+    return d;
+}
+
+void Metrics::Record(Stage s, uint64_t us){
+    Hist& h = stage_[(int)s];
+    h.n[HistogramCounts::Bucket(us)].fetch_add(1, std::memory_order_relaxed);
+    h.count.fetch_add(1, std::memory_order_relaxed);
+    h.sumUs.fetch_add(us, std::memory_order_relaxed);
+    uint64_t m = h.maxUs.load(std::memory_order_relaxed);
+    while (us > m && !h.maxUs.compare_exchange_weak(m, us, std::memory_order_relaxed)){}
+}
+
+// Not one atomic copy: a sample landing meanwhile may show in a bucket before its count.
+void Metrics::Take(MetricsSnapshot& out) const {
+    for (int s = 0; s < (int)Stage::Count; ++s){
+        const Hist& h = stage_[s];
+        HistogramCounts& o = out.stage[s];
+        o.count = h.count.load(std::memory_order_relaxed);
+        o.sumUs = h.sumUs.load(std::memory_order_relaxed);
+        o.maxUs = h.maxUs.load(std::memory_order_relaxed);
+        for (int b = 0; b < HistogramCounts::kBuckets; ++b) o.n[b] = h.n[b].load(std::memory_order_relaxed);
+    }
+    for (int c = 0; c < (int)Counter::Count; ++c) out.counter[c] = counter_[c].load(std::memory_order_relaxed);
+    out.takenUs = MonoMicros();
+    out.spanUs  = out.takenUs - startUs_;
+}
+
+Metrics& PipelineMetrics(){
+    static Metrics m;
+    return m;
+}
+
+// ========================== Frame pacing ==========================
+void FramePacer::Request(){
+    ++requests_;
+    if (dirty_){ ++coalesced_; PipelineMetrics().Add(Counter::Coalesced); }
+    dirty_ = true;
+}
+
+bool FramePacer::Due(uint64_t now, uint64_t* waitUs){
+    if (!dirty_) return false;
+    if (drawnOnce_ && now - last_ < minGapUs_){
+        ++held_;
+        if (waitUs) *waitUs = minGapUs_ - (now - last_);
+        return false;
+    }
+    return true;
+}
+
+void FramePacer::Drawn(uint64_t now){
+    dirty_ = false;
+    drawnOnce_ = true;
+    last_ = now;
+    ++frames_;
+}
+
+// ========================== Output ==========================
+void PrintMetrics(FILE* out, const MetricsSnapshot& m, const char* indent){
+    for (int s = 0; s < (int)Stage::Count; ++s){
+        const HistogramCounts& h = m.stage[s];
+        if (!h.count) continue;
+        std::fprintf(out, "%s%-8s n %8llu  p50 %9.3f  p99 %9.3f  max %9.3f  mean %9.3f ms\n", indent,
+                     StageName((Stage)s), (unsigned long long)h.count,
+                     h.Quantile(0.50) / 1000.0, h.Quantile(0.99) / 1000.0, h.maxUs / 1000.0,
+                     (double)h.sumUs / (double)h.count / 1000.0);
+    }
+    std::fprintf(out, "%s", indent);
+    for (int c = 0; c < (int)Counter::Count; ++c)
+        std::fprintf(out, "%s%s %llu", c ? "  " : "", CounterName((Counter)c), (unsigned long long)m.counter[c]);
+    std::fprintf(out, "\n");
+}
+
+std::wstring MetricsHudLine(const MetricsSnapshot& m){
+    static const struct { Stage s; const wchar_t* label; } shown[] = {
+        {Stage::Fetch, L"net"}, {Stage::Parse, L"parse"}, {Stage::Apply, L"apply"}, {Stage::Repaint, L"paint"},
+    };
+    std::wstring line;
+    wchar_t buf[64];
+    for (const auto& e : shown){
+        const HistogramCounts& h = m[e.s];
+        if (!h.count) continue;
+        std::swprintf(buf, sizeof(buf) / sizeof(buf[0]), L"%ls%ls %.3g/%.3g", line.empty() ? L"" : L"  ",
+                      e.label, h.Quantile(0.50) / 1000.0, h.Quantile(0.99) / 1000.0);
+        line += buf;
+    }
+    return line.empty() ? line : line + L" ms";
+}
+
+// ========================== Log ==========================
+void MetricsLog::Rotate(){
+    for (int i = keep_ - 1; i >= 1; --i)
+        RenameOver(path_ + "." + std::to_string(i), path_ + "." + std::to_string(i + 1));
+    if (keep_ >= 1) RenameOver(path_, path_ + ".1");
+    else RemoveFileUtf8(path_);
+}
+
+bool MetricsLog::Write(const MetricsSnapshot& interval, const MetricsSnapshot& total, uint64_t unixMs){
+    FILE* f = OpenFileUtf8(path_, "ab");
+    if (!f) return false;
+    std::fseek(f, 0, SEEK_END);
+    if ((size_t)std::ftell(f) >= maxBytes_){
+        std::fclose(f);
+        Rotate();
+        if (!(f = OpenFileUtf8(path_, "ab"))) return false;
+    }
+    const std::time_t t = (std::time_t)(unixMs / 1000);
+    char when[32] = "?";
+    if (const std::tm* tm = std::gmtime(&t)) std::strftime(when, sizeof(when), "%Y-%m-%d %H:%M:%S", tm);
+    std::fprintf(f, "%s UTC  last %.0f s\n", when, interval.spanUs / 1e6);
+    PrintMetrics(f, interval, "  ");
+    std::fprintf(f, "  since start (%.0f s):\n", total.spanUs / 1e6);
+    PrintMetrics(f, total, "    ");
+    return std::fclose(f) == 0;
+}
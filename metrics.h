@@ -0,0 +1,144 @@
+// metrics.h — counters and latency histograms for the poll/render pipeline.
+// One process-wide set (PipelineMetrics()), written from any thread with relaxed atomics: a sample
+// is two clock reads and one increment, so the hooks stay in release builds. Readers take a
+// MetricsSnapshot and subtract an older one for "since the last look".
+// Portable: the overlay, replay and bench all link it (and file_util.cpp for the log file).
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+
+// Timed stages. Apply is one page of events (or one streamed event), not each ApplyDeathEvent:
+// two clock reads per event would cost about as much as applying it.
+enum class Stage : int {
+    Connect,    // TCP/TLS setup (WinINet connects lazily: there it lands in Ttfb instead)
+    Ttfb,       // request sent -> response headers
+    Fetch,      // whole GET, body included
+    Parse,      // ParseDeathBatch / ParseLatestJoinedOne / ParseCharacterNames; a streamed page
+                //   (DeathBatchParser) counts the time spent in its Feed calls
+    Apply,      // one page through ApplyDeathEvent
+    Poll,       // one KillfeedPoll / SquadPoll, every request in it
+    Repaint,    // one frame: compose, tint, push
+    Count
+};
+
+enum class Counter : int {
+    Requests, Failures, Bytes,   // GETs, failed GETs, body bytes received (compressed, as sent)
+    Decoded,                     // body bytes after inflating (= bytes when the server did not compress)
+    Polls, Pages, Events,        // polls, death pages fetched, events applied
+    Frames,                      // frames drawn
+    Coalesced,                   // repaint requests that found a frame already pending (see FramePacer)
+    Count
+};
+
+const char* StageName(Stage s);
+const char* CounterName(Counter c);
+
+// Microseconds since an arbitrary start, steady clock.
+uint64_t MonoMicros();
+
+// Log-linear buckets: exact below 16 us, then 8 per power of two (within 6.25%), up to ~19 h.
+struct HistogramCounts {
+    static constexpr int kBuckets = 16 + 32 * 8;
+    uint64_t n[kBuckets] = {};
+    uint64_t count = 0, sumUs = 0, maxUs = 0;
+
+    static int Bucket(uint64_t us);
+    static uint64_t BucketMid(int b);
+    // Value below which a fraction q of the samples fall (bucket midpoint); 0 when empty.
+    uint64_t Quantile(double q) const;
+};
+
+struct MetricsSnapshot {
+    HistogramCounts stage[(int)Stage::Count];
+    uint64_t counter[(int)Counter::Count] = {};
+    uint64_t takenUs = 0;
+    uint64_t spanUs = 0;    // time covered: since the first use of the metrics, or since older
+
+    const HistogramCounts& operator[](Stage s) const { return stage[(int)s]; }
+    uint64_t operator[](Counter c) const { return counter[(int)c]; }
+    // What happened between older and this one. maxUs is kept from this one (lifetime max).
+    MetricsSnapshot Since(const MetricsSnapshot& older) const;
+};
+
+class Metrics {
+public:
+    void Record(Stage s, uint64_t us);
+    void Add(Counter c, uint64_t n = 1){ counter_[(int)c].fetch_add(n, std::memory_order_relaxed); }
+    void Take(MetricsSnapshot& out) const;
+
+private:
+    uint64_t startUs_ = MonoMicros();
+    struct Hist {
+        std::atomic<uint64_t> n[HistogramCounts::kBuckets] = {};
+        std::atomic<uint64_t> count{0}, sumUs{0}, maxUs{0};
+    };
+    Hist stage_[(int)Stage::Count];
+    std::atomic<uint64_t> counter_[(int)Counter::Count] = {};
+};
+
+Metrics& PipelineMetrics();
+
+// Records the time from construction to destruction (or Stop) into PipelineMetrics().
+class StageTimer {
+public:
+    explicit StageTimer(Stage s) : stage_(s), t0_(MonoMicros()) {}
+    ~StageTimer(){ Stop(); }
+    void Stop(){ if (!done_){ done_ = true; PipelineMetrics().Record(stage_, MonoMicros() - t0_); } }
+    StageTimer(const StageTimer&) = delete;
+    StageTimer& operator=(const StageTimer&) = delete;
+private:
+    Stage    stage_;
+    uint64_t t0_;
+    bool     done_ = false;
+};
+
+// Turns "the view changed" into frames: Request() only marks the view dirty, however often it is
+// called; the message loop asks Due() once per turn and draws at most one frame, no sooner than
+// 1/maxFps after the previous one. UI thread only. Times are MonoMicros().
+class FramePacer {
+public:
+    explicit FramePacer(int maxFps = 30){ SetMaxFps(maxFps); }
+    void SetMaxFps(int fps){ minGapUs_ = fps > 0 ? 1000000 / (uint64_t)fps : 0; }
+
+    void Request();
+    bool Dirty() const { return dirty_; }
+    // True when a frame should be drawn now; the caller draws it and calls Drawn. False while
+    // clean, or while the cap holds a pending frame back: *waitUs then says for how long.
+    bool Due(uint64_t now, uint64_t* waitUs = nullptr);
+    void Drawn(uint64_t now);
+
+    uint64_t Requests() const { return requests_; }
+    uint64_t Frames() const { return frames_; }
+    uint64_t Coalesced() const { return coalesced_; }   // requests folded into a pending frame
+    uint64_t Held() const { return held_; }             // turns a pending frame waited for the cap
+
+private:
+    uint64_t minGapUs_ = 0;
+    uint64_t last_ = 0;
+    bool     dirty_ = false, drawnOnce_ = false;
+    uint64_t requests_ = 0, frames_ = 0, coalesced_ = 0, held_ = 0;
+};
+
+// One line per stage (samples, p50, p99, max in ms) and one with the counters.
+void PrintMetrics(FILE* out, const MetricsSnapshot& m, const char* indent = "");
+
+// Short form for the overlay HUD: "net 41/120 parse 2/6 apply 0.3/1 paint 1/3 ms (p50/p99)".
+std::wstring MetricsHudLine(const MetricsSnapshot& m);
+
+// Appends a timestamped PrintMetrics block per Write; once the file passes maxBytes it becomes
+// <path>.1 (older ones shift up to <path>.<keep>) and a new one is started.
+class MetricsLog {
+public:
+    MetricsLog(std::string path, size_t maxBytes = 1 << 20, int keep = 3)
+        : path_(std::move(path)), maxBytes_(maxBytes), keep_(keep) {}
+    bool Write(const MetricsSnapshot& interval, const MetricsSnapshot& total, uint64_t unixMs);
+private:
+    void Rotate();
+    std::string path_;
+    size_t maxBytes_;
+    int    keep_;
+};
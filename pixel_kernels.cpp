@@ -0,0 +1,133 @@
+// pixel_kernels.cpp — scalar / SSE2 / AVX2 white-to-premultiplied-tint conversion.
+// The SIMD versions are compiled with target attributes, so no global -msse2/-mavx2 is needed
+// and the binary still runs on CPUs without AVX2.
+//
+// Exact (x / 255) for x <= 65535 is (x * 0x8081) >> 23, i.e. mulhi_epu16(x, 0x8081) >> 7; with
+// x = c*A + 127 that reproduces the scalar rounding bit for bit. The alpha slot is computed the
+// same way with c = 255, which gives back A exactly.
+
+#include "pixel_kernels.h"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define KF_PIXEL_X86 1
+#include <immintrin.h>
+#endif
+
+// ========================== Scalar ==========================
+static inline uint32_t TintOne(uint32_t v, unsigned cR, unsigned cG, unsigned cB){
+    unsigned B = v & 0xFF, G = (v >> 8) & 0xFF, R = (v >> 16) & 0xFF;
+    unsigned A = (R>G?R:G); if (B>A) A = B; // A = max(R,G,B)
+    return ((cB * A + 127) / 255)
+         | ((cG * A + 127) / 255) << 8
+         | ((cR * A + 127) / 255) << 16
+         | A << 24;
+}
+
+static void TintScalar(uint32_t* px, size_t n, unsigned r, unsigned g, unsigned b){
+    for (size_t i = 0; i < n; ++i)
+        if (px[i]) px[i] = TintOne(px[i], r, g, b);
+}
+
+#ifdef KF_PIXEL_X86
+// ========================== SSE2 (4 pixels) ==========================
+__attribute__((target("sse2")))
+static inline __m128i TintHalf128(__m128i a32, __m128i col, __m128i bias, __m128i magic){
+    // a32: two pixels' A in the low 16 bits of each 64-bit half -> A in all four 16-bit lanes.
+    __m128i a16 = _mm_or_si128(a32, _mm_slli_epi32(a32, 16));
+    a16 = _mm_unpacklo_epi32(a16, a16);
+    __m128i x = _mm_add_epi16(_mm_mullo_epi16(a16, col), bias);
+    return _mm_srli_epi16(_mm_mulhi_epu16(x, magic), 7);
+}
+
+__attribute__((target("sse2")))
+static void TintSSE2(uint32_t* px, size_t n, unsigned r, unsigned g, unsigned b){
+    const __m128i col   = _mm_setr_epi16((short)b, (short)g, (short)r, 255, (short)b, (short)g, (short)r, 255);
+    const __m128i bias  = _mm_set1_epi16(127);
+    const __m128i magic = _mm_set1_epi16((short)0x8081);
+    const __m128i lowB  = _mm_set1_epi32(0xFF);
+    const __m128i zero  = _mm_setzero_si128();
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4){
+        __m128i v = _mm_loadu_si128((const __m128i*)(px + i));
+        if (_mm_movemask_epi8(_mm_cmpeq_epi8(v, zero)) == 0xFFFF) continue;   // transparent span
+        __m128i m = _mm_max_epu8(v, _mm_srli_epi32(v, 8));
+        m = _mm_max_epu8(m, _mm_srli_epi32(v, 16));
+        __m128i a32 = _mm_and_si128(m, lowB);
+        __m128i lo = TintHalf128(_mm_unpacklo_epi64(a32, zero), col, bias, magic);
+        __m128i hi = TintHalf128(_mm_unpackhi_epi64(a32, zero), col, bias, magic);
+        _mm_storeu_si128((__m128i*)(px + i), _mm_packus_epi16(lo, hi));
+    }
+    TintScalar(px + i, n - i, r, g, b);
+}
+
+// ========================== AVX2 (8 pixels) ==========================
+__attribute__((target("avx2")))
+static inline __m256i TintHalf256(__m256i a32, __m256i col, __m256i bias, __m256i magic){
+    __m256i a16 = _mm256_or_si256(a32, _mm256_slli_epi32(a32, 16));
+    a16 = _mm256_unpacklo_epi32(a16, a16);
+    __m256i x = _mm256_add_epi16(_mm256_mullo_epi16(a16, col), bias);
+    return _mm256_srli_epi16(_mm256_mulhi_epu16(x, magic), 7);
+}
+
+__attribute__((target("avx2")))
+static void TintAVX2(uint32_t* px, size_t n, unsigned r, unsigned g, unsigned b){
+    const __m256i col   = _mm256_setr_epi16((short)b, (short)g, (short)r, 255, (short)b, (short)g, (short)r, 255,
+                                            (short)b, (short)g, (short)r, 255, (short)b, (short)g, (short)r, 255);
+    const __m256i bias  = _mm256_set1_epi16(127);
+    const __m256i magic = _mm256_set1_epi16((short)0x8081);
+    const __m256i lowB  = _mm256_set1_epi32(0xFF);
+    const __m256i zero  = _mm256_setzero_si256();
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8){
+        __m256i v = _mm256_loadu_si256((const __m256i*)(px + i));
+        if (_mm256_testz_si256(v, v)) continue;   // transparent span
+        __m256i m = _mm256_max_epu8(v, _mm256_srli_epi32(v, 8));
+        m = _mm256_max_epu8(m, _mm256_srli_epi32(v, 16));
+        __m256i a32 = _mm256_and_si256(m, lowB);
+        // unpack/pack work per 128-bit lane, so each lane comes out as its own four pixels in order.
+        __m256i lo = TintHalf256(_mm256_unpacklo_epi64(a32, zero), col, bias, magic);
+        __m256i hi = TintHalf256(_mm256_unpackhi_epi64(a32, zero), col, bias, magic);
+        _mm256_storeu_si256((__m256i*)(px + i), _mm256_packus_epi16(lo, hi));
+    }
+    TintSSE2(px + i, n - i, r, g, b);
+}
+#endif
+
+// ========================== Dispatch ==========================
+const char* PixelIsaName(PixelIsa isa){
+    switch (isa){
+        case PixelIsa::SSE2: return "sse2";
+        case PixelIsa::AVX2: return "avx2";
+        default:             return "scalar";
+    }
+}
+
+bool PixelIsaSupported(PixelIsa isa){
+    if (isa == PixelIsa::Scalar) return true;
+#ifdef KF_PIXEL_X86
+    __builtin_cpu_init();
+    if (isa == PixelIsa::SSE2) return __builtin_cpu_supports("sse2");
+    if (isa == PixelIsa::AVX2) return __builtin_cpu_supports("avx2");
+#endif
+    return false;
+}
+
+PixelIsa BestPixelIsa(){
+    static const PixelIsa best = PixelIsaSupported(PixelIsa::AVX2) ? PixelIsa::AVX2
+                               : PixelIsaSupported(PixelIsa::SSE2) ? PixelIsa::SSE2
+                               : PixelIsa::Scalar;
+    return best;
+}
+
+void TintWhiteToPremultipliedWith(PixelIsa isa, uint32_t* px, size_t n, uint8_t r, uint8_t g, uint8_t b){
+#ifdef KF_PIXEL_X86
+    if (isa == PixelIsa::AVX2){ TintAVX2(px, n, r, g, b); return; }
+    if (isa == PixelIsa::SSE2){ TintSSE2(px, n, r, g, b); return; }
+#endif
+    (void)isa;
+    TintScalar(px, n, r, g, b);
+}
+
+void TintWhiteToPremultiplied(uint32_t* px, size_t n, uint8_t r, uint8_t g, uint8_t b){
+    TintWhiteToPremultipliedWith(BestPixelIsa(), px, n, r, g, b);
+}
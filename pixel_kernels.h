@@ -0,0 +1,19 @@
+// pixel_kernels.h — the per-pixel pass of the layered overlay, as a standalone kernel.
+// Text is rasterized white on black into a BGRA buffer; this turns every pixel into the configured
+// text color, premultiplied by coverage A = max(R,G,B):  out = ((c*A + 127) / 255, ..., A).
+// Scalar, SSE2 and AVX2 versions produce identical bytes; the widest one the CPU has is picked
+// at runtime. Pixels that are entirely zero (the cleared background) are left untouched.
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+enum class PixelIsa { Scalar, SSE2, AVX2 };
+
+const char* PixelIsaName(PixelIsa isa);
+bool        PixelIsaSupported(PixelIsa isa);
+PixelIsa    BestPixelIsa();
+
+// px: n pixels, little-endian BGRA (B in the low byte), converted in place.
+void TintWhiteToPremultiplied(uint32_t* px, size_t n, uint8_t r, uint8_t g, uint8_t b);
+void TintWhiteToPremultipliedWith(PixelIsa isa, uint32_t* px, size_t n, uint8_t r, uint8_t g, uint8_t b);
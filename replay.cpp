@@ -0,0 +1,1015 @@
+// replay.cpp — headless replay of recorded Census characters_event responses through the core.
+// Feeds every file of a directory (in filename order) through ParseDeathBatch + ApplyDeathEvent,
+// exactly like the pagination loop in KillfeedPoll, then prints the counters and timings.
+// With --server it instead runs SquadPoll ticks (one character or several, --character a,b,c)
+// against a live host (normally killfeed_standin) through the socket HttpTransport and reports
+// per-request latency, bytes, name lookups and requests per tick.
+// With --overlap-check it also feeds the pages as overlapping windows (every event two or three
+// times, some after newer ones) and checks the counters against an exact, unbounded dedupe.
+// With --chunk-check it streams every page through DeathBatchParser split at every byte offset (and
+// trimmed copies at every pair of offsets) and checks the events match ParseDeathBatch.
+// With --session BASE it also journals the run into BASE.kfs/BASE.kfj (compacting part way),
+// restores a fresh state from the files and checks it matches, including after a torn journal
+// tail and with a corrupted snapshot.
+// With --schedule-sim it simulates a day of deaths and compares the fixed poll tick (peek + page
+// every poll_ms) with PollScheduler's single-request ticks: requests per hour, detection latency.
+// With --catchup it catches up on the stand-in's whole history from an old watermark, once one
+// page at a time and once through PageFetcher with --workers connections, and compares wall time
+// and counters.
+// With --stream it runs KillfeedStream against the stand-in's scripted /streaming endpoint until
+// the script is done, then rebuilds the same window from REST and checks the counters match. With
+// --session BASE the stream starts from a session that was polled (event_id keys) and saved first.
+// With --windows 10,30 it keeps those rolling windows (minutes) while replaying, prints their top
+// rows as of the last death and checks them against a recount after every page.
+// With --backfill it fills the history store (--store BASE) with the character's whole history, or
+// what is new since the last run, checks it against a plain catch-up and times a cold open from disk.
+// --server and --catchup parse death pages as they arrive; --whole-body downloads each one first.
+// They ask for gzip bodies and print the bytes on the wire next to the decoded ones; --identity doesn't ask.
+// --metrics (any mode) ends with the pipeline metrics the overlay logs: p50/p99 per stage, counters.
+//
+// Build (Linux):
+//   g++ -std=gnu++17 -O2 -Wall -Wextra -pthread killfeed_core.cpp http_socket.cpp event_stream.cpp ws_socket.cpp session_store.cpp history_store.cpp file_util.cpp metrics.cpp inflate.cpp replay.cpp -o killfeed_replay
+// Usage:
+//   killfeed_replay <dir> [--repeat N] [--rows N] [--min-deaths N] [--keep-environment] [--overlap-check] [--chunk-check] [--session BASE] [--windows M,M]
+//   killfeed_replay --server host:port [--character NAME[,NAME...]] [--ticks N] [--no-keepalive] [--names FILE] [--rows N] [--whole-body]
+//   killfeed_replay --catchup host:port [--character NAME[,NAME...]] [--workers N] [--repeat N] [--rows N] [--whole-body]
+//   killfeed_replay --stream host:port [--character NAME] [--seconds N] [--rows N] [--session BASE]
+//   killfeed_replay --backfill host:port [--character NAME] [--store BASE] [--workers N] [--rows N]
+//   killfeed_replay --schedule-sim [--hours N] [--poll-ms N] [--poll-max-ms N]
+//   any of the network modes [--identity]
+//   any of the above [--metrics]
+
+#include "killfeed_core.h"
+#include "event_stream.h"
+#include "http_transport.h"
+#include "session_store.h"
+#include "history_store.h"
+#include "metrics.h"
+#include "inflate.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <map>
+#include <mutex>
+#include <random>
+#include <set>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <tuple>
+#include <vector>
+
+namespace fs = std::filesystem;
+using Clock = std::chrono::steady_clock;
+
+static double MsSince(Clock::time_point t0, Clock::time_point t1){
+    return std::chrono::duration<double, std::milli>(t1 - t0).count();
+}
+
+static bool ReadWholeFile(const fs::path& p, std::string& out){
+    std::ifstream f(p, std::ios::binary);
+    if(!f) return false;
+    std::ostringstream ss; ss << f.rdbuf();
+    out = ss.str();
+    if(out.size()>=3 && (unsigned char)out[0]==0xEF &&
+       (unsigned char)out[1]==0xBB && (unsigned char)out[2]==0xBF)
+        out.erase(0,3);
+    return true;
+}
+
+static void Usage(){
+    std::fprintf(stderr, "usage: killfeed_replay <dir> [--repeat N] [--rows N] [--min-deaths N] [--keep-environment] [--overlap-check] [--chunk-check] [--session BASE] [--windows M,M]\n"
+                         "       killfeed_replay --server host:port [--character NAME[,NAME...]] [--ticks N] [--no-keepalive] [--names FILE] [--rows N] [--whole-body]\n"
+                         "       killfeed_replay --catchup host:port [--character NAME[,NAME...]] [--workers N] [--repeat N] [--rows N] [--whole-body]\n"
+                         "       killfeed_replay --stream host:port [--character NAME] [--seconds N] [--rows N] [--session BASE]\n"
+                         "       killfeed_replay --backfill host:port [--character NAME] [--store BASE] [--workers N] [--rows N]\n"
+                         "       killfeed_replay --schedule-sim [--hours N] [--poll-ms N] [--poll-max-ms N]\n"
+                         "       any of the network modes [--identity]\n"
+                         "       any of the above [--metrics]\n");
+}
+
+static double Percentile(std::vector<double> v, double p){
+    if(v.empty()) return 0;
+    std::sort(v.begin(), v.end());
+    size_t i = (size_t)(p * (v.size() - 1) + 0.5);
+    return v[std::min(i, v.size() - 1)];
+}
+
+static int g_minDeaths = 1;
+static bool g_wholeBody = false;   // --whole-body: death pages downloaded first, parsed after (the old way)
+static bool g_identity = false;    // --identity: no Accept-Encoding, bodies come uncompressed
+
+static std::unique_ptr<HttpTransport> Transport(const std::string& host, unsigned short port, bool keepAlive = true){
+    return MakeSocketTransport(host, port, keepAlive, !g_identity);
+}
+
+static uint64_t CounterNow(Counter c){
+    MetricsSnapshot m; PipelineMetrics().Take(m);
+    return m[c];
+}
+
+static void PrintTop(const KillfeedState& st, size_t rows){
+    std::vector<RankedRow> top = RankNemeses(st, rows, g_minDeaths);
+    for(size_t i=0; i<top.size(); ++i){
+        std::printf("%zu) %llu  %s  %d/%d\n", i+1,
+                    (unsigned long long)top[i].id,
+                    GetNameFor(st, top[i].id).c_str(),
+                    top[i].cnt.hs, top[i].cnt.tot);
+    }
+}
+
+static void SplitHostPort(const std::string& hostPort, std::string& host, unsigned short& port){
+    size_t colon = hostPort.rfind(':');
+    host = hostPort.substr(0, colon);
+    port = (unsigned short)(colon == std::string::npos ? 80 : std::atoi(hostPort.c_str() + colon + 1));
+}
+
+// Feeds page i as [second half of page i-1][page i][first quarter of page i+1], settling after each
+// window like a poll does, and compares with counters built from an exact set of every key.
+static bool OverlapCheck(const std::vector<std::string>& bodies, bool skipEnv, bool bySynth){
+    std::vector<std::vector<DeathEvent>> pages;
+    for(const std::string& b : bodies) pages.push_back(ParseDeathBatch(b));
+
+    std::set<std::tuple<uint64_t, uint64_t, uint64_t>> keys;
+    std::map<uint64_t, Counters> want;
+    for(const auto& page : pages) for(const DeathEvent& e : page){
+        auto k = (e.eventId && !bySynth) ? std::make_tuple(e.eventId, (uint64_t)0, (uint64_t)0)
+                                         : std::make_tuple((uint64_t)0, (uint64_t)e.ts, e.attackerId * 2 + e.isHS);
+        if(!keys.insert(k).second || (skipEnv && e.attackerId == 0)) continue;
+        Counters& c = want[e.attackerId];
+        c.tot++; if(e.isHS) c.hs++;
+    }
+
+    KillfeedState st;
+    st.skipEnvironment = skipEnv;
+    st.keyBySynth = bySynth;
+    size_t fed = 0, maxKept = 0;
+    for(size_t i=0; i<pages.size(); ++i){
+        std::vector<DeathEvent> win;
+        if(i > 0) win.insert(win.end(), pages[i-1].begin() + pages[i-1].size() / 2, pages[i-1].end());
+        win.insert(win.end(), pages[i].begin(), pages[i].end());
+        if(i + 1 < pages.size()) win.insert(win.end(), pages[i+1].begin(), pages[i+1].begin() + pages[i+1].size() / 4);
+        for(const DeathEvent& e : win) ApplyDeathEvent(st, e);
+        SettleDedupe(st);
+        fed += win.size();
+        maxKept = std::max(maxKept, st.seenEventIds.size() + st.seenSynth.size());
+    }
+
+    bool ok = (st.counts.size() == want.size());
+    for(const auto& kv : want){
+        const AttackerSlot* a = st.counts.Find(kv.first);
+        if(!a || a->cnt.tot != kv.second.tot || a->cnt.hs != kv.second.hs) ok = false;
+    }
+    std::printf("overlap      %s keys: fed %zu, unique %zu, max kept %zu -> %s\n",
+                bySynth ? "synthetic" : "event_id ", fed, keys.size(), maxKept, ok ? "OK" : "MISMATCH");
+    return ok;
+}
+
+static bool SameEvents(const std::vector<DeathEvent>& a, const std::vector<DeathEvent>& b, size_t n){
+    if(a.size() < n || b.size() < n) return false;
+    for(size_t i=0; i<n; ++i)
+        if(a[i].attackerId != b[i].attackerId || a[i].attackerName != b[i].attackerName || a[i].nameEscaped != b[i].nameEscaped || a[i].isHS != b[i].isHS ||
+           a[i].eventId != b[i].eventId || a[i].victimId != b[i].victimId || a[i].ts != b[i].ts) return false;
+    return true;
+}
+
+// Streams body through DeathBatchParser in pieces ending at each of cuts (then the rest).
+static DeathBatchParser FeedPieces(const std::string& body, std::initializer_list<size_t> cuts){
+    DeathBatchParser p;
+    size_t at = 0;
+    for(size_t c : cuts){ p.Feed(body.data() + at, c - at); at = c; }
+    p.Feed(body.data() + at, body.size() - at);
+    return p;
+}
+
+// The streamed parse must give ParseDeathBatch's events wherever the pieces break: every body is
+// fed one byte at a time (every offset a boundary) and in random piece sizes, and a trimmed copy
+// (first three events, same head and tail) is cut in two at every offset and in three at every pair.
+// A piece ending before the array closes must leave the parser unfinished with a prefix of the events.
+static bool ChunkCheck(const std::vector<std::string>& bodies){
+    std::mt19937 rng(18);
+    size_t splits = 0, bad = 0, carryPeak = 0, bodyPeak = 0;
+    for(const std::string& body : bodies){
+        const std::vector<DeathEvent> want = ParseDeathBatch(body);
+        bodyPeak = std::max(bodyPeak, body.size());
+
+        DeathBatchParser bytes;
+        size_t thirdEnd = 0, closeAt = 0;
+        for(size_t i=0; i<body.size(); ++i){
+            bytes.Feed(&body[i], 1);
+            if(!thirdEnd && bytes.events.size() == std::min<size_t>(3, want.size()) && want.size()) thirdEnd = i + 1;
+            if(!closeAt && bytes.Complete()) closeAt = i + 1;
+        }
+        ++splits;
+        if(!bytes.Complete() || bytes.events.size() != want.size() || !SameEvents(bytes.events, want, want.size())) ++bad;
+        carryPeak = std::max(carryPeak, bytes.CarryPeak());
+
+        for(int r=0; r<8; ++r){
+            DeathBatchParser p;
+            for(size_t at=0; at<body.size(); ){
+                const size_t n = std::min(body.size() - at, (size_t)(rng() % 16384) + 1);
+                p.Feed(body.data() + at, n);
+                at += n;
+            }
+            ++splits;
+            if(p.events.size() != want.size() || !SameEvents(p.events, want, want.size())) ++bad;
+        }
+
+        if(!closeAt) continue;
+        const std::string trimmed = body.substr(0, thirdEnd ? thirdEnd : body.find('[') + 1) + body.substr(closeAt - 1);
+        const std::vector<DeathEvent> wantT = ParseDeathBatch(trimmed);
+        const size_t closeT = trimmed.size() - (body.size() - closeAt);
+        for(size_t k=0; k<=trimmed.size(); ++k){
+            DeathBatchParser p;
+            p.Feed(trimmed.data(), k);
+            if(p.Complete() != (k >= closeT) || !SameEvents(p.events, wantT, p.events.size())) ++bad;
+            p.Feed(trimmed.data() + k, trimmed.size() - k);
+            ++splits;
+            if(!p.Complete() || p.events.size() != wantT.size() || !SameEvents(p.events, wantT, wantT.size())) ++bad;
+        }
+        if(&body != &bodies.front()) continue;
+        for(size_t a=0; a<=trimmed.size(); ++a)
+            for(size_t b=a; b<=trimmed.size(); ++b){
+                DeathBatchParser p = FeedPieces(trimmed, {a, b});
+                ++splits;
+                if(p.events.size() != wantT.size() || !SameEvents(p.events, wantT, wantT.size())) ++bad;
+            }
+    }
+    std::printf("chunks       %zu splits, %zu wrong; held across pieces %zu B (largest body %zu B) -> %s\n",
+                splits, bad, carryPeak, bodyPeak, bad ? "MISMATCH" : "OK");
+    return !bad;
+}
+
+static bool SameSession(const KillfeedState& a, const KillfeedState& b){
+    if(a.characterId != b.characterId || a.lastDeathTs != b.lastDeathTs || a.dedupeFloor != b.dedupeFloor ||
+       a.seenEventIds.size() != b.seenEventIds.size() || a.seenSynth.size() != b.seenSynth.size() ||
+       a.lastAttackerId != b.lastAttackerId || a.lastAttackerName != b.lastAttackerName) return false;
+    bool same = a.counts.size() == b.counts.size();
+    a.counts.ForEach([&](uint64_t id, const AttackerSlot& s){
+        const AttackerSlot* o = b.counts.Find(id);
+        if(!o || o->cnt.tot != s.cnt.tot || o->cnt.hs != s.cnt.hs || o->lastTs != s.lastTs ||
+           GetNameFor(a, id) != GetNameFor(b, id)) same = false;
+    });
+    a.seenEventIds.ForEach([&](uint64_t id, unsigned long long){ if(!b.seenEventIds.Contains(id)) same = false; });
+    a.seenSynth.ForEach([&](const SynthKey& k, FlatEmpty){ if(!b.seenSynth.Contains(k)) same = false; });
+    std::vector<RankedRow> ra = RankNemeses(a, 100), rb = RankNemeses(b, 100);
+    for(size_t i=0; same && i<ra.size(); ++i) same = i < rb.size() && ra[i].id == rb[i].id;
+    return same && ra.size() == rb.size();
+}
+
+static size_t FileBytes(const std::string& p){ std::error_code ec; auto n = fs::file_size(p, ec); return ec ? 0 : (size_t)n; }
+
+// Journals the pages like the overlay does (sync after each, compaction about a third of the way
+// in), then restores from disk as a fresh start would and compares.
+static bool SessionCheck(const std::vector<std::string>& bodies, bool skipEnv, const std::string& base){
+    std::remove((base + ".kfs").c_str());
+    std::remove((base + ".kfj").c_str());
+    std::vector<std::vector<DeathEvent>> pages;
+    size_t total = 0;
+    for(const std::string& b : bodies){ pages.push_back(ParseDeathBatch(b)); total += pages.back().size(); }
+
+    KillfeedState st;
+    st.characterName = L"sealobster";
+    st.characterId = L"5428713425545165425";
+    st.skipEnvironment = skipEnv;
+    double journalMs = 0;
+    {
+        SessionStore store(base);
+        store.compactEvery = std::max<size_t>(1, total / 3);
+        for(const auto& page : pages){
+            for(const DeathEvent& e : page) ApplyDeathEvent(st, e);
+            SettleDedupe(st);
+            auto t0 = Clock::now();
+            store.Sync(st);
+            journalMs += MsSince(t0, Clock::now());
+        }
+        // No Detach: the files are left the way a crash would leave them.
+    }
+    st.journal = nullptr;
+
+    auto restore = [&](SessionLoadInfo& info, double& ms){
+        KillfeedState r;
+        r.characterName = L"Sealobster";
+        r.skipEnvironment = skipEnv;
+        SessionStore store(base);
+        auto t0 = Clock::now();
+        store.Load(r, &info);
+        ms = MsSince(t0, Clock::now());
+        return r;
+    };
+    SessionLoadInfo info; double loadMs = 0;
+    KillfeedState r = restore(info, loadMs);
+    bool ok = info.restored && !info.journalTorn && SameSession(st, r);
+    std::printf("session      snapshot %zu B, journal %zu B (%zu records), sync total %.3f ms\n",
+                FileBytes(base + ".kfs"), FileBytes(base + ".kfj"), info.journalRecords, journalMs);
+    std::printf("restore_ms   %.3f  (%zu attackers) -> %s\n", loadMs, info.attackers, ok ? "OK" : "MISMATCH");
+
+    // Crash mid-append: a partial record at the end must be dropped, the rest kept.
+    {
+        FILE* f = std::fopen((base + ".kfj").c_str(), "ab");
+        const char junk[13] = {0x40, 0, 1, 0, 0x30, 0, 'x'};
+        if(f){ std::fwrite(junk, sizeof(junk), 1, f); std::fclose(f); }
+    }
+    KillfeedState torn = restore(info, loadMs);
+    bool tornOk = info.restored && info.journalTorn && SameSession(st, torn);
+    std::printf("torn tail    %s\n", tornOk ? "dropped -> OK" : "MISMATCH");
+
+    // A damaged snapshot is refused rather than half-loaded.
+    {
+        FILE* f = std::fopen((base + ".kfs").c_str(), "r+b");
+        if(f){ std::fseek(f, 200, SEEK_SET); int c = std::fgetc(f); std::fseek(f, 200, SEEK_SET); std::fputc(c ^ 0x5A, f); std::fclose(f); }
+    }
+    restore(info, loadMs);
+    bool corruptOk = !info.restored;
+    std::printf("corrupt kfs  %s (%s)\n", corruptOk ? "refused -> OK" : "LOADED", info.why.c_str());
+    return ok && tornOk && corruptOk;
+}
+
+// Replays the pages with rolling windows, the newest death being the clock, and after every page
+// compares each window with a recount of the applied deaths it covers. Then runs the clock on past
+// the end in uneven steps, as the overlay's ticks would, until every window has drained.
+static bool WindowCheck(const std::vector<std::string>& bodies, bool skipEnv, const std::vector<int>& minutes){
+    KillfeedState st;
+    st.skipEnvironment = skipEnv;
+    for(int m : minutes) st.windows.emplace_back((unsigned)m * 60);
+    std::vector<DeathEvent> applied;
+    st.journal = [&](const DeathEvent& e){ if(!(skipEnv && e.attackerId == 0)) applied.push_back(e); };
+
+    bool ok = true;
+    size_t checks = 0;
+    auto compare = [&](){
+        for(const WindowCounts& w : st.windows){
+            std::map<uint64_t, Counters> want;
+            for(const DeathEvent& e : applied)
+                if(w.Covers(e.ts)){ Counters& c = want[e.attackerId]; ++c.tot; if(e.isHS) ++c.hs; }
+            std::vector<std::tuple<int, int, uint64_t>> keys;
+            for(const auto& kv : want) keys.emplace_back(-kv.second.tot, -kv.second.hs, kv.first);
+            std::sort(keys.begin(), keys.end());
+            const std::vector<RankedRow> got = w.Top(keys.size() + 1);
+            bool same = got.size() == keys.size() && w.Attackers() == keys.size();
+            for(size_t i=0; same && i<keys.size(); ++i)
+                same = keys[i] == std::make_tuple(-got[i].cnt.tot, -got[i].cnt.hs, got[i].id);
+            if(!same){
+                std::printf("window       MISMATCH: %u min, %zu attackers, expected %zu\n", w.Seconds() / 60, got.size(), keys.size());
+                ok = false;
+            }
+            ++checks;
+        }
+    };
+    for(const std::string& body : bodies){
+        for(const DeathEvent& e : ParseDeathBatch(body)) ApplyDeathEvent(st, e);
+        SettleDedupe(st);
+        compare();
+    }
+    unsigned maxSeconds = 0;
+    for(const WindowCounts& w : st.windows) maxSeconds = std::max(maxSeconds, w.Seconds());
+    for(unsigned long long t = st.lastDeathTs, step = 1; t <= st.lastDeathTs + maxSeconds + maxSeconds / WindowCounts::kBuckets; t += step, step = step % 23 + 7){
+        if(AdvanceWindows(st, t)) compare();
+    }
+    size_t left = 0;
+    for(const WindowCounts& w : st.windows) left += w.Deaths() + w.Attackers();
+    ok = ok && left == 0;
+    std::printf("windows      %zu comparisons against a recount, drained after the last death -> %s\n", checks, ok ? "OK" : "MISMATCH");
+    return ok;
+}
+
+// Online sessions (mean 2 h) between offline gaps (mean 4 h). While online, the time to the next
+// death is a quick redeploy death (mean 40 s) 60% of the time and a longer life (mean 4 min)
+// otherwise. A death shows up in the API 1.5 s after it happens.
+static std::vector<uint64_t> SimulatedDeaths(double hours, uint64_t seed){
+    std::mt19937_64 rng(seed);
+    auto expMs = [&](double meanMs){ return (uint64_t)std::exponential_distribution<double>(1.0 / meanMs)(rng); };
+    std::vector<uint64_t> out;
+    const uint64_t end = (uint64_t)(hours * 3600e3);
+    uint64_t t = expMs(4 * 3600e3 / 2);
+    while(t < end){
+        const uint64_t sessionEnd = t + expMs(2 * 3600e3);
+        while(t < sessionEnd && t < end){
+            t += std::uniform_real_distribution<double>()(rng) < 0.6 ? expMs(40e3) : expMs(240e3);
+            if(t < sessionEnd && t < end) out.push_back(t);
+        }
+        t = sessionEnd + expMs(4 * 3600e3);
+    }
+    return out;
+}
+
+struct SimOutcome { uint64_t requests = 0; std::vector<double> latency; };
+
+// next(result, now) gives the delay to the next tick; each tick costs requestsPerTick.
+template<typename Next>
+static SimOutcome SimulatePolling(const std::vector<uint64_t>& deaths, uint64_t endMs, int requestsPerTick, Next next){
+    const uint64_t visibleAfter = 1500;
+    SimOutcome o;
+    size_t seen = 0;
+    PollResult r;
+    for(uint64_t t = (uint64_t)next(r, 0); t < endMs; t += (uint64_t)next(r, t)){
+        r = PollResult{};
+        r.requests = requestsPerTick;
+        o.requests += (uint64_t)requestsPerTick;
+        while(seen < deaths.size() && deaths[seen] + visibleAfter <= t){
+            o.latency.push_back((double)(t - deaths[seen]));
+            ++seen; ++r.applied;
+        }
+    }
+    return o;
+}
+
+static int RunScheduleSim(double hours, int pollMs, int maxMs){
+    const std::vector<uint64_t> deaths = SimulatedDeaths(hours, 2024);
+    const uint64_t endMs = (uint64_t)(hours * 3600e3);
+    SimOutcome fixed = SimulatePolling(deaths, endMs, 2, [&](const PollResult&, uint64_t){ return pollMs; });
+    PollScheduler sched(pollMs, maxMs, 99);
+    SimOutcome adaptive = SimulatePolling(deaths, endMs, 1, [&](const PollResult& r, uint64_t now){ return sched.Next(r, now); });
+
+    std::printf("simulated    %.0f h, %zu deaths, poll_ms %d, poll_max_ms %d\n", hours, deaths.size(), pollMs, maxMs);
+    auto row = [&](const char* name, const SimOutcome& o){
+        std::printf("%-12s requests/h %7.0f  detect_ms p50 %6.0f  p90 %6.0f  max %6.0f\n", name, o.requests / hours,
+                    Percentile(o.latency, 0.50), Percentile(o.latency, 0.90), Percentile(o.latency, 1.0));
+    };
+    row("fixed", fixed);
+    row("adaptive", adaptive);
+    return 0;
+}
+
+// "a,b,c" -> one squad member per name.
+static Squad MakeSquad(const std::string& characters, NameCache* names){
+    Squad sq;
+    std::stringstream ss(characters);
+    std::string name;
+    while(std::getline(ss, name, ',')){
+        if(name.empty()) continue;
+        auto st = std::make_unique<KillfeedState>();
+        st->serviceId = L"s:example";
+        st->characterName = Utf8ToWide(name);
+        st->nameCache = names;
+        sq.members.push_back(std::move(st));
+    }
+    return sq;
+}
+
+static size_t Unnamed(const KillfeedState& st){
+    size_t n = 0;
+    st.counts.ForEach([&](uint64_t id, const AttackerSlot& a){ if(id && !a.name) ++n; });
+    return n;
+}
+
+// Live mode: SquadPoll against a server (--character a,b,c for a squad), timing every request.
+// --names PATH loads the name cache before and saves it after, like an overlay restart.
+static int RunServer(const std::string& hostPort, const std::string& character, int ticks, bool keepAlive, size_t rows,
+                     const std::string& namesPath){
+    std::string host; unsigned short port;
+    SplitHostPort(hostPort, host, port);
+    std::unique_ptr<HttpTransport> http = Transport(host, port, keepAlive);
+
+    NameCache names;
+    if(!namesPath.empty()) LoadNameCache(names, namesPath);
+    const size_t cachedAtStart = names.size();
+    Squad sq = MakeSquad(character, &names);
+    if(sq.members.empty()){ Usage(); return 2; }
+    std::vector<double> lat;
+    size_t bytes = 0, pageBytes = 0, pages = 0, lookups = 0;
+    FetchFn fetch = [&](const std::wstring& path){
+        std::string body; std::wstring err;
+        auto t0 = Clock::now();
+        if(!http->Get(path, body, err)) for(auto& m : sq.members) m->status = err;
+        lat.push_back(MsSince(t0, Clock::now()));
+        bytes += body.size();
+        if(path.find(L"c:start=") != std::wstring::npos){ pageBytes += body.size(); ++pages; }
+        if(path.find(L"character?character_id=") != std::wstring::npos) ++lookups;
+        return body;
+    };
+    ChunkFetchFn streamPages = [&](const std::wstring& path, const ChunkSink& sink){
+        std::wstring err; size_t n = 0;
+        auto t0 = Clock::now();
+        bool ok = http->GetChunks(path, [&](const char* p, size_t k){ n += k; sink(p, k); }, err);
+        if(!ok) for(auto& m : sq.members) m->status = err;
+        lat.push_back(MsSince(t0, Clock::now()));
+        bytes += n; pageBytes += n; ++pages;
+        return ok;
+    };
+    const uint64_t wire0 = CounterNow(Counter::Bytes);
+    auto t0 = Clock::now();
+    std::vector<int> perTick;
+    for(int t=0; t<ticks; ++t) perTick.push_back(SquadPoll(sq, fetch, nullptr, nullptr, g_wholeBody ? nullptr : streamPages).requests);
+    double wall = MsSince(t0, Clock::now());
+
+    double sum = 0; for(double v : lat) sum += v;
+    const HttpStats& hs = http->Stats();
+    std::printf("mode         %s\n", keepAlive ? "keep-alive" : "connection per request");
+    std::printf("ticks        %d\n", ticks);
+    std::printf("requests     %llu  (connects %llu, failures %llu)\n",
+                (unsigned long long)hs.requests, (unsigned long long)hs.connects, (unsigned long long)hs.failures);
+    std::printf("per tick     first %d, then max %d  (%zu character%s)\n", perTick[0],
+                perTick.size() > 1 ? *std::max_element(perTick.begin() + 1, perTick.end()) : 0,
+                sq.members.size(), sq.members.size() == 1 ? "" : "s");
+    std::printf("latency_ms   mean %.3f  p50 %.3f  p95 %.3f  max %.3f\n",
+                lat.empty() ? 0.0 : sum / lat.size(), Percentile(lat, 0.50), Percentile(lat, 0.95), Percentile(lat, 1.0));
+    std::printf("bytes        %zu  (%zu pages, %.0f per page)\n", bytes, pages, pages ? (double)pageBytes / pages : 0.0);
+    const uint64_t wire = CounterNow(Counter::Bytes) - wire0;
+    std::printf("on the wire  %llu  (%.1fx smaller)\n", (unsigned long long)wire, wire ? (double)bytes / wire : 0.0);
+    std::printf("wall_ms      %.1f\n", wall);
+    size_t unnamed = 0;
+    for(const auto& m : sq.members){
+        const KillfeedState& st = *m;
+        if(sq.members.size() > 1) std::printf("character    %s (%s)\n", WideToUtf8(st.characterName).c_str(), WideToUtf8(st.characterId).c_str());
+        std::printf("status       %s\n", WideToUtf8(st.status).c_str());
+        std::printf("applied      %zu attackers, last_ts %llu\n", st.counts.size(), st.lastDeathTs);
+        PrintTop(st, rows);
+        unnamed += Unnamed(st);
+    }
+    std::printf("names        %zu cached at start, %zu lookups, %zu without a name\n", cachedAtStart, lookups, unnamed);
+    if(!namesPath.empty() && !SaveNameCache(names, namesPath)) std::fprintf(stderr, "cannot write %s\n", namesPath.c_str());
+    return unnamed ? 1 : 0;
+}
+
+// Watches the stand-in's messages for the end-of-script marker; everything else passes through.
+class ScriptWatch : public StreamTransport {
+public:
+    explicit ScriptWatch(std::unique_ptr<StreamTransport> inner) : inner_(std::move(inner)) {}
+    bool Connect(const std::wstring& path, std::wstring& err) override { ++connects; return inner_->Connect(path, err); }
+    bool Send(const std::string& text) override { return inner_->Send(text); }
+    int  Receive(std::string& msg, int timeoutMs) override {
+        int r = inner_->Receive(msg, timeoutMs);
+        if(r > 0){
+            ++messages;
+            if(msg.find("\"standinScriptDone\"") != std::string::npos) done = true;
+        }
+        return r;
+    }
+    void Abort() override { inner_->Abort(); }
+    void Close() override { inner_->Close(); }
+
+    bool done = false;
+    int  connects = 0;
+    unsigned long long messages = 0;
+private:
+    std::unique_ptr<StreamTransport> inner_;
+};
+
+static bool SameCounts(const KillfeedState& a, const KillfeedState& b){
+    if(a.counts.size() != b.counts.size()) return false;
+    bool same = true;
+    a.counts.ForEach([&](uint64_t id, const AttackerSlot& s){
+        const AttackerSlot* o = b.counts.Find(id);
+        if(!o || o->cnt.tot != s.cnt.tot || o->cnt.hs != s.cnt.hs) same = false;
+    });
+    return same;
+}
+
+// Catch-up mode: a squad whose watermark is older than everything on the server (sessions restored
+// after a long break) polls once; workers 1 is the sequential page loop. For a squad the same
+// catch-up is also done one character at a time, which must give every member the same counters.
+struct CatchUpRun {
+    double wallMs = 0; PollResult poll; unsigned long long connects = 0, wire = 0, decoded = 0;
+    std::unique_ptr<NameCache> names; Squad sq;
+};
+
+static CatchUpRun CatchUpOnce(const std::string& host, unsigned short port, const std::string& character, int workers){
+    std::shared_ptr<HttpTransport> http = Transport(host, port);
+    std::vector<std::shared_ptr<HttpTransport>> pool;
+    std::mutex poolMu;
+    auto pageFetch = [](std::shared_ptr<HttpTransport> t) -> ChunkFetchFn {
+        if(g_wholeBody) return WholeBodies([t](const std::wstring& path){ std::string body; std::wstring err; t->Get(path, body, err); return body; });
+        return [t](const std::wstring& path, const ChunkSink& sink){ std::wstring err; return t->GetChunks(path, sink, err); };
+    };
+    PageFetcher pages([&]{
+        std::shared_ptr<HttpTransport> t = Transport(host, port);
+        { std::lock_guard<std::mutex> lock(poolMu); pool.push_back(t); }
+        return pageFetch(t);
+    }, workers);
+
+    CatchUpRun run;
+    run.names = std::make_unique<NameCache>();
+    run.sq = MakeSquad(character, run.names.get());
+    FetchFn fetch = [&](const std::wstring& path){
+        std::string body; std::wstring err;
+        http->Get(path, body, err);
+        return body;
+    };
+    if(run.sq.members.empty() || !SquadResolveCharacters(run.sq, fetch)) return run;
+    for(auto& m : run.sq.members) m->lastDeathTs = 1;
+    const uint64_t wire0 = CounterNow(Counter::Bytes), decoded0 = CounterNow(Counter::Decoded);
+    auto t0 = Clock::now();
+    run.poll = SquadPoll(run.sq, fetch, nullptr, workers > 1 ? &pages : nullptr, pageFetch(http));
+    run.wallMs = MsSince(t0, Clock::now());
+    run.wire = CounterNow(Counter::Bytes) - wire0;
+    run.decoded = CounterNow(Counter::Decoded) - decoded0;
+    run.connects = http->Stats().connects;
+    for(const auto& t : pool) run.connects += t->Stats().connects;
+    return run;
+}
+
+static int RunCatchUp(const std::string& hostPort, const std::string& character, int workers, int repeat, size_t rows){
+    std::string host; unsigned short port;
+    SplitHostPort(hostPort, host, port);
+    std::vector<double> seqMs, parMs;
+    CatchUpRun seq, par;
+    for(int r=0; r<repeat; ++r){
+        seq = CatchUpOnce(host, port, character, 1);
+        par = CatchUpOnce(host, port, character, workers);
+        seqMs.push_back(seq.wallMs);
+        parMs.push_back(par.wallMs);
+    }
+    auto row = [](const char* name, const CatchUpRun& c, const std::vector<double>& ms){
+        std::printf("%-12s requests %4d  connects %2llu  applied %6d  wall_ms p50 %8.1f  min %8.1f  wire_kb %7.0f of %7.0f%s\n",
+                    name, c.poll.requests, c.connects, c.poll.applied, Percentile(ms, 0.5), Percentile(ms, 0.0),
+                    c.wire / 1024.0, c.decoded / 1024.0, c.poll.failed ? "  (failed)" : "");
+    };
+    row("sequential", seq, seqMs);
+    char name[32]; std::snprintf(name, sizeof(name), "workers %d", workers);
+    row(name, par, parMs);
+    bool ok = !seq.poll.failed && !par.poll.failed && seq.poll.applied > 0 && seq.poll.applied == par.poll.applied &&
+              seq.sq.members.size() == par.sq.members.size();
+    for(size_t i = 0; ok && i < seq.sq.members.size(); ++i){
+        const KillfeedState& a = *seq.sq.members[i];
+        const KillfeedState& b = *par.sq.members[i];
+        ok = a.lastDeathTs == b.lastDeathTs && a.lastAttackerId == b.lastAttackerId && SameCounts(a, b);
+    }
+    std::printf("speedup      %.2fx\n", Percentile(parMs, 0.5) > 0 ? Percentile(seqMs, 0.5) / Percentile(parMs, 0.5) : 0.0);
+
+    if(ok && seq.sq.members.size() > 1){
+        // Reference: every character on its own, as separate overlays would poll.
+        int requests = 0;
+        for(const auto& m : seq.sq.members){
+            CatchUpRun one = CatchUpOnce(host, port, WideToUtf8(m->characterName), 1);
+            const KillfeedState& a = *one.sq.members[0];
+            requests += one.poll.requests;
+            ok = ok && !one.poll.failed && a.characterId == m->characterId && a.lastDeathTs <= seq.sq.watermark &&
+                 SameCounts(a, *m);
+        }
+        std::printf("separate     requests %4d  (squad %d)\n", requests, seq.poll.requests);
+    }
+    std::printf("check        %s\n", ok ? "OK" : "MISMATCH");
+    for(const auto& m : par.sq.members){
+        if(par.sq.members.size() > 1) std::printf("%s: %zu attackers\n", WideToUtf8(m->characterName).c_str(), m->counts.size());
+        PrintTop(*m, rows);
+    }
+    return ok ? 0 : 1;
+}
+
+// Stream mode: push ingest through the scripted stand-in, then verify against a REST rebuild.
+// Backfill mode: the character's history into BASE.kfh/.kfx, which only fetches what is newer than
+// the store (run it twice: the second run is one short page). Then checks the store against a plain
+// catch-up of the whole history, times a cold open + top-N from disk and a Seed, and opens a copy
+// with its last block cut off, which must lose exactly that block.
+static int RunBackfill(const std::string& hostPort, const std::string& character, int workers,
+                       const std::string& base, size_t rows){
+    std::string host; unsigned short port;
+    SplitHostPort(hostPort, host, port);
+    std::shared_ptr<HttpTransport> http = Transport(host, port);
+    FetchFn fetch = [&](const std::wstring& path){
+        std::string body; std::wstring err;
+        http->Get(path, body, err);
+        return body;
+    };
+    PageFetcher pages([&]() -> ChunkFetchFn {
+        std::shared_ptr<HttpTransport> t = Transport(host, port);
+        return [t](const std::wstring& path, const ChunkSink& sink){ std::wstring err; return t->GetChunks(path, sink, err); };
+    }, workers);
+
+    NameCache names;
+    Squad sq = MakeSquad(character, &names);
+    if(sq.members.size() != 1){ std::fprintf(stderr, "--backfill takes one character\n"); return 2; }
+    KillfeedState& st = *sq.members[0];
+    if(!KillfeedResolveCharacter(st, fetch)){ std::printf("backfill     %s\n", WideToUtf8(st.status).c_str()); return 1; }
+
+    HistoryStore history(base);
+    HistoryOpenInfo info;
+    auto t0 = Clock::now();
+    const bool had = history.Open(ParseULL(st.characterId), &info);
+    std::printf("open         %s  %llu deaths, %zu attackers, last ts %u%s%s  %.2f ms\n",
+                had ? (info.indexed ? "indexed" : "blocks only") : info.why.c_str(),
+                (unsigned long long)history.Rows(), history.Attackers(), history.LastTs(),
+                info.tailBlocks ? "  (+blocks past the index)" : "", info.torn ? "  (torn tail cut)" : "", MsSince(t0, Clock::now()));
+
+    t0 = Clock::now();
+    BackfillRun run = HistoryBackfill(st, history, pages);
+    std::printf("backfill     requests %d  pages %d  added %zu  -> %llu deaths, %zu attackers  wall_ms %.1f%s\n",
+                run.requests, run.pages, run.added, (unsigned long long)history.Rows(), history.Attackers(),
+                MsSince(t0, Clock::now()), run.failed ? "  (failed)" : "");
+    std::error_code ec;
+    const auto colBytes = fs::file_size(base + ".kfh", ec), indexBytes = fs::file_size(base + ".kfx", ec);
+    std::printf("on disk      %.1f KB columns (%.2f bytes/death), %.1f KB index\n", colBytes / 1024.0,
+                history.Rows() ? (double)colBytes / history.Rows() : 0.0, indexBytes / 1024.0);
+
+    // Reference: everything the server has, through the ordinary poll from an old watermark.
+    NameCache refNames;
+    Squad ref = MakeSquad(character, &refNames);
+    KillfeedState& r = *ref.members[0];
+    r.characterId = st.characterId;
+    r.lastDeathTs = 1;
+    r.windows.emplace_back(600);
+    r.windows.emplace_back(1800);
+    PollResult rp = SquadPoll(ref, fetch, nullptr, &pages);
+    KillfeedState seeded;
+    seeded.serviceId = st.serviceId;
+    seeded.characterName = st.characterName;
+    seeded.nameCache = &names;
+    seeded.windows.emplace_back(600);
+    seeded.windows.emplace_back(1800);
+    history.Seed(seeded);
+    bool ok = !run.failed && !rp.failed && SameCounts(r, seeded) && r.lastDeathTs == seeded.lastDeathTs;
+    // The seeded windows hold what the catch-up's saw in the minutes before the last death.
+    for(size_t w = 0; w < r.windows.size(); ++w){
+        std::vector<RankedRow> a = RankView(r, (int)w, 1000), b = RankView(seeded, (int)w, 1000);
+        bool same = a.size() == b.size() && r.windows[w].Deaths() == seeded.windows[w].Deaths();
+        for(size_t i = 0; same && i < a.size(); ++i) same = a[i].id == b[i].id && a[i].cnt.tot == b[i].cnt.tot && a[i].cnt.hs == b[i].cnt.hs;
+        std::printf("windows      %s: %zu deaths, %zu attackers -> %s\n", WideToUtf8(ViewLabel(seeded, (int)w)).c_str(),
+                    seeded.windows[w].Deaths(), b.size(), same ? "OK" : "MISMATCH");
+        ok = ok && same;
+    }
+    // Polling on from the seeded state, as the overlay does, finds nothing the store does not have.
+    PollResult next = KillfeedPoll(seeded, fetch, nullptr);
+    ok = ok && !next.failed && next.applied == 0 && SameCounts(r, seeded);
+    std::printf("check        %s  (store %zu attackers, catch-up %zu; next poll counted %d)\n", ok ? "OK" : "MISMATCH",
+                seeded.counts.size(), r.counts.size(), next.applied);
+
+    // Cold: what an overlay start costs, from the files alone.
+    std::vector<double> openMs, seedMs;
+    std::vector<StoredAttacker> top;
+    for(int i = 0; i < 20; ++i){
+        HistoryStore cold(base);
+        auto a = Clock::now();
+        cold.Open(ParseULL(st.characterId));
+        top = cold.Top(rows, (uint32_t)g_minDeaths);
+        auto b = Clock::now();
+        KillfeedState s;
+        s.nameCache = &names;
+        cold.Seed(s);
+        openMs.push_back(MsSince(a, b));
+        seedMs.push_back(MsSince(b, Clock::now()));
+    }
+    std::printf("cold open    p50 %.2f ms (open + top %zu)  seed p50 %.2f ms\n", Percentile(openMs, 0.5), rows, Percentile(seedMs, 0.5));
+    for(size_t i = 0; i < top.size(); ++i){
+        std::vector<uint64_t> d = history.DeathsBy(top[i].id);
+        std::printf("%zu) %llu  %s  %u/%u  first %llu last %llu\n", i+1, (unsigned long long)top[i].id,
+                    GetNameFor(r, top[i].id).c_str(), top[i].hs, top[i].tot,
+                    d.empty() ? 0ull : (unsigned long long)(d.front() >> 1), d.empty() ? 0ull : (unsigned long long)(d.back() >> 1));
+        ok = ok && d.size() == top[i].tot;
+    }
+
+    // Torn: a copy whose last block lost its final bytes; the index no longer fits the file either.
+    if(history.Rows() && colBytes > 64){
+        const std::string torn = base + "_torn";
+        fs::copy_file(base + ".kfh", torn + ".kfh", fs::copy_options::overwrite_existing, ec);
+        fs::copy_file(base + ".kfx", torn + ".kfx", fs::copy_options::overwrite_existing, ec);
+        fs::resize_file(torn + ".kfh", colBytes - 5, ec);
+        HistoryStore t(torn);
+        HistoryOpenInfo ti;
+        t.Open(ParseULL(st.characterId), &ti);
+        const bool cut = ti.torn && !ti.indexed && t.Rows() < history.Rows() && fs::file_size(torn + ".kfh", ec) < colBytes - 5;
+        std::vector<DeathEvent> again;   // appending after the cut works
+        DeathEvent e; e.ts = t.LastTs() + 1; e.attackerId = 42; again.push_back(e);
+        const bool appended = t.Append(again) == 1;
+        HistoryStore t2(torn);
+        t2.Open(ParseULL(st.characterId));
+        std::printf("torn tail    %s  (%llu of %llu deaths kept)\n", cut && appended && t2.Rows() == t.Rows() ? "OK" : "MISMATCH",
+                    (unsigned long long)t.Rows() - 1, (unsigned long long)history.Rows());
+        ok = ok && cut && appended && t2.Rows() == t.Rows();
+        fs::remove(torn + ".kfh", ec);
+        fs::remove(torn + ".kfx", ec);
+    }
+    return ok ? 0 : 1;
+}
+
+// A poll-mode session saved to BASE and restored into st, as when use_stream is switched on for
+// a session that was polled: its event_id keys must still catch the gap-fill's overlap.
+static bool RestorePolledSession(KillfeedState& st, const FetchFn& fetch, const std::string& base){
+    std::remove((base + ".kfs").c_str());
+    std::remove((base + ".kfj").c_str());
+    KillfeedState polled;
+    polled.serviceId = st.serviceId;
+    polled.characterName = st.characterName;
+    polled.nameCache = st.nameCache;
+    if(KillfeedPoll(polled, fetch, nullptr, nullptr, nullptr).failed) return false;
+    {
+        SessionStore store(base);
+        store.Sync(polled);
+        store.Detach(polled);
+    }
+    SessionStore store(base);
+    SessionLoadInfo info;
+    store.Load(st, &info);
+    std::printf("session      polled %zu attackers, restored %zu -> %s\n", polled.counts.size(), info.attackers,
+                info.restored && !st.keyBySynth ? "OK" : "NOT RESTORED");
+    return info.restored && !st.keyBySynth;
+}
+
+static int RunStream(const std::string& hostPort, const std::string& character, int seconds, size_t rows,
+                     const std::string& session){
+    std::string host; unsigned short port;
+    SplitHostPort(hostPort, host, port);
+    std::unique_ptr<HttpTransport> http = Transport(host, port);
+    FetchFn fetch = [&](const std::wstring& path){
+        std::string body; std::wstring err;
+        http->Get(path, body, err);
+        return body;
+    };
+
+    NameCache names;
+    KillfeedState st;
+    st.serviceId = L"s:example";
+    st.characterName = Utf8ToWide(character);
+    st.nameCache = &names;
+    // The first gap-fill starts at the latest death; the stand-in's script should open with a sleep
+    // so this peek and that one agree.
+    if(!KillfeedResolveCharacter(st, fetch)){ std::fprintf(stderr, "%s\n", WideToUtf8(st.status).c_str()); return 1; }
+    const unsigned long long startTs = ParseLatestJoinedOne(fetch(BuildLatestDeathJoinedDesc(st.serviceId, st.characterId))).ts;
+    const bool restored = session.empty() || RestorePolledSession(st, fetch, session);
+    ScriptWatch ws(MakeSocketStream(host, port));
+    unsigned long long updates = 0;
+    const auto deadline = Clock::now() + std::chrono::seconds(seconds);
+    auto t0 = Clock::now();
+    KillfeedStream(st, ws, fetch, [&]{ ++updates; }, [&](int ms){
+        if(ws.done || Clock::now() >= deadline) return true;
+        if(ms > 0) std::this_thread::sleep_for(std::chrono::milliseconds(ms));
+        return ws.done || Clock::now() >= deadline;
+    });
+    double wall = MsSince(t0, Clock::now());
+    ws.Close();
+
+    // Reference: everything from the session's starting point, straight from REST, same dedupe keys.
+    KillfeedState ref;
+    ref.keyBySynth = true;
+    for(int start = 0;; start += 1000){
+        const std::string body = fetch(BuildDeathsSincePath(st.serviceId, st.characterId, startTs, start, 1000));
+        std::vector<DeathEvent> events = ParseDeathBatch(body);
+        for(const DeathEvent& e : events) ApplyDeathEvent(ref, e);
+        if(events.size() < 1000) break;
+    }
+
+    // Stream deliveries carry no names; every attacker should have been looked up by now.
+    size_t unnamed = 0;
+    st.counts.ForEach([&](uint64_t id, const AttackerSlot& a){ if(id && !a.name) ++unnamed; });
+    bool ok = restored && ws.done && SameCounts(st, ref) && unnamed == 0;
+    std::printf("script       %s\n", ws.done ? "done" : "NOT FINISHED");
+    std::printf("connects     %d  (messages %llu, updates %llu)\n", ws.connects, ws.messages, updates);
+    std::printf("wall_ms      %.1f\n", wall);
+    std::printf("status       %s\n", WideToUtf8(st.status).c_str());
+    std::printf("applied      %zu attackers, last_ts %llu\n", st.counts.size(), st.lastDeathTs);
+    std::printf("rest         %zu attackers, last_ts %llu\n", ref.counts.size(), ref.lastDeathTs);
+    std::printf("names        %zu cached, %zu without a name\n", names.size(), unnamed);
+    std::printf("check        %s\n", ok ? "OK" : "MISMATCH");
+    PrintTop(st, rows);
+    return ok ? 0 : 1;
+}
+
+static int RunReplay(const std::string& dir, int repeat, size_t rows, bool skipEnv, bool overlapCheck,
+                     bool chunkCheck, const std::string& session, const std::vector<int>& windows){
+    std::error_code ec;
+    std::vector<fs::path> files;
+    for(const auto& de : fs::directory_iterator(dir, ec))
+        if(de.is_regular_file()) files.push_back(de.path());
+    if(ec){ std::fprintf(stderr, "cannot read %s: %s\n", dir.c_str(), ec.message().c_str()); return 1; }
+    std::sort(files.begin(), files.end());
+
+    // Load everything up front so the timed section is parse + apply only.
+    std::vector<std::string> bodies; bodies.reserve(files.size());
+    size_t totalBytes = 0;
+    for(const auto& p : files){
+        std::string b;
+        if(!ReadWholeFile(p, b)){ std::fprintf(stderr, "cannot read %s\n", p.string().c_str()); return 1; }
+        std::string plain;
+        if(b.size() >= 2 && (uint8_t)b[0] == 0x1f && (uint8_t)b[1] == 0x8b){   // saved as sent, gzipped
+            if(!InflateAll(b, plain)){ std::fprintf(stderr, "cannot inflate %s\n", p.string().c_str()); return 1; }
+            b.swap(plain);
+        }
+        totalBytes += b.size();
+        bodies.push_back(std::move(b));
+    }
+
+    KillfeedState st;
+    size_t parsed = 0, applied = 0;
+    double parseMs = 0, applyMs = 0;
+    for(int r=0; r<repeat; ++r){
+        st = KillfeedState{};
+        st.skipEnvironment = skipEnv;
+        for(int m : windows) st.windows.emplace_back((unsigned)m * 60);
+        parsed = applied = 0;
+        for(const std::string& body : bodies){
+            auto t0 = Clock::now();
+            std::vector<DeathEvent> events = ParseDeathBatch(body);
+            auto t1 = Clock::now();
+            StageTimer apply(Stage::Apply);
+            const size_t applied0 = applied;
+            for(const DeathEvent& e : events) if(ApplyDeathEvent(st, e)) ++applied;
+            SettleDedupe(st);
+            apply.Stop();
+            PipelineMetrics().Add(Counter::Pages);
+            PipelineMetrics().Add(Counter::Events, applied - applied0);
+            auto t2 = Clock::now();
+            parsed += events.size();
+            parseMs += MsSince(t0, t1);
+            applyMs += MsSince(t1, t2);
+        }
+    }
+    parseMs /= repeat; applyMs /= repeat;
+
+    std::printf("files        %zu\n", bodies.size());
+    std::printf("bytes        %zu\n", totalBytes);
+    std::printf("parsed       %zu\n", parsed);
+    std::printf("applied      %zu\n", applied);
+    std::printf("attackers    %zu\n", st.counts.size());
+    std::printf("last_ts      %llu\n", st.lastDeathTs);
+    if(applied) std::printf("last         %s\n", GetNameFor(st, st.lastAttackerId).c_str());
+    std::printf("parse_ms     %.3f  (%.1f MB/s)\n", parseMs,
+                parseMs > 0 ? (totalBytes / 1e6) / (parseMs / 1e3) : 0.0);
+    std::printf("apply_ms     %.3f  (%.0f events/s)\n", applyMs,
+                applyMs > 0 ? parsed / (applyMs / 1e3) : 0.0);
+
+    // What the overlay pays per repaint to get its rows.
+    const int SNAPS = 1000;
+    size_t sink = 0;
+    auto s0 = Clock::now();
+    for(int i=0; i<SNAPS; ++i) sink += BuildSnapshot(st, rows, g_minDeaths)->rows.size();
+    std::printf("snapshot_us  %.3f  (%zu rows)\n", MsSince(s0, Clock::now()) * 1e3 / SNAPS, sink / SNAPS);
+    if(!st.windows.empty()){
+        sink = 0;
+        s0 = Clock::now();
+        for(int i=0; i<SNAPS; ++i) sink += BuildSnapshot(st, rows, g_minDeaths, 0)->rows.size();
+        std::printf("snapshot_us  %.3f  (%zu rows, %s: %zu attackers sorted)\n", MsSince(s0, Clock::now()) * 1e3 / SNAPS,
+                    sink / SNAPS, WideToUtf8(ViewLabel(st, 0)).c_str(), st.windows[0].Attackers());
+    }
+
+    PrintTop(st, rows);
+    for(size_t w=0; w<st.windows.size(); ++w){
+        std::printf("%s before the last death (%zu deaths)\n", WideToUtf8(ViewLabel(st, (int)w)).c_str(), st.windows[w].Deaths());
+        for(const RankedRow& r : RankView(st, (int)w, rows, g_minDeaths))
+            std::printf("   %llu  %s  %d/%d\n", (unsigned long long)r.id, GetNameFor(st, r.id).c_str(), r.cnt.hs, r.cnt.tot);
+    }
+    bool ok = true;
+    if(!windows.empty()) ok = WindowCheck(bodies, skipEnv, windows) && ok;
+    if(overlapCheck){
+        ok = OverlapCheck(bodies, skipEnv, false) && ok;
+        ok = OverlapCheck(bodies, skipEnv, true) && ok;
+    }
+    if(chunkCheck) ok = ChunkCheck(bodies) && ok;
+    if(!session.empty()) ok = SessionCheck(bodies, skipEnv, session) && ok;
+    return ok ? 0 : 1;
+}
+
+int main(int argc, char** argv){
+    if(argc < 2){ Usage(); return 2; }
+    std::string dir, server, character = "sealobster";
+    std::string stream, catchup, backfill, store = "history";
+    int repeat = 1, workers = 4, ticks = 20, seconds = 60, pollMs = 1000, pollMaxMs = 5000;
+    double hours = 24;
+    bool scheduleSim = false;
+    size_t rows = 10;
+    std::string session, namesPath;
+    std::vector<int> windows;
+    bool skipEnv = true, keepAlive = true, overlapCheck = false, chunkCheck = false, metrics = false;
+    for(int i=1; i<argc; ++i){
+        if(!std::strcmp(argv[i], "--repeat") && i+1<argc)          repeat = std::max(1, std::atoi(argv[++i]));
+        else if(!std::strcmp(argv[i], "--rows") && i+1<argc)       rows = (size_t)std::max(0, std::atoi(argv[++i]));
+        else if(!std::strcmp(argv[i], "--min-deaths") && i+1<argc) g_minDeaths = std::max(1, std::atoi(argv[++i]));
+        else if(!std::strcmp(argv[i], "--keep-environment"))       skipEnv = false;
+        else if(!std::strcmp(argv[i], "--overlap-check"))          overlapCheck = true;
+        else if(!std::strcmp(argv[i], "--chunk-check"))            chunkCheck = true;
+        else if(!std::strcmp(argv[i], "--whole-body"))             g_wholeBody = true;
+        else if(!std::strcmp(argv[i], "--identity"))               g_identity = true;
+        else if(!std::strcmp(argv[i], "--session") && i+1<argc)    session = argv[++i];
+        else if(!std::strcmp(argv[i], "--windows") && i+1<argc){
+            for(std::stringstream ss(argv[++i]); ss.good(); ){
+                std::string m; std::getline(ss, m, ',');
+                if(std::atoi(m.c_str()) > 0) windows.push_back(std::atoi(m.c_str()));
+            }
+        }
+        else if(!std::strcmp(argv[i], "--names") && i+1<argc)      namesPath = argv[++i];
+        else if(!std::strcmp(argv[i], "--server") && i+1<argc)     server = argv[++i];
+        else if(!std::strcmp(argv[i], "--character") && i+1<argc)  character = argv[++i];
+        else if(!std::strcmp(argv[i], "--ticks") && i+1<argc)      ticks = std::max(1, std::atoi(argv[++i]));
+        else if(!std::strcmp(argv[i], "--no-keepalive"))           keepAlive = false;
+        else if(!std::strcmp(argv[i], "--stream") && i+1<argc)     stream = argv[++i];
+        else if(!std::strcmp(argv[i], "--catchup") && i+1<argc)    catchup = argv[++i];
+        else if(!std::strcmp(argv[i], "--backfill") && i+1<argc)   backfill = argv[++i];
+        else if(!std::strcmp(argv[i], "--store") && i+1<argc)      store = argv[++i];
+        else if(!std::strcmp(argv[i], "--workers") && i+1<argc)    workers = std::max(1, std::atoi(argv[++i]));
+        else if(!std::strcmp(argv[i], "--seconds") && i+1<argc)    seconds = std::max(1, std::atoi(argv[++i]));
+        else if(!std::strcmp(argv[i], "--schedule-sim"))           scheduleSim = true;
+        else if(!std::strcmp(argv[i], "--hours") && i+1<argc)      hours = std::max(1.0, std::atof(argv[++i]));
+        else if(!std::strcmp(argv[i], "--poll-ms") && i+1<argc)    pollMs = std::max(100, std::atoi(argv[++i]));
+        else if(!std::strcmp(argv[i], "--poll-max-ms") && i+1<argc) pollMaxMs = std::max(100, std::atoi(argv[++i]));
+        else if(!std::strcmp(argv[i], "--metrics"))                metrics = true;
+        else if(argv[i][0] != '-' && dir.empty())                  dir = argv[i];
+        else { Usage(); return 2; }
+    }
+    int rc;
+    if(scheduleSim)            rc = RunScheduleSim(hours, pollMs, pollMaxMs);
+    else if(!catchup.empty())  rc = RunCatchUp(catchup, character, workers, repeat, rows);
+    else if(!backfill.empty()) rc = RunBackfill(backfill, character, workers, store, rows);
+    else if(!stream.empty())   rc = RunStream(stream, character, seconds, rows, session);
+    else if(!server.empty())   rc = RunServer(server, character, ticks, keepAlive, rows, namesPath);
+    else if(!dir.empty())      rc = RunReplay(dir, repeat, rows, skipEnv, overlapCheck, chunkCheck, session, windows);
+    else { Usage(); return 2; }
+    if(metrics){
+        MetricsSnapshot m; PipelineMetrics().Take(m);
+        std::printf("metrics\n");
+        PrintMetrics(stdout, m, "  ");
+    }
+    return rc;
+}
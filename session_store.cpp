@@ -0,0 +1,358 @@
+// session_store.cpp — snapshot + journal persistence for KillfeedState (see session_store.h).
+
+#include "session_store.h"
+#include "file_util.h"
+#include "inflate.h"
+#include <algorithm>
+#include <cstring>
+#include <vector>
+
+static size_t Pad8(size_t n){ return (n + 7) & ~(size_t)7; }
+
+// ========================== On-disk layout ==========================
+static const char     kSnapMagic[8]    = {'K','F','S','N','A','P','\0','\0'};
+static const char     kJournalMagic[8] = {'K','F','J','R','N','L','\0','\0'};
+static const char     kNamesMagic[8]   = {'K','F','N','A','M','E','S','\0'};
+static const uint32_t kVersion         = 1;
+
+struct SnapHeader {
+    char     magic[8];
+    uint32_t version, headerBytes;
+    uint64_t generation, characterId;
+    uint64_t lastDeathTs, dedupeFloor, dedupeWindow, lastAttackerId;
+    uint32_t flags, crc;                  // crc32 of the whole file with this field zero
+    uint32_t attackerCount, eventKeyCount, synthKeyCount, stringBytes;
+    uint64_t attackersOff, eventKeysOff, synthKeysOff, stringsOff;
+    uint32_t characterNameOff, characterNameLen, lastAttackerNameOff, lastAttackerNameLen;
+};
+enum : uint32_t { kFlagKeyBySynth = 1 };
+
+struct AttackerRec { uint64_t id, lastTs; int32_t hs, tot; uint32_t nameOff, nameLen; };
+struct EventKeyRec { uint64_t id, ts; };
+struct SynthKeyRec { uint64_t tsHs, attacker; };
+static const uint32_t kNoName = 0xFFFFFFFFu;
+
+struct JournalHeader {
+    char     magic[8];
+    uint32_t version, headerBytes;
+    uint64_t generation, characterId;
+};
+
+// Record: crc32 of everything after the crc field, type, total size (multiple of 8), payload.
+struct RecordHead  { uint32_t crc; uint16_t type, size; };
+struct DeathRec    { uint64_t ts, attackerId, eventId; uint8_t hs, pad; uint16_t nameLen; uint32_t pad2; };
+struct WatermarkRec{ uint64_t lastDeathTs, dedupeFloor; };
+enum : uint16_t { kRecDeath = 1, kRecWatermark = 2 };
+
+struct NamesHeader { char magic[8]; uint32_t version, count, crc, pad; };   // crc of the records
+struct NameRec     { uint64_t id; uint32_t len, pad; };                    // + len UTF-8 bytes, padded to 8
+
+static_assert(sizeof(NamesHeader) == 24 && sizeof(NameRec) == 16 &&
+              sizeof(SnapHeader) % 8 == 0 && sizeof(AttackerRec) == 32 && sizeof(JournalHeader) == 32 &&
+              sizeof(RecordHead) == 8 && sizeof(DeathRec) == 32, "on-disk layout");
+
+template<typename T> static void Put(std::string& out, const T& v){ out.append((const char*)&v, sizeof(v)); }
+
+// ========================== SessionStore ==========================
+SessionStore::SessionStore(std::string basePath)
+    : snapPath_(basePath + ".kfs"), journalPath_(basePath + ".kfj") {}
+
+SessionStore::~SessionStore(){ if (journal_) std::fclose(journal_); }
+
+bool SessionStore::Load(KillfeedState& st, SessionLoadInfo* info){
+    SessionLoadInfo local;
+    SessionLoadInfo& out = info ? *info : local;
+    out = SessionLoadInfo{};
+    journalValid_ = false;
+
+    std::vector<uint64_t> buf;
+    size_t bytes = 0;
+    if (!ReadAllAligned(snapPath_, buf, bytes)){ out.why = "no saved session"; return false; }
+    const char* base = (const char*)buf.data();
+    SnapHeader h;
+    if (bytes < sizeof(h)){ out.why = "snapshot too short"; return false; }
+    std::memcpy(&h, base, sizeof(h));
+    if (std::memcmp(h.magic, kSnapMagic, 8) || h.version != kVersion || h.headerBytes != sizeof(h)){
+        out.why = "snapshot has an unknown format"; return false;
+    }
+    SnapHeader zeroed = h; zeroed.crc = 0;
+    uint32_t crc = Crc32(&zeroed, sizeof(zeroed));
+    crc = Crc32(base + sizeof(h), bytes - sizeof(h), crc);
+    if (crc != h.crc){ out.why = "snapshot is corrupt"; return false; }
+    auto fits = [&](uint64_t off, uint64_t n, uint64_t size){ return off <= bytes && n <= (bytes - off) / size; };
+    if (!fits(h.attackersOff, h.attackerCount, sizeof(AttackerRec)) || !fits(h.eventKeysOff, h.eventKeyCount, sizeof(EventKeyRec)) ||
+        !fits(h.synthKeysOff, h.synthKeyCount, sizeof(SynthKeyRec)) || !fits(h.stringsOff, h.stringBytes, 1)){
+        out.why = "snapshot is corrupt"; return false;
+    }
+    const char* pool = base + h.stringsOff;
+    auto str = [&](uint32_t off, uint32_t len) -> std::string_view {
+        if (off == kNoName || (uint64_t)off + len > h.stringBytes) return {};
+        return std::string_view(pool + off, len);
+    };
+    if (ToLowerAscii(Utf8ToWide(str(h.characterNameOff, h.characterNameLen))) != ToLowerAscii(st.characterName)){
+        out.why = "saved session is for another character"; return false;
+    }
+
+    KillfeedState r;
+    r.serviceId       = st.serviceId;
+    r.characterName   = st.characterName;
+    r.skipEnvironment = st.skipEnvironment;
+    r.nameCache       = st.nameCache;
+    r.characterId     = to_wstring_compat(h.characterId);
+    r.keyBySynth      = (h.flags & kFlagKeyBySynth) != 0;
+    r.lastDeathTs     = h.lastDeathTs;
+    r.dedupeFloor     = h.dedupeFloor;
+    r.dedupeWindow    = h.dedupeWindow;
+    for (const WindowCounts& w : st.windows) r.windows.emplace_back(w.Seconds());
+
+    const AttackerRec* ar = (const AttackerRec*)(base + h.attackersOff);
+    r.counts.reserve(h.attackerCount);
+    for (uint32_t i = 0; i < h.attackerCount; ++i)
+        RestoreAttacker(r, ar[i].id, Counters{ar[i].hs, ar[i].tot}, ar[i].lastTs, str(ar[i].nameOff, ar[i].nameLen));
+    const EventKeyRec* ek = (const EventKeyRec*)(base + h.eventKeysOff);
+    r.seenEventIds.reserve(h.eventKeyCount);
+    for (uint32_t i = 0; i < h.eventKeyCount; ++i) r.seenEventIds[ek[i].id] = ek[i].ts;
+    const SynthKeyRec* sk = (const SynthKeyRec*)(base + h.synthKeysOff);
+    r.seenSynth.reserve(h.synthKeyCount);
+    for (uint32_t i = 0; i < h.synthKeyCount; ++i) r.seenSynth.Insert(SynthKey{sk[i].tsHs, sk[i].attacker});
+    r.lastAttackerId = h.lastAttackerId;
+    std::string_view lastName = str(h.lastAttackerNameOff, h.lastAttackerNameLen);
+    if (!lastName.empty()) r.lastAttackerName = lastName;
+
+    // Journal of the same generation: replay until the first record that does not check out.
+    size_t replayed = 0;
+    bool torn = false, haveJournal = false;
+    if (ReadAllAligned(journalPath_, buf, bytes)){
+        base = (const char*)buf.data();
+        JournalHeader jh;
+        if (bytes >= sizeof(jh)) std::memcpy(&jh, base, sizeof(jh));
+        haveJournal = bytes >= sizeof(jh) && !std::memcmp(jh.magic, kJournalMagic, 8) && jh.version == kVersion &&
+                      jh.headerBytes == sizeof(jh) && jh.generation == h.generation && jh.characterId == h.characterId;
+        size_t pos = sizeof(jh);
+        while (haveJournal && pos < bytes){
+            RecordHead rh;
+            if (bytes - pos < sizeof(rh)){ torn = true; break; }
+            std::memcpy(&rh, base + pos, sizeof(rh));
+            if (rh.size < sizeof(rh) || rh.size % 8 || rh.size > bytes - pos ||
+                Crc32(base + pos + 4, rh.size - 4u) != rh.crc){ torn = true; break; }
+            const char* p = base + pos + sizeof(rh);
+            const size_t len = rh.size - sizeof(rh);
+            if (rh.type == kRecDeath && len >= sizeof(DeathRec)){
+                DeathRec d; std::memcpy(&d, p, sizeof(d));
+                if (sizeof(d) + d.nameLen > len){ torn = true; break; }
+                DeathEvent e;
+                e.ts = d.ts; e.attackerId = d.attackerId; e.eventId = d.eventId; e.isHS = d.hs != 0;
+                e.attackerName = std::string_view(p + sizeof(d), d.nameLen);
+                ApplyDeathEvent(r, e);
+            } else if (rh.type == kRecWatermark && len >= sizeof(WatermarkRec)){
+                WatermarkRec w; std::memcpy(&w, p, sizeof(w));
+                if (w.lastDeathTs > r.lastDeathTs) r.lastDeathTs = w.lastDeathTs;
+                RaiseDedupeFloor(r, w.dedupeFloor);
+            } else { torn = true; break; }
+            ++replayed;
+            pos += rh.size;
+        }
+    }
+
+    if (r.counts.size()) r.line = KilledByLine(r, L"");
+    r.status = L"Restored session (" + to_wstring_compat(r.counts.size()) + L" attackers)";
+    st = std::move(r);
+
+    gen_ = h.generation;
+    charId_ = h.characterId;
+    journalValid_ = haveJournal && !torn;
+    records_ = replayed;
+    out.restored = true;
+    out.attackers = st.counts.size();
+    out.journalRecords = replayed;
+    out.journalTorn = torn;
+    return true;
+}
+
+bool SessionStore::Compact(const KillfeedState& st){
+    const uint64_t charId = ParseULL(st.characterId);
+    if (!charId) return false;
+
+    std::string pool;
+    auto addStr = [&](std::string_view u, uint32_t& off, uint32_t& len){
+        off = (uint32_t)pool.size(); len = (uint32_t)u.size();
+        pool += u;
+    };
+
+    SnapHeader h{};
+    std::memcpy(h.magic, kSnapMagic, 8);
+    h.version = kVersion;
+    h.headerBytes = sizeof(h);
+    h.generation = gen_ + 1;
+    h.characterId = charId;
+    h.lastDeathTs = st.lastDeathTs;
+    h.dedupeFloor = st.dedupeFloor;
+    h.dedupeWindow = st.dedupeWindow;
+    h.lastAttackerId = st.lastAttackerId;
+    h.flags = st.keyBySynth ? (uint32_t)kFlagKeyBySynth : 0u;
+    addStr(WideToUtf8(st.characterName), h.characterNameOff, h.characterNameLen);
+    addStr(st.lastAttackerName, h.lastAttackerNameOff, h.lastAttackerNameLen);
+
+    // Attackers in ranking order, so Load rebuilds the ranking with end-hinted inserts.
+    std::string attackers, eventKeys, synthKeys;
+    attackers.reserve(st.ranking.size() * sizeof(AttackerRec));
+    for (const RankKey& k : st.ranking){
+        const AttackerSlot* a = st.counts.Find(k.id);
+        AttackerRec rec{k.id, a->lastTs, a->cnt.hs, a->cnt.tot, kNoName, 0};
+        if (a->name) addStr(st.names[a->name - 1], rec.nameOff, rec.nameLen);
+        Put(attackers, rec);
+    }
+    st.seenEventIds.ForEach([&](uint64_t id, unsigned long long ts){ Put(eventKeys, EventKeyRec{id, ts}); });
+    st.seenSynth.ForEach([&](const SynthKey& k, FlatEmpty){ Put(synthKeys, SynthKeyRec{k.tsHs, k.attacker}); });
+    h.attackerCount = (uint32_t)st.ranking.size();
+    h.eventKeyCount = (uint32_t)st.seenEventIds.size();
+    h.synthKeyCount = (uint32_t)st.seenSynth.size();
+    h.stringBytes   = (uint32_t)pool.size();
+    h.attackersOff  = sizeof(h);
+    h.eventKeysOff  = h.attackersOff + attackers.size();
+    h.synthKeysOff  = h.eventKeysOff + eventKeys.size();
+    h.stringsOff    = h.synthKeysOff + synthKeys.size();
+    pool.resize(Pad8(pool.size()), '\0');
+
+    uint32_t crc = Crc32(&h, sizeof(h));
+    crc = Crc32(attackers.data(), attackers.size(), crc);
+    crc = Crc32(eventKeys.data(), eventKeys.size(), crc);
+    crc = Crc32(synthKeys.data(), synthKeys.size(), crc);
+    h.crc = Crc32(pool.data(), pool.size(), crc);
+
+    const std::string tmp = snapPath_ + ".tmp";
+    FILE* f = OpenFileUtf8(tmp, "wb");
+    if (!f) return false;
+    bool ok = std::fwrite(&h, sizeof(h), 1, f) == 1;
+    for (const std::string* s : {&attackers, &eventKeys, &synthKeys, &pool})
+        ok = ok && (s->empty() || std::fwrite(s->data(), s->size(), 1, f) == 1);
+    ok = FlushToDisk(f) && ok;
+    ok = (std::fclose(f) == 0) && ok;
+    if (!ok || !RenameOver(tmp, snapPath_)){ RemoveFileUtf8(tmp); return false; }
+
+    // The snapshot now holds everything; a crash before the new journal header lands just leaves
+    // an old-generation journal behind, which Load ignores.
+    gen_ = h.generation;
+    charId_ = charId;
+    records_ = 0;
+    wmTs_ = st.lastDeathTs; wmFloor_ = st.dedupeFloor;
+    journalValid_ = OpenJournal(true);
+    return journalValid_;
+}
+
+bool SessionStore::OpenJournal(bool truncate){
+    if (journal_){ std::fclose(journal_); journal_ = nullptr; }
+    journal_ = OpenFileUtf8(journalPath_, truncate ? "wb" : "ab");
+    if (!journal_) return false;
+    if (!truncate) return true;
+    JournalHeader jh{};
+    std::memcpy(jh.magic, kJournalMagic, 8);
+    jh.version = kVersion;
+    jh.headerBytes = sizeof(jh);
+    jh.generation = gen_;
+    jh.characterId = charId_;
+    if (std::fwrite(&jh, sizeof(jh), 1, journal_) != 1 || !FlushToDisk(journal_)){
+        std::fclose(journal_); journal_ = nullptr; return false;
+    }
+    return true;
+}
+
+bool SessionStore::Attach(KillfeedState& st){
+    const uint64_t charId = ParseULL(st.characterId);
+    if (!charId) return false;
+    // Keep appending to the journal Load replayed; anything else starts over from a snapshot.
+    bool ok = (journalValid_ && charId == charId_) ? OpenJournal(false) : Compact(st);
+    if (!ok) return false;
+    wmTs_ = st.lastDeathTs; wmFloor_ = st.dedupeFloor;
+    st.journal = [this](const DeathEvent& e){ Append(e); };
+    return true;
+}
+
+void SessionStore::Append(const DeathEvent& e){
+    if (!journal_) return;
+    std::string decoded;
+    if (e.nameEscaped) decoded = DecodedAttackerName(e);
+    std::string_view name = e.nameEscaped ? std::string_view(decoded) : e.attackerName;
+    if (name.size() > 0xFFFF - sizeof(RecordHead) - sizeof(DeathRec) - 8) name = {};
+    DeathRec d{e.ts, e.attackerId, e.eventId, (uint8_t)(e.isHS ? 1 : 0), 0, (uint16_t)name.size(), 0};
+    const size_t size = Pad8(sizeof(RecordHead) + sizeof(d) + name.size());
+    std::string& rec = recBuf_;
+    rec.assign(size, '\0');
+    RecordHead rh{0, kRecDeath, (uint16_t)size};
+    std::memcpy(&rec[sizeof(rh)], &d, sizeof(d));
+    std::memcpy(&rec[sizeof(rh) + sizeof(d)], name.data(), name.size());
+    std::memcpy(&rec[0], &rh, sizeof(rh));
+    rh.crc = Crc32(rec.data() + 4, size - 4);
+    std::memcpy(&rec[0], &rh, sizeof(rh));
+    if (std::fwrite(rec.data(), size, 1, journal_) == 1) ++records_;
+}
+
+void SessionStore::Sync(KillfeedState& st){
+    if (!journal_ && !Attach(st)) return;
+    if (st.lastDeathTs != wmTs_ || st.dedupeFloor != wmFloor_){
+        char rec[sizeof(RecordHead) + sizeof(WatermarkRec)];
+        RecordHead rh{0, kRecWatermark, (uint16_t)sizeof(rec)};
+        WatermarkRec w{st.lastDeathTs, st.dedupeFloor};
+        std::memcpy(rec, &rh, sizeof(rh));
+        std::memcpy(rec + sizeof(rh), &w, sizeof(w));
+        rh.crc = Crc32(rec + 4, sizeof(rec) - 4);
+        std::memcpy(rec, &rh, sizeof(rh));
+        if (std::fwrite(rec, sizeof(rec), 1, journal_) == 1) ++records_;
+        wmTs_ = st.lastDeathTs; wmFloor_ = st.dedupeFloor;
+    }
+    std::fflush(journal_);
+    if (records_ >= compactEvery) Compact(st);
+}
+
+void SessionStore::Detach(KillfeedState& st){
+    st.journal = nullptr;
+    if (journal_){ FlushToDisk(journal_); std::fclose(journal_); journal_ = nullptr; }
+}
+
+// ========================== Name cache ==========================
+bool SaveNameCache(const NameCache& names, const std::string& path){
+    std::string recs;
+    uint32_t count = 0;
+    names.ForEachOldestFirst([&](uint64_t id, const std::string& name){
+        Put(recs, NameRec{id, (uint32_t)name.size(), 0});
+        recs += name;
+        recs.resize(Pad8(recs.size()), '\0');
+        ++count;
+    });
+    NamesHeader h{};
+    std::memcpy(h.magic, kNamesMagic, 8);
+    h.version = kVersion;
+    h.count = count;
+    h.crc = Crc32(recs.data(), recs.size());
+
+    const std::string tmp = path + ".tmp";
+    FILE* f = OpenFileUtf8(tmp, "wb");
+    if (!f) return false;
+    bool ok = std::fwrite(&h, sizeof(h), 1, f) == 1 && (recs.empty() || std::fwrite(recs.data(), recs.size(), 1, f) == 1);
+    ok = FlushToDisk(f) && ok;
+    ok = (std::fclose(f) == 0) && ok;
+    if (!ok || !RenameOver(tmp, path)){ RemoveFileUtf8(tmp); return false; }
+    return true;
+}
+
+bool LoadNameCache(NameCache& names, const std::string& path){
+    std::vector<uint64_t> buf;
+    size_t bytes = 0;
+    if (!ReadAllAligned(path, buf, bytes)) return false;
+    const char* base = (const char*)buf.data();
+    NamesHeader h;
+    if (bytes < sizeof(h)) return false;
+    std::memcpy(&h, base, sizeof(h));
+    if (std::memcmp(h.magic, kNamesMagic, 8) || h.version != kVersion ||
+        Crc32(base + sizeof(h), bytes - sizeof(h)) != h.crc) return false;
+    size_t pos = sizeof(h);
+    for (uint32_t i = 0; i < h.count; ++i){
+        if (bytes - pos < sizeof(NameRec)) return false;
+        NameRec r; std::memcpy(&r, base + pos, sizeof(r));
+        pos += sizeof(r);
+        if (Pad8(r.len) > bytes - pos) return false;
+        names.Put(r.id, std::string_view(base + pos, r.len));
+        pos += Pad8(r.len);
+    }
+    return true;
+}
@@ -0,0 +1,68 @@
+// session_store.h — the session on disk, so a restart (or a crash) picks up where it left off.
+// <base>.kfs  snapshot: a fixed header of section offsets followed by 8-byte aligned record arrays
+//             and a UTF-8 string pool, little-endian, CRC-checked; readable in place from a mapped
+//             or slurped file. Written to <base>.kfs.tmp and renamed over the old one.
+// <base>.kfj  journal: every event that got past dedupe (KillfeedState::journal) plus the dedupe
+//             watermark at each sync point, one CRC-checked record each, appended and flushed.
+//             A record torn by a crash fails its CRC and everything from it on is dropped.
+// Both carry a generation; a journal is only replayed on top of the snapshot with the same one.
+// Attacker names live in a separate file shared by every character (SaveNameCache).
+#pragma once
+
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+#include "killfeed_core.h"
+
+// <path>: the name cache, oldest first so loading it back in order restores the LRU order.
+// Same CRC-checked, temp-file-and-rename treatment as the snapshot; a bad file loads nothing.
+bool SaveNameCache(const NameCache& names, const std::string& path);
+bool LoadNameCache(NameCache& names, const std::string& path);
+
+struct SessionLoadInfo {
+    bool        restored = false;
+    size_t      attackers = 0;
+    size_t      journalRecords = 0;    // replayed on top of the snapshot
+    bool        journalTorn = false;   // a partial record at the end was dropped
+    std::string why;                   // reason when nothing was restored
+};
+
+class SessionStore {
+public:
+    explicit SessionStore(std::string basePath);   // UTF-8, without extension
+    ~SessionStore();
+    SessionStore(const SessionStore&) = delete;
+    SessionStore& operator=(const SessionStore&) = delete;
+
+    // Replaces st with the saved session if the snapshot is for st.characterName (settings in st
+    // are kept). Call before the first poll; the restored characterId skips the name lookup.
+    bool Load(KillfeedState& st, SessionLoadInfo* info = nullptr);
+
+    // Sync point (after a poll or a live event): starts journaling once st.characterId is known,
+    // records a moved watermark, flushes, and compacts once the journal has grown past compactEvery.
+    void Sync(KillfeedState& st);
+
+    // Fresh snapshot of st, then an empty journal under the next generation.
+    bool Compact(const KillfeedState& st);
+
+    // Stops journaling st and closes the journal.
+    void Detach(KillfeedState& st);
+
+    size_t JournalRecords() const { return records_; }
+    size_t compactEvery = 4096;
+
+private:
+    bool Attach(KillfeedState& st);
+    void Append(const DeathEvent& e);
+    bool OpenJournal(bool truncate);
+
+    std::string snapPath_, journalPath_;
+    FILE*    journal_ = nullptr;
+    uint64_t gen_ = 0;
+    uint64_t charId_ = 0;              // character the files on disk belong to
+    bool     journalValid_ = false;    // journal on disk matches the loaded snapshot, untorn
+    size_t   records_ = 0;
+    unsigned long long wmTs_ = 0, wmFloor_ = 0;   // last watermark written
+    std::string recBuf_;
+};
@@ -0,0 +1,449 @@
+// standin.cpp — local stand-in for the Census REST API, serving recorded characters_event data.
+// Loads every event object from a directory of recorded responses and answers the queries the
+// overlay makes (character lookup by names or by a list of ids, characters_event with
+// after/c:start/c:limit/c:sort, attacker names only with c:join) over HTTP/1.1 with keep-alive,
+// one thread per connection. Each character name asked for is handed the next recorded victim
+// (in order of first appearance), so a recording with several victims stands in for a squad. --connect-delay-ms emulates the
+// TCP+TLS handshake cost of the real host so connection reuse can be measured on loopback; --kbps sends REST bodies
+// in 8 KB slices at that rate, like a real download, so parsing while downloading can be measured too.
+// REST bodies are gzip-compressed when the request accepts it; --encoding deflate sends zlib instead,
+// --encoding identity never compresses (a server that ignores Accept-Encoding).
+//
+// /streaming is a WebSocket stand-in for the real-time event stream. With --script, REST only
+// sees the first --history events and the stream connection walks the script, one step per line:
+//   deliver N     reveal the next N events and push each as a Death serviceMessage
+//   hidden N      reveal the next N events without pushing them (missed while disconnected)
+//   dup           push the last delivered message again
+//   heartbeat     push a heartbeat
+//   sleep MS      pause
+//   disconnect    drop the connection; the next connection continues the script
+// When the script ends it pushes {"type":"standinScriptDone"} and then only heartbeats.
+//
+// Build (Linux):
+//   g++ -std=gnu++17 -O2 -Wall -Wextra -pthread standin.cpp inflate.cpp -o killfeed_standin
+// Usage:
+//   killfeed_standin <dir> [--port N] [--connect-delay-ms N] [--latency-ms N] [--kbps N]
+//                    [--encoding gzip|deflate|identity] [--script FILE] [--history N] [--verbose]
+
+#include "inflate.h"
+#include "json_scan.h"
+#include "ws_codec.h"
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <map>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <unordered_set>
+#include <vector>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+namespace fs = std::filesystem;
+
+struct StoredEvent {
+    unsigned long long ts = 0;
+    std::string characterId;
+    std::string attackerId;
+    bool        isHS = false;
+    std::string raw;        // the event object without the injected attacker name
+    std::string rawJoined;  // exactly as recorded, c:join included
+};
+
+struct Options {
+    unsigned short port = 8088;
+    int  connectDelayMs = 0;
+    int  latencyMs      = 0;
+    int  kbps           = 0;     // REST response rate, 0 = as fast as the socket takes it
+    ContentCoding encoding = ContentCoding::Gzip;   // used when the request accepts it
+    bool verbose        = false;
+    std::string script;
+    size_t history      = 0;
+};
+
+static Options                  g_opt;
+static std::vector<StoredEvent> g_events;      // ascending by timestamp
+static std::vector<std::string> g_characterIds;  // victims, in order of first appearance
+static std::map<std::string, size_t> g_nameSlots;  // name.first_lower -> index into g_characterIds
+static std::mutex               g_nameMu;
+static std::map<std::string, std::string> g_attackerNames;   // attacker_character_id -> name.first
+static std::atomic<unsigned long long> g_connections{0}, g_requests{0};
+static std::atomic<size_t>      g_revealed{0};  // REST sees g_events[0, g_revealed)
+
+// Stream script, shared by successive stream connections.
+static std::vector<std::string> g_script;
+static size_t                   g_scriptPos = 0;
+static std::string              g_lastPush;
+static std::mutex               g_scriptMu;
+
+// ========================== Loading ==========================
+static void LoadEvents(const std::string& body, std::unordered_set<std::string>& seen){
+    JsonScanner sc(body);
+    JsonTok t;
+    do { t = sc.Next(); } while (t != JsonTok::ArrBegin && t != JsonTok::End && t != JsonTok::Error);
+    if (t != JsonTok::ArrBegin) return;
+    const int arrDepth = sc.Depth();
+    for(;;){
+        t = sc.Next();
+        if (t == JsonTok::End || t == JsonTok::Error || t == JsonTok::ArrEnd) return;
+        if (t != JsonTok::ObjBegin || sc.Depth() != arrDepth + 1){ sc.SkipValue(t); continue; }
+        size_t b = sc.Offset() - 1;
+        size_t joinB = 0, joinE = 0;
+        std::string joinName;
+        StoredEvent e;
+        while (sc.Depth() > arrDepth){
+            size_t before = sc.Offset();
+            JsonTok k = sc.Next();
+            if (k == JsonTok::End || k == JsonTok::Error) return;
+            if (k != JsonTok::Key || sc.Depth() != arrDepth + 1) continue;
+            std::string_view key = sc.Text();
+            JsonTok v = sc.Next();
+            if (v == JsonTok::String && key == "timestamp")    e.ts = std::strtoull(std::string(sc.Text()).c_str(), nullptr, 10);
+            else if (v == JsonTok::String && key == "character_id") e.characterId = std::string(sc.Text());
+            else if (v == JsonTok::String && key == "attacker_character_id") e.attackerId = std::string(sc.Text());
+            else if (v == JsonTok::String && key == "is_headshot") e.isHS = (sc.Text() == "1");
+            else if (v == JsonTok::ObjBegin && key == "attacker"){
+                // The c:join injection: remember the name and where it sits so it can be left out.
+                const int attDepth = sc.Depth();
+                bool inName = false;
+                while (sc.Depth() >= attDepth){
+                    JsonTok a = sc.Next();
+                    if (a == JsonTok::End || a == JsonTok::Error) return;
+                    if (a != JsonTok::Key) continue;
+                    std::string_view ak = sc.Text();
+                    JsonTok av = sc.Next();
+                    if (ak == "name" && av == JsonTok::ObjBegin){ inName = true; continue; }
+                    if (inName && ak == "first" && av == JsonTok::String) joinName = std::string(sc.Text());
+                    else sc.SkipValue(av);
+                }
+                joinB = before; joinE = sc.Offset();
+            }
+            else sc.SkipValue(v);
+        }
+        e.rawJoined = body.substr(b, sc.Offset() - b);
+        e.raw = e.rawJoined;
+        if (joinE > joinB){
+            // Drop the member and one separator: the one after it, or before it when it was last.
+            const size_t cut = joinB - b;
+            e.raw.erase(cut, joinE - joinB);
+            size_t next = e.raw.find_first_not_of(" \t\r\n", cut);
+            size_t prev = e.raw.find_last_not_of(" \t\r\n", cut - 1);
+            if (next != std::string::npos && e.raw[next] == ',') e.raw.erase(cut, next + 1 - cut);
+            else if (prev != std::string::npos && e.raw[prev] == ',') e.raw.erase(prev, cut - prev);
+            if (!e.attackerId.empty() && !joinName.empty()) g_attackerNames[e.attackerId] = joinName;
+        }
+        if (seen.insert(e.rawJoined).second) g_events.push_back(std::move(e));
+    }
+}
+
+static bool LoadDir(const std::string& dir){
+    std::error_code ec;
+    std::vector<fs::path> files;
+    for (const auto& de : fs::directory_iterator(dir, ec)) if (de.is_regular_file()) files.push_back(de.path());
+    if (ec) return false;
+    std::sort(files.begin(), files.end());
+    std::unordered_set<std::string> seen;
+    for (const auto& p : files){
+        std::ifstream f(p, std::ios::binary);
+        std::ostringstream ss; ss << f.rdbuf();
+        LoadEvents(ss.str(), seen);
+    }
+    std::stable_sort(g_events.begin(), g_events.end(),
+                     [](const StoredEvent& a, const StoredEvent& b){ return a.ts < b.ts; });
+    for (const StoredEvent& e : g_events)
+        if (std::find(g_characterIds.begin(), g_characterIds.end(), e.characterId) == g_characterIds.end())
+            g_characterIds.push_back(e.characterId);
+    return true;
+}
+
+// ========================== Query handling ==========================
+static std::map<std::string, std::string> ParseQuery(const std::string& target){
+    std::map<std::string, std::string> q;
+    size_t qm = target.find('?');
+    if (qm == std::string::npos) return q;
+    std::string rest = target.substr(qm + 1);
+    size_t i = 0;
+    while (i <= rest.size()){
+        size_t amp = rest.find('&', i); if (amp == std::string::npos) amp = rest.size();
+        std::string kv = rest.substr(i, amp - i);
+        size_t eq = kv.find('=');
+        if (!kv.empty()) q[kv.substr(0, eq)] = (eq == std::string::npos) ? "" : kv.substr(eq + 1);
+        i = amp + 1;
+    }
+    return q;
+}
+
+static bool ListHas(const std::string& list, const std::string& v){
+    size_t i = 0;
+    while (i <= list.size()){
+        size_t c = list.find(',', i); if (c == std::string::npos) c = list.size();
+        if (list.compare(i, c - i, v) == 0) return true;
+        i = c + 1;
+    }
+    return false;
+}
+
+static std::string Respond(const std::string& target, int& status){
+    status = 200;
+    auto q = ParseQuery(target);
+    if (target.find("/get/ps2:v2/characters_event") != std::string::npos){
+        unsigned long long after = q.count("after") ? std::strtoull(q["after"].c_str(), nullptr, 10) : 0;
+        size_t limit = q.count("c:limit") ? (size_t)std::atoi(q["c:limit"].c_str()) : 1;
+        size_t start = q.count("c:start") ? (size_t)std::atoi(q["c:start"].c_str()) : 0;
+        bool desc = q.count("c:sort") && q["c:sort"].find(":desc") != std::string::npos;
+        bool joined = q.count("c:join") != 0;
+        const std::string& ids = q["character_id"];
+
+        std::vector<const StoredEvent*> hits;
+        auto visibleEnd = g_events.begin() + (ptrdiff_t)std::min(g_revealed.load(), g_events.size());
+        auto lo = std::upper_bound(g_events.begin(), visibleEnd, after,
+                                   [](unsigned long long a, const StoredEvent& e){ return a < e.ts; });
+        for (auto it = lo; it != visibleEnd; ++it)
+            if (ids.empty() || ListHas(ids, it->characterId)) hits.push_back(&*it);
+        if (desc) std::reverse(hits.begin(), hits.end());
+
+        std::string out = "{\"characters_event_list\":[";
+        size_t n = 0;
+        for (size_t i = start; i < hits.size() && n < limit; ++i, ++n){
+            if (n) out += ',';
+            out += joined ? hits[i]->rawJoined : hits[i]->raw;
+        }
+        out += "],\"returned\":" + std::to_string(n) + "}";
+        return out;
+    }
+    if (target.find("/get/ps2:v2/character?") != std::string::npos && q.count("character_id")){
+        // Batched name lookup: the names the recordings' joins carried; unknown ids are left out.
+        const std::string& ids = q["character_id"];
+        std::string out = "{\"character_list\":[";
+        size_t n = 0, i = 0;
+        while (i <= ids.size()){
+            size_t c = ids.find(',', i); if (c == std::string::npos) c = ids.size();
+            auto it = g_attackerNames.find(ids.substr(i, c - i));
+            if (it != g_attackerNames.end()){
+                if (n++) out += ',';
+                out += "{\"character_id\":\"" + it->first + "\",\"name\":{\"first\":\"" + it->second + "\"}}";
+            }
+            i = c + 1;
+        }
+        return out + "],\"returned\":" + std::to_string(n) + "}";
+    }
+    if (target.find("/get/ps2:v2/character?") != std::string::npos){
+        // Each new name asked for gets the next recorded victim (in order of first appearance)
+        // and keeps it; names past the last victim are not found.
+        const std::string& names = q["name.first_lower"];
+        std::string out = "{\"character_list\":[";
+        size_t n = 0, i = 0;
+        std::lock_guard<std::mutex> lock(g_nameMu);
+        while (i <= names.size()){
+            size_t c = names.find(',', i); if (c == std::string::npos) c = names.size();
+            std::string name = names.substr(i, c - i);
+            i = c + 1;
+            auto slot = g_nameSlots.emplace(name, g_nameSlots.size()).first->second;
+            if (name.empty() || slot >= g_characterIds.size()) continue;
+            if (n++) out += ',';
+            out += "{\"character_id\":\"" + g_characterIds[slot] +
+                   "\",\"name\":{\"first\":\"" + name + "\",\"first_lower\":\"" + name + "\"}}";
+        }
+        return out + "],\"returned\":" + std::to_string(n) + "}";
+    }
+    status = 404;
+    return "{\"error\":\"No data found.\"}";
+}
+
+// ========================== Connections ==========================
+static bool SendAll(int fd, const std::string& s){
+    size_t off = 0;
+    while (off < s.size()){
+        ssize_t n = ::send(fd, s.data() + off, s.size() - off, MSG_NOSIGNAL);
+        if (n <= 0) return false;
+        off += (size_t)n;
+    }
+    return true;
+}
+
+// ========================== Event stream stand-in ==========================
+static std::string DeathMessage(const StoredEvent& e){
+    return "{\"payload\":{\"attacker_character_id\":\"" + e.attackerId +
+           "\",\"attacker_weapon_id\":\"0\",\"character_id\":\"" + e.characterId +
+           "\",\"event_name\":\"Death\",\"is_headshot\":\"" + (e.isHS ? "1" : "0") +
+           "\",\"timestamp\":\"" + std::to_string(e.ts) +
+           "\",\"world_id\":\"17\",\"zone_id\":\"2\"},\"service\":\"event\",\"type\":\"serviceMessage\"}";
+}
+
+static bool SendPaced(int fd, const std::string& s){
+    if (g_opt.kbps <= 0) return SendAll(fd, s);
+    const size_t slice = 8192;
+    for (size_t off = 0; off < s.size(); off += slice){
+        if (!SendAll(fd, s.substr(off, slice))) return false;
+        std::this_thread::sleep_for(std::chrono::microseconds((long long)slice * 1000 / g_opt.kbps));
+    }
+    return true;
+}
+
+static bool Push(int fd, const std::string& msg){ return SendAll(fd, WsEncode(WS_TEXT, msg, false)); }
+
+// Runs script steps until a disconnect step or the end. Returns false if the connection should close.
+static bool RunScript(int fd, unsigned long long conn){
+    std::lock_guard<std::mutex> lock(g_scriptMu);
+    while (g_scriptPos < g_script.size()){
+        std::string step = g_script[g_scriptPos++];
+        std::string op = step.substr(0, step.find(' '));
+        long arg = (step.find(' ') == std::string::npos) ? 0 : std::atol(step.c_str() + step.find(' ') + 1);
+        if (g_opt.verbose) std::fprintf(stderr, "[conn %llu] script: %s\n", conn, step.c_str());
+        if (op == "deliver" || op == "hidden"){
+            for (long i = 0; i < arg && g_revealed < g_events.size(); ++i){
+                const StoredEvent& e = g_events[g_revealed];
+                ++g_revealed;
+                if (op == "deliver"){
+                    g_lastPush = DeathMessage(e);
+                    if (!Push(fd, g_lastPush)) return false;
+                }
+            }
+        } else if (op == "dup"){
+            if (!g_lastPush.empty() && !Push(fd, g_lastPush)) return false;
+        } else if (op == "heartbeat"){
+            if (!Push(fd, "{\"online\":{},\"service\":\"event\",\"type\":\"heartbeat\"}")) return false;
+        } else if (op == "sleep"){
+            std::this_thread::sleep_for(std::chrono::milliseconds(arg));
+        } else if (op == "disconnect"){
+            return false;
+        }
+    }
+    Push(fd, "{\"type\":\"standinScriptDone\"}");
+    return true;
+}
+
+static void ServeStream(int fd, std::string& buf, const std::string& key, unsigned long long conn){
+    std::string resp = "HTTP/1.1 101 Switching Protocols\r\nUpgrade: websocket\r\nConnection: Upgrade\r\n"
+                       "Sec-WebSocket-Accept: " + WsAcceptKey(key) + "\r\n\r\n";
+    if (!SendAll(fd, resp)) return;
+    Push(fd, "{\"connected\":\"true\",\"service\":\"push\",\"type\":\"connectionStateChanged\"}");
+
+    // Wait for the subscribe message before pushing anything, like the real service.
+    char tmp[4096];
+    WsFrame f;
+    while (!WsDecode(buf, f)){
+        ssize_t n = ::recv(fd, tmp, sizeof(tmp), 0);
+        if (n <= 0) return;
+        buf.append(tmp, (size_t)n);
+    }
+    if (f.opcode != WS_TEXT || f.payload.find("\"subscribe\"") == std::string::npos) return;
+    Push(fd, "{\"subscription\":{\"characterCount\":1,\"eventNames\":[\"Death\"],\"worlds\":[]}}");
+
+    if (!RunScript(fd, conn)) return;
+    for(;;){
+        std::this_thread::sleep_for(std::chrono::seconds(1));
+        if (!Push(fd, "{\"online\":{},\"service\":\"event\",\"type\":\"heartbeat\"}")) return;
+    }
+}
+
+static void Serve(int fd){
+    unsigned long long conn = ++g_connections;
+    if (g_opt.connectDelayMs > 0) std::this_thread::sleep_for(std::chrono::milliseconds(g_opt.connectDelayMs));
+    std::string buf;
+    char tmp[8192];
+    int served = 0;
+    for(;;){
+        size_t end;
+        while ((end = buf.find("\r\n\r\n")) == std::string::npos){
+            ssize_t n = ::recv(fd, tmp, sizeof(tmp), 0);
+            if (n <= 0) goto done;
+            buf.append(tmp, (size_t)n);
+        }
+        std::string head = buf.substr(0, end);
+        buf.erase(0, end + 4);
+
+        size_t sp1 = head.find(' '), sp2 = head.find(' ', sp1 + 1);
+        std::string target = (sp1 == std::string::npos) ? "/" : head.substr(sp1 + 1, sp2 - sp1 - 1);
+        std::string lower = head;
+        for (auto& c : lower) c = (char)tolower((unsigned char)c);
+        bool close = lower.find("\r\nconnection: close") != std::string::npos;
+
+        size_t kp = lower.find("\r\nsec-websocket-key:");
+        if (target.compare(0, 10, "/streaming") == 0 && kp != std::string::npos){
+            size_t vb = head.find_first_not_of(' ', kp + 20), ve = head.find("\r\n", vb);
+            ServeStream(fd, buf, head.substr(vb, ve - vb), conn);
+            break;
+        }
+
+        if (g_opt.latencyMs > 0) std::this_thread::sleep_for(std::chrono::milliseconds(g_opt.latencyMs));
+        int status;
+        std::string body = Respond(target, status);
+        const size_t plain = body.size();
+        const char* coding = g_opt.encoding == ContentCoding::Gzip ? "gzip" : "deflate";
+        size_t ae = lower.find("\r\naccept-encoding:");
+        bool compress = g_opt.encoding != ContentCoding::Identity && ae != std::string::npos &&
+                        lower.substr(ae, lower.find("\r\n", ae + 2) - ae).find(coding) != std::string::npos;
+        if (compress) body = Deflate(body, g_opt.encoding);
+        std::string resp = "HTTP/1.1 " + std::to_string(status) + (status == 200 ? " OK" : " Not Found") +
+                           "\r\nContent-Type: application/json\r\nContent-Length: " + std::to_string(body.size()) +
+                           (compress ? std::string("\r\nContent-Encoding: ") + coding : std::string()) +
+                           (close ? "\r\nConnection: close" : "\r\nConnection: keep-alive") + "\r\n\r\n" + body;
+        ++g_requests; ++served;
+        if (g_opt.verbose) std::fprintf(stderr, "[conn %llu] %d %s (%zu bytes, %zu sent)\n", conn, status, target.c_str(), plain, body.size());
+        if (!SendPaced(fd, resp) || close) break;
+    }
+done:
+    if (g_opt.verbose) std::fprintf(stderr, "[conn %llu] closed after %d requests\n", conn, served);
+    ::close(fd);
+}
+
+int main(int argc, char** argv){
+    if (argc < 2){
+        std::fprintf(stderr, "usage: killfeed_standin <dir> [--port N] [--connect-delay-ms N] [--latency-ms N] [--kbps N]\n"
+                             "                        [--encoding gzip|deflate|identity] [--script FILE] [--history N] [--verbose]\n");
+        return 2;
+    }
+    for (int i = 2; i < argc; ++i){
+        if      (!std::strcmp(argv[i], "--port") && i+1 < argc)             g_opt.port = (unsigned short)std::atoi(argv[++i]);
+        else if (!std::strcmp(argv[i], "--connect-delay-ms") && i+1 < argc) g_opt.connectDelayMs = std::atoi(argv[++i]);
+        else if (!std::strcmp(argv[i], "--latency-ms") && i+1 < argc)       g_opt.latencyMs = std::atoi(argv[++i]);
+        else if (!std::strcmp(argv[i], "--kbps") && i+1 < argc)             g_opt.kbps = std::atoi(argv[++i]);
+        else if (!std::strcmp(argv[i], "--encoding") && i+1 < argc){
+            g_opt.encoding = ParseContentCoding(argv[++i]);
+            if (g_opt.encoding == ContentCoding::Unsupported){ std::fprintf(stderr, "unknown encoding %s\n", argv[i]); return 2; }
+        }
+        else if (!std::strcmp(argv[i], "--script") && i+1 < argc)           g_opt.script = argv[++i];
+        else if (!std::strcmp(argv[i], "--history") && i+1 < argc)          g_opt.history = (size_t)std::atol(argv[++i]);
+        else if (!std::strcmp(argv[i], "--verbose"))                         g_opt.verbose = true;
+        else { std::fprintf(stderr, "unknown option %s\n", argv[i]); return 2; }
+    }
+    if (!LoadDir(argv[1])){ std::fprintf(stderr, "cannot read %s\n", argv[1]); return 1; }
+    g_revealed = g_events.size();
+    if (!g_opt.script.empty()){
+        std::ifstream f(g_opt.script);
+        if (!f){ std::fprintf(stderr, "cannot read %s\n", g_opt.script.c_str()); return 1; }
+        for (std::string line; std::getline(f, line);){
+            while (!line.empty() && (line.back() == '\r' || line.back() == ' ')) line.pop_back();
+            if (!line.empty() && line[0] != '#') g_script.push_back(line);
+        }
+        g_revealed = std::min(g_opt.history, g_events.size());
+    }
+
+    int ls = ::socket(AF_INET, SOCK_STREAM, 0);
+    int one = 1; setsockopt(ls, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+    sockaddr_in addr{}; addr.sin_family = AF_INET; addr.sin_port = htons(g_opt.port);
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    if (::bind(ls, (sockaddr*)&addr, sizeof(addr)) != 0 || ::listen(ls, 64) != 0){
+        std::perror("bind/listen"); return 1;
+    }
+    std::fprintf(stderr, "standin: %zu events for %zu character(s) (first %s) on 127.0.0.1:%u\n",
+                 g_events.size(), g_characterIds.size(),
+                 g_characterIds.empty() ? "-" : g_characterIds[0].c_str(), (unsigned)g_opt.port);
+    for(;;){
+        int fd = ::accept(ls, nullptr, nullptr);
+        if (fd < 0) continue;
+        setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+        std::thread(Serve, fd).detach();
+    }
+}
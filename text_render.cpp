@@ -0,0 +1,182 @@
+// text_render.cpp — glyph atlas, built-in bitmap font and overlay text composition.
+
+#include "text_render.h"
+#include <algorithm>
+#include <cstring>
+#include <cwchar>
+
+// ========================== Built-in font ==========================
+// 0x20..0x7E, seven rows per glyph, bit 4 = leftmost of five columns.
+static const uint8_t kFont5x7[95][7] = {
+    {0x00,0x00,0x00,0x00,0x00,0x00,0x00}, {0x04,0x04,0x04,0x04,0x00,0x00,0x04}, // space !
+    {0x0A,0x0A,0x0A,0x00,0x00,0x00,0x00}, {0x0A,0x0A,0x1F,0x0A,0x1F,0x0A,0x0A}, // " #
+    {0x04,0x0F,0x14,0x0E,0x05,0x1E,0x04}, {0x18,0x19,0x02,0x04,0x08,0x13,0x03}, // $ %
+    {0x0C,0x12,0x14,0x08,0x15,0x12,0x0D}, {0x0C,0x04,0x08,0x00,0x00,0x00,0x00}, // & '
+    {0x02,0x04,0x08,0x08,0x08,0x04,0x02}, {0x08,0x04,0x02,0x02,0x02,0x04,0x08}, // ( )
+    {0x00,0x04,0x15,0x0E,0x15,0x04,0x00}, {0x00,0x04,0x04,0x1F,0x04,0x04,0x00}, // * +
+    {0x00,0x00,0x00,0x00,0x0C,0x04,0x08}, {0x00,0x00,0x00,0x1F,0x00,0x00,0x00}, // , -
+    {0x00,0x00,0x00,0x00,0x00,0x0C,0x0C}, {0x00,0x01,0x02,0x04,0x08,0x10,0x00}, // . /
+    {0x0E,0x11,0x13,0x15,0x19,0x11,0x0E}, {0x04,0x0C,0x04,0x04,0x04,0x04,0x0E}, // 0 1
+    {0x0E,0x11,0x01,0x02,0x04,0x08,0x1F}, {0x1F,0x02,0x04,0x02,0x01,0x11,0x0E}, // 2 3
+    {0x02,0x06,0x0A,0x12,0x1F,0x02,0x02}, {0x1F,0x10,0x1E,0x01,0x01,0x11,0x0E}, // 4 5
+    {0x06,0x08,0x10,0x1E,0x11,0x11,0x0E}, {0x1F,0x01,0x02,0x04,0x08,0x08,0x08}, // 6 7
+    {0x0E,0x11,0x11,0x0E,0x11,0x11,0x0E}, {0x0E,0x11,0x11,0x0F,0x01,0x02,0x0C}, // 8 9
+    {0x00,0x0C,0x0C,0x00,0x0C,0x0C,0x00}, {0x00,0x0C,0x0C,0x00,0x0C,0x04,0x08}, // : ;
+    {0x02,0x04,0x08,0x10,0x08,0x04,0x02}, {0x00,0x00,0x1F,0x00,0x1F,0x00,0x00}, // < =
+    {0x08,0x04,0x02,0x01,0x02,0x04,0x08}, {0x0E,0x11,0x01,0x02,0x04,0x00,0x04}, // > ?
+    {0x0E,0x11,0x01,0x0D,0x15,0x15,0x0E}, {0x0E,0x11,0x11,0x11,0x1F,0x11,0x11}, // @ A
+    {0x1E,0x11,0x11,0x1E,0x11,0x11,0x1E}, {0x0E,0x11,0x10,0x10,0x10,0x11,0x0E}, // B C
+    {0x1C,0x12,0x11,0x11,0x11,0x12,0x1C}, {0x1F,0x10,0x10,0x1E,0x10,0x10,0x1F}, // D E
+    {0x1F,0x10,0x10,0x1E,0x10,0x10,0x10}, {0x0E,0x11,0x10,0x17,0x11,0x11,0x0F}, // F G
+    {0x11,0x11,0x11,0x1F,0x11,0x11,0x11}, {0x0E,0x04,0x04,0x04,0x04,0x04,0x0E}, // H I
+    {0x07,0x02,0x02,0x02,0x02,0x12,0x0C}, {0x11,0x12,0x14,0x18,0x14,0x12,0x11}, // J K
+    {0x10,0x10,0x10,0x10,0x10,0x10,0x1F}, {0x11,0x1B,0x15,0x15,0x11,0x11,0x11}, // L M
+    {0x11,0x11,0x19,0x15,0x13,0x11,0x11}, {0x0E,0x11,0x11,0x11,0x11,0x11,0x0E}, // N O
+    {0x1E,0x11,0x11,0x1E,0x10,0x10,0x10}, {0x0E,0x11,0x11,0x11,0x15,0x12,0x0D}, // P Q
+    {0x1E,0x11,0x11,0x1E,0x14,0x12,0x11}, {0x0F,0x10,0x10,0x0E,0x01,0x01,0x1E}, // R S
+    {0x1F,0x04,0x04,0x04,0x04,0x04,0x04}, {0x11,0x11,0x11,0x11,0x11,0x11,0x0E}, // T U
+    {0x11,0x11,0x11,0x11,0x11,0x0A,0x04}, {0x11,0x11,0x11,0x15,0x15,0x15,0x0A}, // V W
+    {0x11,0x11,0x0A,0x04,0x0A,0x11,0x11}, {0x11,0x11,0x11,0x0A,0x04,0x04,0x04}, // X Y
+    {0x1F,0x01,0x02,0x04,0x08,0x10,0x1F}, {0x0E,0x08,0x08,0x08,0x08,0x08,0x0E}, // Z [
+    {0x00,0x10,0x08,0x04,0x02,0x01,0x00}, {0x0E,0x02,0x02,0x02,0x02,0x02,0x0E}, // \ ]
+    {0x04,0x0A,0x11,0x00,0x00,0x00,0x00}, {0x00,0x00,0x00,0x00,0x00,0x00,0x1F}, // ^ _
+    {0x08,0x04,0x02,0x00,0x00,0x00,0x00}, {0x00,0x00,0x0E,0x01,0x0F,0x11,0x0F}, // ` a
+    {0x10,0x10,0x16,0x19,0x11,0x11,0x1E}, {0x00,0x00,0x0E,0x10,0x10,0x11,0x0E}, // b c
+    {0x01,0x01,0x0D,0x13,0x11,0x11,0x0F}, {0x00,0x00,0x0E,0x11,0x1F,0x10,0x0E}, // d e
+    {0x06,0x09,0x08,0x1C,0x08,0x08,0x08}, {0x00,0x0F,0x11,0x11,0x0F,0x01,0x0E}, // f g
+    {0x10,0x10,0x16,0x19,0x11,0x11,0x11}, {0x04,0x00,0x0C,0x04,0x04,0x04,0x0E}, // h i
+    {0x02,0x00,0x06,0x02,0x02,0x12,0x0C}, {0x10,0x10,0x12,0x14,0x18,0x14,0x12}, // j k
+    {0x0C,0x04,0x04,0x04,0x04,0x04,0x0E}, {0x00,0x00,0x1A,0x15,0x15,0x11,0x11}, // l m
+    {0x00,0x00,0x16,0x19,0x11,0x11,0x11}, {0x00,0x00,0x0E,0x11,0x11,0x11,0x0E}, // n o
+    {0x00,0x00,0x1E,0x11,0x1E,0x10,0x10}, {0x00,0x00,0x0D,0x13,0x0F,0x01,0x01}, // p q
+    {0x00,0x00,0x16,0x19,0x10,0x10,0x10}, {0x00,0x00,0x0E,0x10,0x0E,0x01,0x1E}, // r s
+    {0x08,0x08,0x1C,0x08,0x08,0x09,0x06}, {0x00,0x00,0x11,0x11,0x11,0x13,0x0D}, // t u
+    {0x00,0x00,0x11,0x11,0x11,0x0A,0x04}, {0x00,0x00,0x11,0x11,0x15,0x15,0x0A}, // v w
+    {0x00,0x00,0x11,0x0A,0x04,0x0A,0x11}, {0x00,0x00,0x11,0x11,0x0F,0x01,0x0E}, // x y
+    {0x00,0x00,0x1F,0x02,0x04,0x08,0x1F}, {0x02,0x04,0x04,0x08,0x04,0x04,0x02}, // z {
+    {0x04,0x04,0x04,0x04,0x04,0x04,0x04}, {0x08,0x04,0x04,0x02,0x04,0x04,0x08}, // | }
+    {0x00,0x00,0x08,0x15,0x02,0x00,0x00},                                       // ~
+};
+
+// A cell is 6x9 units: 5x7 glyph, one column and two rows of spacing.
+BuiltinGlyphSource::BuiltinGlyphSource(int pixelHeight) : scale_(std::max(1, (pixelHeight + 4) / 9)) {}
+
+FontMetrics BuiltinGlyphSource::Metrics(){ return {7 * scale_, 9 * scale_}; }
+
+bool BuiltinGlyphSource::Rasterize(uint32_t ch, GlyphBitmap& out){
+    if (ch < 0x20 || ch > 0x7E) ch = '?';
+    const uint8_t* rows = kFont5x7[ch - 0x20];
+    const int s = scale_;
+    out.advance = 6 * s;
+    out.left = 0;
+    out.top  = 7 * s;
+    if (ch == ' '){ out.w = out.h = 0; out.coverage.clear(); return true; }
+    out.w = 5 * s; out.h = 7 * s;
+    out.coverage.assign((size_t)out.w * out.h, 0);
+    for (int y = 0; y < out.h; ++y)
+        for (int x = 0; x < out.w; ++x)
+            if (rows[y / s] & (0x10 >> (x / s))) out.coverage[(size_t)y * out.w + x] = 255;
+    return true;
+}
+
+int TextPixelHeight(int windowSize){
+    if (windowSize <= 0) return 0;
+    return 6 + 2 * std::min(windowSize, 40);
+}
+
+// ========================== Atlas ==========================
+void GlyphAtlas::Reset(GlyphSource* src){
+    src_ = src;
+    metrics_ = src ? src->Metrics() : FontMetrics{};
+    glyphs_.clear();
+    pixels_.clear();
+    width_ = std::max(256, metrics_.height * 16);
+    shelfX_ = shelfY_ = shelfH_ = 0;
+}
+
+// Shelf packing: glyphs go left to right on the current shelf, a new shelf starts below the
+// tallest glyph of the previous one. The atlas only grows downwards, so placed glyphs never move.
+bool GlyphAtlas::Place(int w, int h, int& x, int& y){
+    if (w > width_ || h > 0xFFFF) return false;
+    if (shelfX_ + w > width_){ shelfY_ += shelfH_; shelfX_ = 0; shelfH_ = 0; }
+    if (shelfY_ + h > 0xFFFF) return false;
+    x = shelfX_; y = shelfY_;
+    shelfX_ += w;
+    shelfH_ = std::max(shelfH_, h);
+    size_t need = (size_t)(shelfY_ + shelfH_) * width_;
+    if (pixels_.size() < need) pixels_.resize(std::max(need, pixels_.size() * 2), 0);
+    return true;
+}
+
+const AtlasGlyph& GlyphAtlas::Glyph(uint32_t ch){
+    bool inserted = false;
+    AtlasGlyph& g = glyphs_.Upsert(ch, &inserted);
+    if (!inserted || !src_) return g;
+
+    ++rasterized;
+    GlyphBitmap& b = scratch_;
+    b = GlyphBitmap{};
+    if (!src_->Rasterize(ch, b)) return g;
+    g.left = (int16_t)b.left; g.top = (int16_t)b.top; g.advance = (int16_t)b.advance;
+    int x = 0, y = 0;
+    if (b.w <= 0 || b.h <= 0 || !Place(b.w, b.h, x, y)) return g;
+    for (int row = 0; row < b.h; ++row)
+        std::memcpy(&pixels_[(size_t)(y + row) * width_ + x], &b.coverage[(size_t)row * b.w], (size_t)b.w);
+    g.x = (uint16_t)x; g.y = (uint16_t)y; g.w = (uint16_t)b.w; g.h = (uint16_t)b.h;
+    return g;
+}
+
+int GlyphAtlas::DrawRun(const wchar_t* s, size_t n, int x, int top, int right, int bottom,
+                        uint32_t* px, int W, int H){
+    const int clipL = std::max(0, x), clipR = std::min(right, W);
+    const int clipT = std::max(0, top), clipB = std::min(bottom, H);
+    const int baseline = top + metrics_.ascent;
+    for (size_t i = 0; i < n && x < clipR; ++i){
+        const AtlasGlyph& g = Glyph((uint32_t)s[i]);
+        const int gx = x + g.left, gy = baseline - g.top;
+        const int x0 = std::max(gx, clipL), x1 = std::min(gx + (int)g.w, clipR);
+        const int y0 = std::max(gy, clipT), y1 = std::min(gy + (int)g.h, clipB);
+        for (int y = y0; y < y1; ++y){
+            const uint8_t* src = &pixels_[(size_t)(g.y + y - gy) * width_ + g.x + (x0 - gx)];
+            uint32_t* dst = px + (size_t)y * W;
+            for (int xx = x0; xx < x1; ++xx, ++src){
+                uint32_t c = *src;
+                if (c > (dst[xx] & 0xFF)) dst[xx] = c * 0x010101u;  // overlapping glyphs: keep the max
+            }
+        }
+        x += g.advance;
+    }
+    return x;
+}
+
+// ========================== Overlay layout ==========================
+void ComposeOverlayText(GlyphAtlas& atlas, const DisplaySnapshot& snap, uint32_t* px, int W, int H,
+                        int left, int top, int right, int lineH){
+    // The HUD line, when on, keeps the bottom line for itself.
+    const int bottom = snap.hud.empty() ? H : H - lineH;
+    if (!snap.hud.empty()) atlas.DrawRun(snap.hud.c_str(), snap.hud.size(), left, bottom, right, H, px, W, H);
+
+    int y = top;
+    atlas.DrawRun(snap.status.c_str(), snap.status.size(), left, y, right, std::min(y + lineH, bottom), px, W, H);
+    y += lineH + 2;
+
+    wchar_t buf[256];
+    auto block = [&](const std::wstring& line, const std::vector<DisplayRow>& rows){
+        atlas.DrawRun(line.c_str(), line.size(), left, y, right, std::min(y + lineH, bottom), px, W, H);
+        y += lineH + 6;
+        for (size_t i = 0; i < rows.size() && y < bottom; ++i){
+            const DisplayRow& e = rows[i];
+            int n = swprintf(buf, sizeof(buf)/sizeof(buf[0]), L"%d) %ls  %d/%d",
+                             (int)i + 1, e.name.c_str(), e.cnt.hs, e.cnt.tot);
+            if (n < 0) n = (int)wcslen(buf);
+            atlas.DrawRun(buf, (size_t)n, left, y, right, std::min(y + lineH, bottom), px, W, H);
+            y += lineH;
+        }
+    };
+    block(snap.line, snap.rows);
+    for (const DisplayBlock& b : snap.squad){
+        if (y >= bottom) break;
+        y += 6;
+        block(b.line, b.rows);
+    }
+}
@@ -0,0 +1,86 @@
+// text_render.h — overlay text composed from a glyph atlas instead of GDI DrawTextW per frame.
+// A GlyphSource rasterizes one glyph to 8-bit coverage. GlyphAtlas asks it once per character,
+// packs the result into one coverage bitmap and from then on only blits out of it. Blits write
+// white-on-black into the BGRA backbuffer, the same thing DrawTextW produced, so the tint pass
+// (TintWhiteToPremultiplied) runs unchanged afterwards.
+// No Windows code here: main.cpp plugs in a GDI GlyphSource, Linux tools use the built-in font.
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "flat_table.h"
+#include "killfeed_core.h"
+
+struct FontMetrics { int ascent = 0, height = 0; };
+
+struct GlyphBitmap {
+    int w = 0, h = 0;           // coverage size; 0x0 for blanks
+    int left = 0, top = 0;      // offset of the bitmap from the pen: x right, y up from the baseline
+    int advance = 0;
+    std::vector<uint8_t> coverage;  // w*h, 0..255
+};
+
+class GlyphSource {
+public:
+    virtual ~GlyphSource() = default;
+    virtual FontMetrics Metrics() = 0;
+    // false: no glyph for ch (the atlas then draws nothing and does not advance).
+    virtual bool Rasterize(uint32_t ch, GlyphBitmap& out) = 0;
+};
+
+// 5x7 ASCII cell font scaled by whole pixels. Anything outside 0x20..0x7E draws as '?'.
+class BuiltinGlyphSource : public GlyphSource {
+public:
+    explicit BuiltinGlyphSource(int pixelHeight);
+    FontMetrics Metrics() override;
+    bool Rasterize(uint32_t ch, GlyphBitmap& out) override;
+private:
+    int scale_ = 1;
+};
+
+// "window_size" from config.json -> font cell height in pixels; 0 means the stock GUI font.
+int TextPixelHeight(int windowSize);
+
+struct AtlasGlyph {
+    uint16_t x = 0, y = 0, w = 0, h = 0;  // rectangle in the atlas
+    int16_t  left = 0, top = 0, advance = 0;
+};
+
+class GlyphAtlas {
+public:
+    // New font (or first use): forget every glyph, read the metrics of src.
+    void Reset(GlyphSource* src);
+
+    int Ascent() const { return metrics_.ascent; }
+    int Height() const { return metrics_.height; }
+
+    // Cached glyph for ch, rasterized and packed on first use.
+    const AtlasGlyph& Glyph(uint32_t ch);
+
+    // Draws n UTF-16 units with the cell's top-left at (x, top), clipped to [x, right) x [top, bottom)
+    // and to the W x H surface. Returns the pen x after the run.
+    int DrawRun(const wchar_t* s, size_t n, int x, int top, int right, int bottom,
+                uint32_t* px, int W, int H);
+
+    size_t   Glyphs() const { return glyphs_.size(); }
+    size_t   AtlasBytes() const { return pixels_.size(); }
+    uint64_t rasterized = 0;   // GlyphSource calls, lifetime; flat once the text has been seen
+
+private:
+    bool Place(int w, int h, int& x, int& y);
+
+    GlyphSource* src_ = nullptr;
+    FontMetrics  metrics_;
+    FlatTable<uint64_t, AtlasGlyph> glyphs_;
+    std::vector<uint8_t> pixels_;        // width_ columns, grows downwards
+    int width_ = 0;
+    int shelfX_ = 0, shelfY_ = 0, shelfH_ = 0;
+    GlyphBitmap scratch_;
+};
+
+// Status, "Killed by" line and the nemesis rows (then the same for each further squad member) at
+// the positions DrawOverlayText uses, composed into a cleared W x H BGRA surface. snap.hud, if set,
+// goes on the bottom line and the rest is clipped above it.
+void ComposeOverlayText(GlyphAtlas& atlas, const DisplaySnapshot& snap, uint32_t* px, int W, int H,
+                        int left, int top, int right, int lineH);
@@ -0,0 +1,112 @@
+// ws_codec.h — minimal RFC 6455 pieces shared by the socket WebSocket client and the stand-in:
+// handshake accept key (SHA-1 + base64), frame encoding and incremental frame decoding.
+#pragma once
+
+#include <string>
+#include <cstdint>
+#include <cstring>
+
+enum WsOpcode : uint8_t { WS_CONT = 0x0, WS_TEXT = 0x1, WS_BINARY = 0x2, WS_CLOSE = 0x8, WS_PING = 0x9, WS_PONG = 0xA };
+
+struct WsFrame {
+    bool        fin = true;
+    uint8_t     opcode = WS_TEXT;
+    std::string payload;
+};
+
+inline void Sha1(const std::string& in, uint8_t out[20]){
+    uint32_t h[5] = {0x67452301u, 0xEFCDAB89u, 0x98BADCFEu, 0x10325476u, 0xC3D2E1F0u};
+    std::string m = in;
+    uint64_t bits = (uint64_t)in.size() * 8;
+    m.push_back((char)0x80);
+    while (m.size() % 64 != 56) m.push_back('\0');
+    for (int i = 7; i >= 0; --i) m.push_back((char)(bits >> (i*8)));
+    auto rol = [](uint32_t v, int n){ return (v << n) | (v >> (32 - n)); };
+    for (size_t blk = 0; blk < m.size(); blk += 64){
+        uint32_t w[80];
+        for (int i = 0; i < 16; ++i){
+            const unsigned char* p = (const unsigned char*)m.data() + blk + i*4;
+            w[i] = ((uint32_t)p[0]<<24)|((uint32_t)p[1]<<16)|((uint32_t)p[2]<<8)|p[3];
+        }
+        for (int i = 16; i < 80; ++i) w[i] = rol(w[i-3]^w[i-8]^w[i-14]^w[i-16], 1);
+        uint32_t a=h[0], b=h[1], c=h[2], d=h[3], e=h[4];
+        for (int i = 0; i < 80; ++i){
+            uint32_t f, k;
+            if (i < 20)      { f = (b & c) | (~b & d);          k = 0x5A827999u; }
+            else if (i < 40) { f = b ^ c ^ d;                   k = 0x6ED9EBA1u; }
+            else if (i < 60) { f = (b & c) | (b & d) | (c & d); k = 0x8F1BBCDCu; }
+            else             { f = b ^ c ^ d;                   k = 0xCA62C1D6u; }
+            uint32_t t = rol(a, 5) + f + e + k + w[i];
+            e = d; d = c; c = rol(b, 30); b = a; a = t;
+        }
+        h[0]+=a; h[1]+=b; h[2]+=c; h[3]+=d; h[4]+=e;
+    }
+    for (int i = 0; i < 5; ++i){
+        out[i*4]   = (uint8_t)(h[i] >> 24); out[i*4+1] = (uint8_t)(h[i] >> 16);
+        out[i*4+2] = (uint8_t)(h[i] >> 8);  out[i*4+3] = (uint8_t)h[i];
+    }
+}
+
+inline std::string Base64(const uint8_t* p, size_t n){
+    static const char* T = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+    std::string o;
+    for (size_t i = 0; i < n; i += 3){
+        uint32_t v = (uint32_t)p[i] << 16;
+        if (i+1 < n) v |= (uint32_t)p[i+1] << 8;
+        if (i+2 < n) v |= p[i+2];
+        o.push_back(T[(v >> 18) & 63]);
+        o.push_back(T[(v >> 12) & 63]);
+        o.push_back(i+1 < n ? T[(v >> 6) & 63] : '=');
+        o.push_back(i+2 < n ? T[v & 63] : '=');
+    }
+    return o;
+}
+
+// Sec-WebSocket-Accept for a given Sec-WebSocket-Key.
+inline std::string WsAcceptKey(const std::string& key){
+    uint8_t d[20];
+    Sha1(key + "258EAFA5-E914-47CA-95CA-C5AB0DC11B65", d);
+    return Base64(d, 20);
+}
+
+// Encodes one frame. Clients must mask (RFC 6455 5.3); servers must not.
+inline std::string WsEncode(uint8_t opcode, const std::string& payload, bool mask, uint32_t maskKey = 0x5A3C9E71u){
+    std::string f;
+    f.push_back((char)(0x80 | opcode));
+    uint8_t mbit = mask ? 0x80 : 0;
+    size_t n = payload.size();
+    if (n < 126) f.push_back((char)(mbit | n));
+    else if (n < 65536){ f.push_back((char)(mbit | 126)); f.push_back((char)(n >> 8)); f.push_back((char)n); }
+    else { f.push_back((char)(mbit | 127)); for (int i = 7; i >= 0; --i) f.push_back((char)((uint64_t)n >> (i*8))); }
+    if (!mask){ f += payload; return f; }
+    uint8_t k[4] = {(uint8_t)(maskKey>>24), (uint8_t)(maskKey>>16), (uint8_t)(maskKey>>8), (uint8_t)maskKey};
+    f.append((const char*)k, 4);
+    size_t at = f.size();
+    f += payload;
+    for (size_t i = 0; i < n; ++i) f[at+i] = (char)(f[at+i] ^ k[i & 3]);
+    return f;
+}
+
+// Pops one complete frame from the front of buf (unmasking if needed). False if incomplete.
+inline bool WsDecode(std::string& buf, WsFrame& out){
+    if (buf.size() < 2) return false;
+    const unsigned char* p = (const unsigned char*)buf.data();
+    bool masked = (p[1] & 0x80) != 0;
+    uint64_t n = p[1] & 0x7F;
+    size_t hdr = 2;
+    if (n == 126){ if (buf.size() < 4) return false; n = ((uint64_t)p[2] << 8) | p[3]; hdr = 4; }
+    else if (n == 127){
+        if (buf.size() < 10) return false;
+        n = 0; for (int i = 0; i < 8; ++i) n = (n << 8) | p[2+i];
+        hdr = 10;
+    }
+    size_t maskAt = hdr;
+    if (masked) hdr += 4;
+    if (buf.size() < hdr + n) return false;
+    out.fin    = (p[0] & 0x80) != 0;
+    out.opcode = p[0] & 0x0F;
+    out.payload.assign(buf, hdr, (size_t)n);
+    if (masked) for (size_t i = 0; i < n; ++i) out.payload[i] = (char)(out.payload[i] ^ p[maskAt + (i & 3)]);
+    buf.erase(0, hdr + (size_t)n);
+    return true;
+}
@@ -0,0 +1,137 @@
+// ws_socket.cpp — POSIX ws:// client behind StreamTransport (Linux tools only, no TLS).
+
+#ifndef _WIN32
+
+#include "event_stream.h"
+#include "ws_codec.h"
+#include <atomic>
+#include <cctype>
+#include <cerrno>
+#include <cstring>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+namespace {
+
+class SocketStream : public StreamTransport {
+public:
+    SocketStream(std::string host, unsigned short port) : host_(std::move(host)), port_(port) {}
+    ~SocketStream() override { Close(); }
+
+    bool Connect(const std::wstring& path, std::wstring& err) override {
+        Close();
+        addrinfo hints{}; hints.ai_family = AF_UNSPEC; hints.ai_socktype = SOCK_STREAM;
+        addrinfo* res = nullptr;
+        std::string port = std::to_string(port_);
+        if (getaddrinfo(host_.c_str(), port.c_str(), &hints, &res) != 0 || !res){ err = L"resolve failed"; return false; }
+        for (addrinfo* a = res; a; a = a->ai_next){
+            int fd = ::socket(a->ai_family, a->ai_socktype, a->ai_protocol);
+            if (fd < 0) continue;
+            if (::connect(fd, a->ai_addr, a->ai_addrlen) == 0){ fd_ = fd; break; }
+            ::close(fd);
+        }
+        freeaddrinfo(res);
+        if (fd_ < 0){ err = L"connect failed"; return false; }
+        int one = 1; setsockopt(fd_, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+
+        const std::string key = "a2lsbGZlZWQtb3ZlcmxheQ==";
+        std::string req = "GET " + WideToUtf8(path) + " HTTP/1.1\r\nHost: " + host_ +
+                          "\r\nUpgrade: websocket\r\nConnection: Upgrade\r\nSec-WebSocket-Key: " + key +
+                          "\r\nSec-WebSocket-Version: 13\r\n\r\n";
+        if (!SendRaw(req)){ err = L"handshake send failed"; Close(); return false; }
+
+        size_t end;
+        while ((end = buf_.find("\r\n\r\n")) == std::string::npos){
+            if (!Fill(5000)){ err = L"handshake timed out"; Close(); return false; }
+        }
+        std::string head = buf_.substr(0, end);
+        buf_.erase(0, end + 4);
+        std::string lower = head;
+        for (auto& c : lower) c = (char)tolower((unsigned char)c);
+        if (head.compare(0, 12, "HTTP/1.1 101") != 0 ||
+            lower.find("sec-websocket-accept: " + ToLower(WsAcceptKey(key))) == std::string::npos){
+            err = L"handshake rejected"; Close(); return false;
+        }
+        return true;
+    }
+
+    bool Send(const std::string& text) override {
+        return fd_ >= 0 && SendRaw(WsEncode(WS_TEXT, text, true));
+    }
+
+    int Receive(std::string& msg, int timeoutMs) override {
+        if (fd_ < 0) return -1;
+        for(;;){
+            WsFrame f;
+            while (WsDecode(buf_, f)){
+                switch (f.opcode){
+                    case WS_PING:  SendRaw(WsEncode(WS_PONG, f.payload, true)); break;
+                    case WS_PONG:  break;
+                    case WS_CLOSE: Close(); return -1;
+                    default:
+                        partial_ += f.payload;
+                        if (f.fin){ msg.swap(partial_); partial_.clear(); return 1; }
+                }
+            }
+            if (fd_ < 0) return -1;
+            pollfd p{fd_, POLLIN, 0};
+            int r = ::poll(&p, 1, timeoutMs);
+            if (r == 0) return 0;
+            if (r < 0 && errno == EINTR) continue;
+            if (r < 0 || !Fill(0)){ Close(); return -1; }
+        }
+    }
+
+    void Abort() override {
+        int fd = fd_.load();
+        if (fd >= 0) ::shutdown(fd, SHUT_RDWR);
+    }
+
+    void Close() override {
+        int fd = fd_.exchange(-1);
+        if (fd >= 0) ::close(fd);
+        buf_.clear(); partial_.clear();
+    }
+
+private:
+    static std::string ToLower(std::string s){ for (auto& c : s) c = (char)tolower((unsigned char)c); return s; }
+
+    bool SendRaw(const std::string& s){
+        size_t off = 0;
+        while (off < s.size()){
+            ssize_t n = ::send(fd_, s.data() + off, s.size() - off, MSG_NOSIGNAL);
+            if (n <= 0){ if (n < 0 && errno == EINTR) continue; return false; }
+            off += (size_t)n;
+        }
+        return true;
+    }
+
+    bool Fill(int timeoutMs){
+        if (timeoutMs > 0){
+            pollfd p{fd_, POLLIN, 0};
+            if (::poll(&p, 1, timeoutMs) <= 0) return false;
+        }
+        char tmp[16384];
+        ssize_t n = ::recv(fd_, tmp, sizeof(tmp), 0);
+        if (n <= 0) return false;
+        buf_.append(tmp, (size_t)n);
+        return true;
+    }
+
+    std::string    host_;
+    unsigned short port_;
+    std::atomic<int> fd_{-1};
+    std::string    buf_, partial_;
+};
+
+} // namespace
+
+std::unique_ptr<StreamTransport> MakeSocketStream(const std::string& host, unsigned short port){
+    return std::make_unique<SocketStream>(host, port);
+}
+
+#endif
@@ -0,0 +1,137 @@
+// ws_winhttp.cpp — WinHTTP WebSocket client behind StreamTransport (wss://, Windows 8+).
+// Kept out of main.cpp because <winhttp.h> and <wininet.h> do not mix in one translation unit.
+
+#ifdef _WIN32
+
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#include <winhttp.h>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include "event_stream.h"
+
+namespace {
+
+class WinHttpStream : public StreamTransport {
+public:
+    WinHttpStream(std::wstring host, unsigned short port) : host_(std::move(host)), port_(port) {}
+    ~WinHttpStream() override { Close(); }
+
+    bool Connect(const std::wstring& path, std::wstring& err) override {
+        Close();
+        hSession_ = WinHttpOpen(L"PS2Overlay/1.0", WINHTTP_ACCESS_TYPE_DEFAULT_PROXY,
+                                WINHTTP_NO_PROXY_NAME, WINHTTP_NO_PROXY_BYPASS, 0);
+        if (!hSession_){ err = L"WinHttpOpen failed"; return false; }
+        hConnect_ = WinHttpConnect(hSession_, host_.c_str(), port_, 0);
+        if (!hConnect_){ err = L"WinHttpConnect failed"; Close(); return false; }
+
+        HINTERNET hReq = WinHttpOpenRequest(hConnect_, L"GET", path.c_str(), nullptr, WINHTTP_NO_REFERER,
+                                            WINHTTP_DEFAULT_ACCEPT_TYPES, WINHTTP_FLAG_SECURE);
+        if (!hReq){ err = L"WinHttpOpenRequest failed"; Close(); return false; }
+        // Carried over to the WebSocket: the reader's receive gives up on a silent, half-open
+        // connection after this long, so Close never waits on it for longer.
+        DWORD readerTimeoutMs = kReaderTimeoutMs;
+        bool ok = WinHttpSetOption(hReq, WINHTTP_OPTION_RECEIVE_TIMEOUT, &readerTimeoutMs, sizeof(readerTimeoutMs)) &&
+                  WinHttpSetOption(hReq, WINHTTP_OPTION_UPGRADE_TO_WEB_SOCKET, nullptr, 0) &&
+                  WinHttpSendRequest(hReq, WINHTTP_NO_ADDITIONAL_HEADERS, 0, WINHTTP_NO_REQUEST_DATA, 0, 0, 0) &&
+                  WinHttpReceiveResponse(hReq, nullptr);
+        HINTERNET ws = ok ? WinHttpWebSocketCompleteUpgrade(hReq, 0) : nullptr;
+        WinHttpCloseHandle(hReq);
+        if (!ws){ err = L"WebSocket upgrade failed"; Close(); return false; }
+        { std::lock_guard<std::mutex> lock(mu_); hWs_ = ws; inbox_.clear(); gone_ = false; }
+        reader_ = std::thread([this, ws]{ ReadLoop(ws); });
+        return true;
+    }
+
+    bool Send(const std::string& text) override {
+        HINTERNET ws = hWs_;
+        return ws && WinHttpWebSocketSend(ws, WINHTTP_WEB_SOCKET_UTF8_MESSAGE_BUFFER_TYPE,
+                                          (PVOID)text.data(), (DWORD)text.size()) == NO_ERROR;
+    }
+
+    // WinHTTP has no per-call receive timeout that leaves the socket usable, so a reader thread
+    // sits in the blocking receive and hands whole messages over; this waits up to timeoutMs for
+    // one and returns 0 when none came, so a silent half-open socket still trips the stall limit.
+    int Receive(std::string& msg, int timeoutMs) override {
+        std::unique_lock<std::mutex> lock(mu_);
+        auto ready = [&]{ return !inbox_.empty() || gone_; };
+        if (timeoutMs < 0) cv_.wait(lock, ready);
+        else if (!cv_.wait_for(lock, std::chrono::milliseconds(timeoutMs), ready)) return 0;
+        if (inbox_.empty()) return -1;
+        msg.swap(inbox_.front());
+        inbox_.pop_front();
+        return 1;
+    }
+
+    // Only sends the close frame (the handle stays the reader's until Close has joined it); a
+    // blocked Receive returns -1 straight away.
+    void Abort() override {
+        std::lock_guard<std::mutex> lock(mu_);
+        if (hWs_) WinHttpWebSocketShutdown(hWs_, WINHTTP_WEB_SOCKET_SUCCESS_CLOSE_STATUS, nullptr, 0);
+        gone_ = true;
+        cv_.notify_all();
+    }
+
+    // The server's answer to the close frame ends the reader's receive (the receive timeout, if the
+    // server is gone); the handle is closed once nothing can be using it.
+    void Close() override {
+        if (reader_.joinable()){
+            {
+                std::lock_guard<std::mutex> lock(mu_);
+                if (!gone_) WinHttpWebSocketShutdown(hWs_, WINHTTP_WEB_SOCKET_SUCCESS_CLOSE_STATUS, nullptr, 0);
+            }
+            reader_.join();
+        }
+        HINTERNET ws;
+        { std::lock_guard<std::mutex> lock(mu_); ws = hWs_; hWs_ = nullptr; }
+        if (ws) WinHttpCloseHandle(ws);
+        if (hConnect_){ WinHttpCloseHandle(hConnect_); hConnect_ = nullptr; }
+        if (hSession_){ WinHttpCloseHandle(hSession_); hSession_ = nullptr; }
+    }
+
+private:
+    static const DWORD kReaderTimeoutMs = 120000;   // past KillfeedStream's 90 s stall limit
+
+    void ReadLoop(HINTERNET ws){
+        std::string msg;
+        char buf[8192];
+        for(;;){
+            DWORD got = 0;
+            WINHTTP_WEB_SOCKET_BUFFER_TYPE type;
+            if (WinHttpWebSocketReceive(ws, buf, sizeof(buf), &got, &type) != NO_ERROR) break;
+            if (type == WINHTTP_WEB_SOCKET_UTF8_FRAGMENT_BUFFER_TYPE || type == WINHTTP_WEB_SOCKET_BINARY_FRAGMENT_BUFFER_TYPE){
+                msg.append(buf, got);
+                continue;
+            }
+            if (type != WINHTTP_WEB_SOCKET_UTF8_MESSAGE_BUFFER_TYPE && type != WINHTTP_WEB_SOCKET_BINARY_MESSAGE_BUFFER_TYPE) break;   // close frame
+            msg.append(buf, got);
+            { std::lock_guard<std::mutex> lock(mu_); inbox_.push_back(std::move(msg)); }
+            msg.clear();
+            cv_.notify_all();
+        }
+        { std::lock_guard<std::mutex> lock(mu_); gone_ = true; }
+        cv_.notify_all();
+    }
+
+    std::wstring   host_;
+    unsigned short port_;
+    HINTERNET      hSession_ = nullptr;
+    HINTERNET      hConnect_ = nullptr;
+    HINTERNET      hWs_      = nullptr;   // set and closed by the owner under mu_, read by Abort
+    std::thread    reader_;            // one per connection, joined by Close
+    std::mutex     mu_;
+    std::condition_variable cv_;
+    std::deque<std::string> inbox_;    // whole messages the reader got, oldest first
+    bool           gone_ = false;      // the reader stopped: closed, failed or aborted
+};
+
+} // namespace
+
+std::unique_ptr<StreamTransport> MakeWinHttpStream(const std::wstring& host, unsigned short port){
+    return std::make_unique<WinHttpStream>(host, port);
+}
+
+#endif